@@ -1,6 +1,9 @@
 #include "AllegroHandler.h"
 #include "constants.h"
 #include "common.h"
+#include "Input.h"
+#include "SpriteCache.h"
+#include "view.h"
 
 #include <allegro5/allegro5.h>
 #include <allegro5/allegro_audio.h>
@@ -10,6 +13,8 @@
 #include <allegro5/allegro_native_dialog.h>
 //#include <allegro5/allegro_image.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <string_view>
 #include <cstdlib>
@@ -26,11 +31,6 @@ AllegroHandler::AllegroHandler()
 	assertInitialized(al_init_native_dialog_addon(), "Allegro dialong addon");
 	//assertInitialized(al_init_image_addon(), "Allegro image addon");
 
-	// set up allegro display antialiasing
-	al_set_new_display_option(ALLEGRO_SAMPLE_BUFFERS, 1, ALLEGRO_SUGGEST); // use multisampling
-	al_set_new_display_option(ALLEGRO_SAMPLES, 8, ALLEGRO_SUGGEST);
-	al_set_new_bitmap_flags(ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR);
-
 	// create crucial variables
 	m_timer = al_create_timer(consts::frameTime);
 	m_eventQueue = al_create_event_queue();
@@ -139,17 +139,103 @@ void AllegroHandler::createDisplay()
 {
 	if (!m_display)
 	{
+		// as much of the monitor as windowMonitorShare allows, but never smaller than the world
+		double windowScale{ 1.0 };
+		ALLEGRO_MONITOR_INFO monitor{};
+		if (al_get_monitor_info(0, &monitor))
+		{
+			windowScale = std::max(1.0, consts::windowMonitorShare * std::min(
+				static_cast<double>(monitor.x2 - monitor.x1) / consts::worldWidth,
+				static_cast<double>(monitor.y2 - monitor.y1) / consts::worldHeight
+			));
+		}
+
+		al_set_new_display_flags(ALLEGRO_WINDOWED | ALLEGRO_RESIZABLE);
+
+		// set up allegro display antialiasing for the quality tier
+		const RenderQuality::Tier& tier{ m_renderQuality.getTier() };
+		al_set_new_display_option(ALLEGRO_SAMPLE_BUFFERS, (tier.multisamples > 0) ? 1 : 0, ALLEGRO_SUGGEST);
+		al_set_new_display_option(ALLEGRO_SAMPLES, tier.multisamples, ALLEGRO_SUGGEST);
+		al_set_new_bitmap_flags(tier.isLinearFiltering ? (ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR) : 0);
+
 		// font has to be created AFTER the display or else it breaks
-		m_display = al_create_display(consts::screenWidth, consts::screenHeight);
+		m_display = al_create_display(
+			static_cast<int>(std::lround(consts::worldWidth * windowScale)),
+			static_cast<int>(std::lround(consts::worldHeight * windowScale))
+		);
 		m_font = al_create_builtin_font();
 
 		assertInitialized(m_display, "Allegro display");
 		assertInitialized(m_font, "Allegro builtin font");
 
 		al_register_event_source(m_eventQueue, al_get_display_event_source(m_display));
+		al_set_window_title(m_display, "Totally Accurate Eight-Ball Simulator");
+		m_isFullscreen = false;
+		handleResize();
 	}
 }
 
+void AllegroHandler::handleResize()
+{
+	if (!m_display)
+		return;
+
+	al_acknowledge_resize(m_display);
+	m_view = view::fit(al_get_display_width(m_display), al_get_display_height(m_display));
+
+	// still playable without them, just slower to draw
+	if (!m_sprites.prepare(m_view.scale, m_font, m_renderQuality.getTier().hasBallSprites))
+		std::cout << "Could not create the table and ball sprites, drawing them directly\n";
+
+	al_set_target_backbuffer(m_display);
+	view::use(m_view);
+	Input::getInstance().setView(m_view);
+}
+
+void AllegroHandler::toggleFullscreen()
+{
+	if (!m_display)
+		return;
+
+	if (al_set_display_flag(m_display, ALLEGRO_FULLSCREEN_WINDOW, !m_isFullscreen))
+		m_isFullscreen = !m_isFullscreen;
+
+	handleResize();
+}
+
+const view::Transform& AllegroHandler::getView() const
+{
+	return m_view;
+}
+
+const SpriteCache& AllegroHandler::getSprites() const
+{
+	return m_sprites;
+}
+
+RenderQuality& AllegroHandler::getRenderQuality()
+{
+	return m_renderQuality;
+}
+
+void AllegroHandler::applyRenderQuality()
+{
+	std::cout << "[Render Quality] " << m_renderQuality.getTier().name << (m_renderQuality.isOverridden() ? " (manual)\n\n" : "\n\n");
+
+	if (!m_display)
+		return;
+
+	const bool wasFullscreen{ m_isFullscreen };
+
+	// the font goes first, like when a match ends
+	destroyFont();
+	destroyDisplay();
+	createDisplay();
+
+	if (wasFullscreen)
+		toggleFullscreen();
+}
+
 bool AllegroHandler::destroyTimer()
 {
 	if (!m_timer)
@@ -165,6 +251,9 @@ bool AllegroHandler::destroyDisplay()
 	if (!m_display)
 		return false;
 
+	// the sprites are the display's bitmaps
+	m_sprites.clear();
+
 	al_unregister_event_source(m_eventQueue, al_get_display_event_source(m_display));
 	al_destroy_display(m_display);
 
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "common.h"
+#include "RenderQuality.h"
+#include "SpriteCache.h"
+#include "view.h"
 
 #include <allegro5/allegro5.h>
 #include <allegro5/allegro_font.h>
@@ -21,6 +24,14 @@ private:
 
 	std::vector<ALLEGRO_SAMPLE*> m_loadedSoundSamples;
 
+	// world units to the display's pixels, redone on every resize
+	view::Transform m_view{};
+	SpriteCache m_sprites;
+	bool m_isFullscreen{};
+
+	// the multisampling and filtering the display is made with, kept between matches
+	RenderQuality m_renderQuality;
+
 	void assertInitialized(bool resource, const std::string_view resourceName);
 	void loadResources();
 	void destroyResources();
@@ -35,7 +46,17 @@ public:
 	ALLEGRO_EVENT_QUEUE*& getEventQueue();
 	ALLEGRO_EVENT& getEvent();
 
+	// resizable, and sized to the monitor so the table isn't tiny on high resolution displays
 	void createDisplay();
+	// after the display changes size, refits the view and rasterizes the sprites for the new scale
+	void handleResize();
+	void toggleFullscreen();
+	const view::Transform& getView() const;
+	const SpriteCache& getSprites() const;
+
+	RenderQuality& getRenderQuality();
+	// remakes the display with the current tier, multisampling can't change on a live display
+	void applyRenderQuality();
 
 	bool destroyTimer();
 	bool destroyDisplay();
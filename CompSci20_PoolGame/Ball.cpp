@@ -232,37 +232,25 @@ bool Ball::isOverlappingBall(const Ball& otherBall) const
 	const double radiusLength{ m_radius + otherBall.getRadius() };
 	const Vector2 deltaPosition{ m_position.copyAndSubtract(otherBall.m_position) };
 
-#ifdef DEBUG
-	if (deltaPosition.getDotProduct(deltaPosition) <= (radiusLength * radiusLength))
-	{
-		std::cout << "[OVERLAPPING INFO]\n";
-		std::cout << "[self " << this << "] " << getX() << ", " << getY() << ", " << m_radius << '\n';
-		std::cout << "[other " << &otherBall << "] " << otherBall.getX() << ", " << otherBall.getY() << ", " << otherBall.getRadius() << "\n\n";
-		return true;
-	}
-	return false;
-#endif // DEBUG
-
 	return deltaPosition.getDotProduct(deltaPosition) <= (radiusLength * radiusLength);
 }
 
 bool Ball::isInPocket() const
 {
-	for (const auto& [pocketX, pocketY] : consts::pocketCoordinates)
-	{
-		static constexpr double POCKET_SENSITIVITY{ 10 }; // higher = less sensitive
+	return getPocketIndex() >= 0;
+}
 
-		const double radiusLength{ (m_radius + consts::pocketRadius) - POCKET_SENSITIVITY };
+int Ball::getPocketIndex() const
+{
+	for (int pocketIndex{}; pocketIndex < static_cast<int>(consts::pocketCoordinates.size()); ++pocketIndex)
+	{
+		const auto& [pocketX, pocketY] { consts::pocketCoordinates[pocketIndex] };
+		const double radiusLength{ (m_radius + consts::pocketRadius) - consts::pocketSensitivity };
 		const double deltaX{ m_position.getX() - pocketX };
 		const double deltaY{ m_position.getY() - pocketY };
 
 		if ((deltaX * deltaX + deltaY * deltaY) <= (radiusLength * radiusLength))
-		{
-#ifdef DEBUG
-			std::cout << "IN POCKET" << '\n';
-#endif // DEBUG
-			return true;
-		}
+			return pocketIndex;
 	}
-	return false;
+	return -1;
 }
@@ -2,15 +2,15 @@
 
 #include "Vector2.h"
 
+#include <cstdint>
 #include <vector>
 
 class Ball
 {
 public:
 	using balls_type = std::vector<Ball>;
-	using ballsPointer_type = std::vector<Ball*>;
 
-	enum class BallSuitType
+	enum class BallSuitType : std::uint8_t
 	{
 		unknown,
 		solid,
@@ -80,4 +80,6 @@ public:
 
 	bool isOverlappingBall(const Ball& otherBall) const;
 	bool isInPocket() const;
+	// the pockets are tested in order, -1 if the ball isn't in any
+	int getPocketIndex() const;
 };
@@ -0,0 +1,220 @@
+#include "Bot.h"
+
+#include "Ball.h"
+#include "Players.h"
+#include "constants.h"
+#include "ShotEvaluator.h"
+#include "ShotPlannerCache.h"
+#include "simulation.h"
+#include "TableDistanceField.h"
+#include "Vector2.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+Bot::Bot(const Config& config, const unsigned int seed)
+	: m_config{ config },
+	m_randomEngine{ seed }
+{
+}
+
+const Bot::Config& Bot::getConfig() const
+{
+	return m_config;
+}
+
+bool Bot::isBotTarget(const Ball& ball, const Players::PlayerType& shooter) const
+{
+	if (!ball.isVisible())
+		return false;
+
+	// all suit balls are gone, only the eight is left
+	if (shooter.score == 7)
+		return ball.getBallType() == Ball::BallSuitType::eight;
+
+	return simulation::isTargetBall(ball.getBallType(), shooter.targetBallType);
+}
+
+// thin cuts over long distances are the hard part
+static double getPotDifficulty(const ShotPlannerCache::Entry& entry)
+{
+	return (entry.pocketDistance + entry.cueDistance) / consts::worldWidth / std::max(std::cos(entry.cutAngle), 0.1);
+}
+
+simulation::ShotParameters Bot::chooseShot(const Ball::balls_type& gameBalls, const Players& gamePlayers)
+{
+	m_plannerCache.update(gameBalls);
+
+	Players players{ gamePlayers };
+	const Players::PlayerType shooter{ players.getCurrentPlayer() };
+
+	// the easiest pots first
+	std::vector<const ShotPlannerCache::Entry*> pots;
+	for (int ballIndex{ 1 }; ballIndex < static_cast<int>(gameBalls.size()); ++ballIndex)
+	{
+		if (!isBotTarget(gameBalls[ballIndex], shooter))
+			continue;
+
+		for (int pocketIndex{}; pocketIndex < ShotPlannerCache::pocketCount; ++pocketIndex)
+		{
+			const ShotPlannerCache::Entry& entry{ m_plannerCache.getEntry(ballIndex, pocketIndex) };
+			if (entry.isPottable())
+				pots.push_back(&entry);
+		}
+	}
+
+	std::sort(pots.begin(), pots.end(), [](const ShotPlannerCache::Entry* a, const ShotPlannerCache::Entry* b) {
+		return getPotDifficulty(*a) < getPotDifficulty(*b);
+	});
+
+	if (static_cast<int>(pots.size()) > m_config.maxCandidates)
+		pots.resize(m_config.maxCandidates);
+
+	// something to fall back on if there are no pots and no safety sweep
+	static constexpr double pi{ 3.14159265358979323846 };
+	std::uniform_real_distribution<double> angleDistribution{ 0.0, 2.0 * pi };
+
+	simulation::ShotParameters bestShot{ angleDistribution(m_randomEngine), consts::cueStickMaxPower * 0.5 };
+	double bestScore{ -1000.0 };
+
+	for (const ShotPlannerCache::Entry* pot : pots)
+	{
+		const Vector2 toGhost{ pot->ghostBall.copyAndSubtract(gameBalls[0].getPositionVector()) };
+		const double angle{ std::atan2(toGhost.getY(), toGhost.getX()) };
+
+		for (int powerIndex{ 1 }; powerIndex <= m_config.powerLevels; ++powerIndex)
+		{
+			const simulation::ShotParameters shot{ angle, static_cast<double>(consts::cueStickMaxPower) * powerIndex / m_config.powerLevels };
+			const double score{ simulation::simulateShot(gameBalls, gamePlayers, shot).score };
+
+			if (score > bestScore)
+			{
+				bestScore = score;
+				bestShot = shot;
+			}
+		}
+	}
+
+	// nothing pots cleanly, look for anything that at least doesn't foul
+	if (bestScore <= 0.0 && m_config.safetyAngles > 0)
+	{
+		const ShotEvaluator evaluator{ std::max(1, m_config.maxCandidates) };
+		const ShotEvaluator::Report report{
+			evaluator.evaluate(gameBalls, gamePlayers, simulation::generateCandidateShots(m_config.safetyAngles, 2))
+		};
+
+		if (!report.candidates.empty() && report.candidates[0].fineScore > bestScore)
+			bestShot = report.candidates[0].shot;
+	}
+
+	// and then actually play it
+	std::normal_distribution<double> aimNoise{ 0.0, m_config.aimNoise };
+	std::normal_distribution<double> powerNoise{ 0.0, m_config.powerNoise };
+
+	if (m_config.aimNoise > 0.0)
+		bestShot.angle += aimNoise(m_randomEngine);
+	if (m_config.powerNoise > 0.0)
+		bestShot.power = std::clamp(bestShot.power * (1.0 + powerNoise(m_randomEngine)), 1.0, static_cast<double>(consts::cueStickMaxPower));
+
+	return bestShot;
+}
+
+void Bot::placeCueBall(Ball::balls_type& gameBalls, const Players& gamePlayers)
+{
+	Players players{ gamePlayers };
+	const Players::PlayerType shooter{ players.getCurrentPlayer() };
+
+	// updated while the cue ball is off the table, the pocket
+	// legs then hold for wherever it ends up
+	Ball& cueBall{ gameBalls[0] };
+	cueBall.setVisible(false);
+	m_plannerCache.update(gameBalls);
+	m_distanceField.rebuild(gameBalls);
+	m_placementMap.rebuild(m_distanceField, cueBall.getRadius());
+
+	cueBall.setVelocity(0, 0);
+	cueBall.setVisible(true);
+
+	// straight in from behind the ghost ball of the closest clear pot
+	double bestDistance{ -1.0 };
+	Vector2 bestPosition{};
+
+	for (int ballIndex{ 1 }; ballIndex < static_cast<int>(gameBalls.size()); ++ballIndex)
+	{
+		if (!isBotTarget(gameBalls[ballIndex], shooter))
+			continue;
+
+		for (int pocketIndex{}; pocketIndex < ShotPlannerCache::pocketCount; ++pocketIndex)
+		{
+			const ShotPlannerCache::Entry& entry{ m_plannerCache.getEntry(ballIndex, pocketIndex) };
+			if (!entry.isAvailable || !entry.isPocketPathClear || (bestDistance >= 0.0 && entry.pocketDistance >= bestDistance))
+				continue;
+
+			const Vector2 toGhost{ entry.ghostBall.copyAndSubtract(gameBalls[ballIndex].getPositionVector()).getNormalized() };
+			const Vector2 position{ entry.ghostBall.copyAndAdd(toGhost.copyAndMultiply(consts::botPlacementDistance)) };
+
+			if (!m_placementMap.isValid(position)
+				|| !m_distanceField.isPathClear(position, entry.ghostBall, ballMask::cue | ballMask::getBall(ballIndex)))
+			{
+				continue;
+			}
+
+			bestDistance = entry.pocketDistance;
+			bestPosition = position;
+		}
+	}
+
+	if (bestDistance >= 0.0)
+	{
+		cueBall.setPosition(bestPosition);
+		return;
+	}
+
+	// no clear pot, anywhere legal will do
+	std::uniform_real_distribution<double> xDistribution{ static_cast<double>(consts::playSurface.xPos1), static_cast<double>(consts::playSurface.xPos2) };
+	std::uniform_real_distribution<double> yDistribution{ static_cast<double>(consts::playSurface.yPos1), static_cast<double>(consts::playSurface.yPos2) };
+
+	for (int attempt{}; attempt < consts::botPlacementAttempts; ++attempt)
+	{
+		const Vector2 position{ xDistribution(m_randomEngine), yDistribution(m_randomEngine) };
+		if (m_placementMap.isValid(position))
+		{
+			cueBall.setPosition(position);
+			return;
+		}
+	}
+
+	// as close to the usual spot as it gets
+	Vector2 position{ static_cast<double>(consts::rackBallPositions[0][0]), static_cast<double>(consts::rackBallPositions[0][1]) };
+	m_placementMap.findNearestValid(position, position);
+	cueBall.setPosition(position);
+}
+
+std::vector<Bot::Config> Bot::getPresets()
+{
+	// name, candidates, power levels, safety angles, aim noise, power noise
+	return {
+		{ "novice", 3, 2, 0, 0.03, 0.15 },
+		{ "amateur", 5, 3, 36, 0.015, 0.08 },
+		{ "club", 8, 4, 72, 0.008, 0.05 },
+		{ "pro", 12, 5, 144, 0.003, 0.03 },
+		{ "potter", 12, 5, 0, 0.003, 0.03 } // pro without safeties
+	};
+}
+
+bool Bot::findPreset(std::string_view name, Config& config)
+{
+	for (const Config& preset : getPresets())
+	{
+		if (preset.name == name)
+		{
+			config = preset;
+			return true;
+		}
+	}
+	return false;
+}
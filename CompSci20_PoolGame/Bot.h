@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Ball.h"
+#include "PlacementMap.h"
+#include "Players.h"
+#include "ShotPlannerCache.h"
+#include "simulation.h"
+#include "TableDistanceField.h"
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// a computer player for headless matches
+// 1. simulate the easiest few pots the planner cache knows about
+// 2. if none of them look good, sweep the table with the shot evaluator
+// 3. miss by a bit, how much is up to the config
+class Bot
+{
+public:
+	struct Config
+	{
+		std::string name;
+		int maxCandidates{ 8 }; // planned pots that get simulated
+		int powerLevels{ 4 }; // powers tried per planned pot
+		int safetyAngles{ 72 }; // evaluator sweep when nothing pots, 0 = no sweep
+		double aimNoise{}; // radians
+		double powerNoise{}; // fraction of the chosen power
+	};
+
+private:
+	Config m_config;
+	ShotPlannerCache m_plannerCache;
+	TableDistanceField m_distanceField;
+	PlacementMap m_placementMap;
+	std::mt19937 m_randomEngine;
+
+	bool isBotTarget(const Ball& ball, const Players::PlayerType& shooter) const;
+
+public:
+	Bot(const Config& config, const unsigned int seed);
+
+	const Config& getConfig() const;
+
+	simulation::ShotParameters chooseShot(const Ball::balls_type& gameBalls, const Players& gamePlayers);
+	// ball in hand, leaves the cue ball somewhere legal behind an easy pot if it can
+	void placeCueBall(Ball::balls_type& gameBalls, const Players& gamePlayers);
+
+	static std::vector<Config> getPresets();
+	static bool findPreset(std::string_view name, Config& config);
+};
@@ -0,0 +1,136 @@
+#include "FrameTimings.h"
+
+#include "constants.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+int FrameTimings::Histogram::getBucket(const double seconds)
+{
+	if (seconds <= minimumSeconds)
+		return 0;
+
+	const int bucket{ static_cast<int>(std::log2(seconds / minimumSeconds) * bucketsPerDoubling) };
+	return std::min(bucket, bucketCount - 1);
+}
+
+double FrameTimings::Histogram::getBucketEnd(const int bucket)
+{
+	return minimumSeconds * std::exp2(static_cast<double>(bucket + 1) / bucketsPerDoubling);
+}
+
+void FrameTimings::Histogram::record(const double seconds)
+{
+	++m_buckets[getBucket(seconds)];
+	++m_count;
+	m_totalSeconds += seconds;
+	m_worstSeconds = std::max(m_worstSeconds, seconds);
+
+	if (seconds > consts::frameDeadline)
+		++m_missedDeadlines;
+}
+
+std::uint64_t FrameTimings::Histogram::getCount() const
+{
+	return m_count;
+}
+
+std::uint64_t FrameTimings::Histogram::getMissedDeadlines() const
+{
+	return m_missedDeadlines;
+}
+
+double FrameTimings::Histogram::getMeanSeconds() const
+{
+	return (m_count > 0) ? m_totalSeconds / m_count : 0.0;
+}
+
+double FrameTimings::Histogram::getWorstSeconds() const
+{
+	return m_worstSeconds;
+}
+
+double FrameTimings::Histogram::getPercentileSeconds(const double fraction) const
+{
+	if (m_count == 0)
+		return 0.0;
+
+	// the sample that fraction of them are at or below
+	const std::uint64_t rank{ std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(fraction * m_count))) };
+
+	// spread evenly across the bucket it lands in
+	std::uint64_t seen{};
+	for (int bucket{}; bucket < bucketCount; ++bucket)
+	{
+		if (seen + m_buckets[bucket] >= rank)
+		{
+			const double start{ (bucket > 0) ? getBucketEnd(bucket - 1) : 0.0 };
+			const double position{ static_cast<double>(rank - seen) / m_buckets[bucket] };
+			return std::min(start + (getBucketEnd(bucket) - start) * position, m_worstSeconds);
+		}
+
+		seen += m_buckets[bucket];
+	}
+
+	return m_worstSeconds;
+}
+
+void FrameTimings::record(const Phase phase, const double seconds)
+{
+	m_histograms[static_cast<int>(phase)].record(seconds);
+}
+
+const FrameTimings::Histogram& FrameTimings::getHistogram(const Phase phase) const
+{
+	return m_histograms[static_cast<int>(phase)];
+}
+
+void FrameTimings::writeReport(std::ostream& out) const
+{
+	static constexpr std::array<double, 4> percentiles{ 0.5, 0.9, 0.99, 0.999 };
+
+	out << "[Frame Times] " << getHistogram(Phase::frame).getCount() << " frames, deadline "
+		<< std::fixed << std::setprecision(1) << consts::frameDeadline * 1000.0 << " ms\n";
+	out << std::left << std::setw(10) << "phase" << std::right
+		<< std::setw(9) << "p50" << std::setw(9) << "p90" << std::setw(9) << "p99" << std::setw(9) << "p99.9"
+		<< std::setw(9) << "worst" << std::setw(9) << "mean" << std::setw(9) << "missed" << '\n';
+
+	out << std::setprecision(2);
+	for (int phase{}; phase < phaseCount; ++phase)
+	{
+		const Histogram& histogram{ m_histograms[phase] };
+		if (histogram.getCount() == 0)
+			continue;
+
+		out << std::left << std::setw(10) << getPhaseName(static_cast<Phase>(phase)) << std::right;
+		for (const double percentile : percentiles)
+			out << std::setw(9) << histogram.getPercentileSeconds(percentile) * 1000.0;
+
+		out << std::setw(9) << histogram.getWorstSeconds() * 1000.0
+			<< std::setw(9) << histogram.getMeanSeconds() * 1000.0
+			<< std::setw(9) << histogram.getMissedDeadlines() << '\n';
+	}
+
+	out << std::defaultfloat << std::setprecision(6);
+}
+
+const char* FrameTimings::getPhaseName(const Phase phase)
+{
+	switch (phase)
+	{
+	case Phase::frame:
+		return "frame";
+	case Phase::update:
+		return "update";
+	case Phase::physics:
+		return "physics";
+	case Phase::render:
+		return "render";
+	default:
+		return "unknown";
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+// how long frames and their phases take, for finding hitches an average hides
+// - every duration goes into a log scale histogram, 8 buckets per doubling from
+//   10 microseconds up, so a whole session is a few kilobytes and any
+//   percentile is within about 9% of the real value
+// - the worst duration and the ones over the frame deadline are kept exactly
+class FrameTimings
+{
+public:
+	enum class Phase
+	{
+		frame, // start of one frame to the start of the next
+		update, // frameUpdate without the rendering
+		physics,
+		render,
+		count
+	};
+
+	static constexpr int phaseCount{ static_cast<int>(Phase::count) };
+	static constexpr int bucketsPerDoubling{ 8 };
+	static constexpr int bucketCount{ 24 * bucketsPerDoubling }; // up to about 2 minutes
+	static constexpr double minimumSeconds{ 1e-5 };
+
+	class Histogram
+	{
+	private:
+		std::array<std::uint32_t, bucketCount> m_buckets{};
+		std::uint64_t m_count{};
+		std::uint64_t m_missedDeadlines{};
+		double m_totalSeconds{};
+		double m_worstSeconds{};
+
+		static int getBucket(const double seconds);
+		static double getBucketEnd(const int bucket);
+
+	public:
+		void record(const double seconds);
+
+		std::uint64_t getCount() const;
+		std::uint64_t getMissedDeadlines() const;
+		double getMeanSeconds() const;
+		double getWorstSeconds() const;
+		// fraction is 0 to 1, e.g. 0.99 for p99
+		double getPercentileSeconds(const double fraction) const;
+	};
+
+private:
+	std::array<Histogram, phaseCount> m_histograms{};
+
+public:
+	void record(const Phase phase, const double seconds);
+	const Histogram& getHistogram(const Phase phase) const;
+
+	// a table of percentiles in milliseconds, one row per phase
+	void writeReport(std::ostream& out) const;
+
+	static const char* getPhaseName(const Phase phase);
+};
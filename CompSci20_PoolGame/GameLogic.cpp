@@ -6,101 +6,158 @@
 
 #include "constants.h"
 #include "common.h"
+#include "FrameTimings.h"
 #include "render.h"
 #include "referee.h"
 #include "physics.h"
+#include "physicsLog.h"
+#include "PlacementMap.h"
+#include "ShotDataset.h"
+#include "TableDistanceField.h"
+#include "TurnJournal.h"
+#include "simulation.h"
+#include "trace.h"
 
 #include <allegro5/allegro5.h>
 #include <allegro5/allegro_native_dialog.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <future>
 #include <iostream>
 #include <string>
 #include <string_view>
 #include <vector>
 
-static void createBalls(Ball::balls_type& gameBalls, const int ballCount, const double ballRadius, const double ballMass)
+GameLogic::GameLogic(AllegroHandler& allegro, const std::string& playerName1, const std::string& playerName2, const GameMode gameMode, const std::string& trickShotTarget, const bool isResuming)
+	: m_allegro{ allegro },
+	m_gamePlayers{ 2 },
+	m_gameMode{ gameMode }
 {
-	gameBalls.resize(ballCount);
-	for (int i{}; i < ballCount; ++i)
-	{
-		Ball& ball{ gameBalls[i] };
-		ball.setRadius(ballRadius);
-		ball.setMass(ballMass);
-		ball.setBallNumber(i);
-		ball.setVisible(true);
-	}
-}
+	simulation::createBalls(m_gameBalls, 16, consts::defaultBallRadius, consts::defaultBallMass);
+	simulation::setupRack(m_gameBalls);
+	m_onTable = ballMask::getOnTable(m_gameBalls);
 
-static void setupRack(Ball::balls_type& gameBalls)
-{
-	static std::vector<int> ballIndexes{ 1, 2, 3, 4, 6, 7, 9, 10, 12, 13, 14, 15 };
+	m_gamePlayers.getPlayer(0).name = playerName1;
+	m_gamePlayers.getPlayer(1).name = playerName2;
 
-	intArrayFisherYatesShuffle(ballIndexes);
+	// the overlay still works without the table, it just starts at "..."
+	if (m_difficultyTable.load(std::string{ consts::difficultyTablePath }))
+		m_shotPredictor.setDifficultyTable(&m_difficultyTable);
 
-	int ballIndex{};
+	std::string trickShotTargetText{ trickShotTarget };
+	const bool hasResumed{ isResuming && resumeMatch(trickShotTargetText) };
 
-	for (int rackIndex{ 1 }; rackIndex < consts::rackBallPositions.size(); ++rackIndex)
+	if (!hasResumed)
 	{
-		if (rackIndex == 8 || rackIndex == 11 || rackIndex == 5)
+		// slightly more distributed random
+		if (m_gameMode != GameMode::practice)
 		{
-			++rackIndex;
+			m_gamePlayers.setPlayerIndex(
+				(getRandomInteger(0, 10) >= 5) ? 0 : 1
+			);
 		}
-		gameBalls[ballIndexes[ballIndex]].setPosition(consts::rackBallPositions[rackIndex][0], consts::rackBallPositions[rackIndex][1]);
-		++ballIndex;
+
+		startJournal(trickShotTargetText);
 	}
 
-	// cue and eight ball have constant rack position
-	gameBalls[0].setPosition(consts::rackBallPositions[0][0], consts::rackBallPositions[0][1]);
-	gameBalls[8].setPosition(consts::rackBallPositions[8][0], consts::rackBallPositions[8][1]);
+	m_distanceField.rebuild(m_gameBalls);
 
-	// back corners of rack should be of balls from different suits
-	gameBalls[5].setPosition(consts::rackBallPositions[5][0], consts::rackBallPositions[5][1]);
-	gameBalls[11].setPosition(consts::rackBallPositions[11][0], consts::rackBallPositions[11][1]);
-}
+	if (m_gameMode == GameMode::practice)
+	{
+		std::cout << "[Practice]: Player (" << m_gamePlayers.getCurrentPlayer().name << ")\n";
 
-static bool isValidPlacePosition(Ball& cueBall, Ball::balls_type& gameBalls)
-{
-	bool isOverlappingBall{};
-	bool isOverlappingBoundary{};
+		if (TrickShotSolver::parseTarget(trickShotTargetText, m_trickShotTarget))
+			std::cout << "[Trick Shot]: " << TrickShotSolver::getTargetName(m_trickShotTarget) << " (press H for a hint)\n\n";
+		else
+			std::cout << "[Trick Shot]: None\n\n";
 
-	for (Ball& ball : gameBalls)
-	{
-		if (cueBall.isOverlappingBall(ball))
-		{
-			isOverlappingBall = true;
-			break;
-		}
-	}
+		std::cout << "[Rewind]: Z takes back a shot, R reviews the last one (" << m_rewindBuffer.getMemoryBytes() / 1024 << " KB)\n\n";
 
-	isOverlappingBoundary = physics::isCircleCollidingWithBoundaryTop(cueBall, consts::playSurface)
-		|| physics::isCircleCollidingWithBoundaryBottom(cueBall, consts::playSurface)
-		|| physics::isCircleCollidingWithBoundaryLeft(cueBall, consts::playSurface)
-		|| physics::isCircleCollidingWithBoundaryRight(cueBall, consts::playSurface);
+		return;
+	}
 
-	return !isOverlappingBall && !isOverlappingBoundary;
+	if (hasResumed)
+		std::cout << "[Turn Start]: Player (" << m_gamePlayers.getCurrentPlayer().name << ")\n\n";
+	else
+		std::cout << "[Breaker]: Player (" << m_gamePlayers.getCurrentPlayer().name << ")\n\n";
 }
 
-GameLogic::GameLogic(AllegroHandler& allegro, const std::string& playerName1, const std::string& playerName2)
-	: m_allegro{ allegro },
-	m_gamePlayers{ 2 }
+bool GameLogic::frameUpdate()
 {
-	createBalls(m_gameBalls, 16, consts::defaultBallRadius, consts::defaultBallMass);
-	setupRack(m_gameBalls);
-
-	m_gamePlayers.getPlayer(0).name = playerName1;
-	m_gamePlayers.getPlayer(1).name = playerName2;
+	const double frameStart{ al_get_time() };
+	if (m_lastFrameStart >= 0.0)
+	{
+		m_frameTimings.record(FrameTimings::Phase::frame, frameStart - m_lastFrameStart);
 
-	// slightly more distributed random
-	m_gamePlayers.setPlayerIndex(
-		(getRandomInteger(0, 10) >= 5) ? 0 : 1
-	);
+		// the first seconds of play pick the render quality
+		if (m_allegro.getRenderQuality().recordFrame(frameStart - m_lastFrameStart))
+			m_allegro.applyRenderQuality();
+	}
+	m_lastFrameStart = frameStart;
 
-	std::cout << "[Breaker]: Player (" << m_gamePlayers.getCurrentPlayer().name << ")\n\n";
-}
+	// F5 steps through the render quality tiers by hand, which stops the automatic pick
+	const bool isQualityKeyDown{ m_input.isKeyDown(ALLEGRO_KEY_F5) };
+	if (isQualityKeyDown && !m_wasQualityKeyDown)
+	{
+		RenderQuality& renderQuality{ m_allegro.getRenderQuality() };
+		renderQuality.setOverride((renderQuality.getTierIndex() + 1) % static_cast<int>(RenderQuality::tiers.size()));
+		m_allegro.applyRenderQuality();
+	}
+	m_wasQualityKeyDown = isQualityKeyDown;
+
+	// F3 shows the physics counters
+	const bool isCountersKeyDown{ m_input.isKeyDown(ALLEGRO_KEY_F3) };
+	if (isCountersKeyDown && !m_wasCountersKeyDown)
+		m_isShowingCounters = !m_isShowingCounters;
+	m_wasCountersKeyDown = isCountersKeyDown;
+
+	// F2 draws what the physics is working with over the table
+	const bool isOverlayKeyDown{ m_input.isKeyDown(ALLEGRO_KEY_F2) };
+	if (isOverlayKeyDown && !m_wasOverlayKeyDown)
+		m_isShowingPhysicsOverlay = !m_isShowingPhysicsOverlay;
+	m_wasOverlayKeyDown = isOverlayKeyDown;
+
+	// F4 writes out the physics log, if it was turned on with --physics-log
+	const bool isLogKeyDown{ m_input.isKeyDown(ALLEGRO_KEY_F4) };
+	if (isLogKeyDown && !m_wasLogKeyDown && physicsLog::isEnabled())
+		std::cout << (physicsLog::dump() ? "[Physics Log] written\n" : "[Physics Log] could not be written\n");
+	m_wasLogKeyDown = isLogKeyDown;
+
+	if (m_gameMode == GameMode::practice)
+	{
+		// Z takes back the last shot, or the one still rolling
+		const bool isUndoKeyDown{ m_input.isKeyDown(ALLEGRO_KEY_Z) };
+		if (isUndoKeyDown && !m_wasUndoKeyDown)
+			undoShot();
+		m_wasUndoKeyDown = isUndoKeyDown;
+
+		// R shows the last shot from its end, only once everything has stopped
+		const bool isReviewKeyDown{ m_input.isKeyDown(ALLEGRO_KEY_R) };
+		if (isReviewKeyDown && !m_wasReviewKeyDown)
+		{
+			if (m_isReviewing)
+			{
+				m_isReviewing = false;
+			}
+			else if (m_rewindBuffer.getTurnCount() > 0 && !m_rewindBuffer.isRecording())
+			{
+				m_reviewBalls = m_gameBalls;
+				m_reviewTick = m_rewindBuffer.getShotTicks();
+				m_isReviewing = m_rewindBuffer.reconstruct(m_reviewTick, m_reviewBalls);
+			}
+		}
+		m_wasReviewKeyDown = isReviewKeyDown;
+	}
 
-bool GameLogic::frameUpdate()
-{
-	if (m_activeTurn.startWithBallInHand)
+	if (m_isReviewing)
+	{
+		updateReview();
+	}
+	else if (m_activeTurn.startWithBallInHand)
 	{
 		if (!m_gameBalls[0].isVisible())
 		{
@@ -108,23 +165,48 @@ bool GameLogic::frameUpdate()
 			m_gameBalls[0].setVelocity(0, 0);
 		}
 
-		m_gameBalls[0].setPosition(m_input.getMouseVector());
+		// the table doesn't change while placing, so the legal spots are only worked out once
+		if (!m_placementMap.isBuilt())
+			m_placementMap.rebuild(m_distanceField, m_gameBalls[0].getRadius());
+
+		// the ball slides to the closest legal spot instead of sitting on top of others
+		Vector2 placePosition{ m_input.getMouseVector() };
+		m_placementMap.findNearestValid(placePosition, placePosition);
+		m_gameBalls[0].setPosition(placePosition);
 
-		if (m_input.isMouseButtonDown(1) && isValidPlacePosition(m_gameBalls[0], m_gameBalls))
+		if (m_input.isMouseButtonDown(1) && m_placementMap.isValid(placePosition))
 		{
 			m_gameCueStick.setCanUpdate(true);
 			m_gameCueStick.setVisible(true);
 			m_gameBalls[0].setVisible(true);
 			m_activeTurn.startWithBallInHand = false;
+			m_isShotFromBallInHand = true;
+			m_placementMap.clear();
 		}
 
 		m_gameCueStick.setCuePower(0);
+		m_shotPredictor.pause();
 	}
 	else
 	{
+		const double physicsStart{ al_get_time() };
 		updatePhysics();
+		m_frameTimings.record(FrameTimings::Phase::physics, al_get_time() - physicsStart);
+
 		m_gameCueStick.updateAll(m_gameBalls[0].getX(), m_gameBalls[0].getY());
 
+		if (m_gameCueStick.canUpdate())
+		{
+			// nothing would show the estimate, so don't spend the cores on it
+			if (m_allegro.getRenderQuality().getTier().hudDetail >= RenderQuality::HudDetail::standard)
+				m_shotPredictor.setAim(m_gameBalls, m_gamePlayers, getAimedShot());
+			else
+				m_shotPredictor.pause();
+
+			if (m_gameMode == GameMode::practice)
+				updateTrickShotHint();
+		}
+
 		if (m_gameCueStick.canUpdate() && m_input.isMouseButtonDown(1))
 		{
 			shootCueBall();
@@ -149,11 +231,16 @@ bool GameLogic::frameUpdate()
 		}
 	}
 
+	double renderSeconds{};
 	if (m_allegro.isEventQueueEmpty())
 	{
+		const double renderStart{ al_get_time() };
 		updateRender();
+		renderSeconds = al_get_time() - renderStart;
+		m_frameTimings.record(FrameTimings::Phase::render, renderSeconds);
 	}
 
+	m_frameTimings.record(FrameTimings::Phase::update, al_get_time() - frameStart - renderSeconds);
 	return false;
 }
 
@@ -165,6 +252,8 @@ bool GameLogic::frameUpdate()
 // be exactly the same.
 void GameLogic::updatePhysics()
 {
+	const trace::Scope traceScope{ "updatePhysics" };
+
 	static double timeAccumulator{};
 	static double previousTime{ al_get_time() };
 	static double currentTime;
@@ -184,18 +273,355 @@ void GameLogic::updatePhysics()
 	{
 		physics::stepPhysics(m_gameBalls, m_gamePlayers, m_activeTurn, m_allegro);
 		timeAccumulator -= consts::physicsUpdateDelta;
+
+		if (m_rewindBuffer.isRecording())
+			m_rewindBuffer.recordTick(m_gameBalls);
 	}
 }
 
 void GameLogic::updateRender()
 {
-	render::drawPlaysurface();
-	render::drawPockets();
-	render::drawBalls(m_gameBalls, m_allegro.getFont());
+	const trace::Scope traceScope{ "render" };
+
+	render::drawTable(m_allegro.getSprites());
+
+	if (m_isReviewing)
+	{
+		render::drawBalls(m_reviewBalls, m_allegro.getFont(), m_allegro.getSprites());
+		render::drawRewindStatus(m_reviewTick, m_rewindBuffer.getShotTicks(), m_allegro.getFont());
+		render::renderDrawings();
+		return;
+	}
+
+	if (m_activeTurn.startWithBallInHand && m_placementMap.isBuilt())
+	{
+		render::drawPlacementMap(m_placementMap);
+	}
+
+	const RenderQuality::HudDetail hudDetail{ m_allegro.getRenderQuality().getTier().hudDetail };
+
+	// where the cue ball would first touch something if nothing else moved
+	if (m_gameCueStick.canUpdate() && !m_activeTurn.startWithBallInHand && hudDetail >= RenderQuality::HudDetail::standard)
+	{
+		const Ball& cueBall{ m_gameBalls[0] };
+		const double angle{ getAimedShot().angle };
+		const double distance{ m_distanceField.castBall(
+			cueBall.getPositionVector(), { std::cos(angle), std::sin(angle) }, cueBall.getRadius(), ballMask::cue, consts::aimGuideLength
+		) };
+
+		render::drawAimGuide(cueBall, angle, distance);
+	}
+
+	render::drawBalls(m_gameBalls, m_allegro.getFont(), m_allegro.getSprites());
 	render::drawCueStick(m_gameCueStick);
+
+	if (m_isShowingPhysicsOverlay)
+	{
+		render::drawPhysicsOverlay(m_gameBalls, m_allegro.getFont());
+	}
+
+	if (m_trickShotSolution.isFound && m_gameCueStick.canUpdate())
+	{
+		render::drawTrickShotHint(m_trickShotSolution, m_gameBalls[0], m_allegro.getFont());
+	}
+
+	// only while the player who took the shot aims again, and only when they missed something worth showing
+	if (m_gameCueStick.canUpdate() && hudDetail >= RenderQuality::HudDetail::full)
+	{
+		const ShotCoach::Advice advice{ m_shotCoach.getAdvice() };
+		if (advice.isReady && advice.shooterIndex == m_gamePlayers.getCurrentIndex()
+			&& advice.getScoreDifference() >= consts::coachMinScoreDifference)
+		{
+			render::drawCoachAdvice(advice, m_allegro.getFont());
+
+			if (!m_hasReportedAdvice)
+			{
+				std::cout << "[Coach] Best Shot: Power " << static_cast<int>(advice.bestShot.power + 0.5)
+					<< ", Pocketed: " << advice.bestOutcome.ownBallsPocketed << " (yours " << advice.playedOutcome.ownBallsPocketed << ")"
+					<< ", Score: " << advice.bestOutcome.score << " (yours " << advice.playedOutcome.score << ")\n\n";
+				m_hasReportedAdvice = true;
+			}
+		}
+	}
+
+	if (m_shotPredictor.isActive() && hudDetail >= RenderQuality::HudDetail::standard)
+	{
+		render::drawShotPrediction(m_shotPredictor.getEstimate(), m_gameBalls, m_allegro.getFont());
+	}
+
+	if (m_isShowingCounters)
+	{
+		// the shot so far while it's moving, the last one while aiming
+		const physics::StepCounters shotCounters{
+			m_gameCueStick.canUpdate() ? m_lastShotCounters : physics::getStepCounters().getDifference(m_shotStartCounters)
+		};
+
+		render::drawPhysicsCounters(physics::getLastTickCounters(), shotCounters, m_allegro.getFont());
+	}
+
 	render::renderDrawings();
 }
 
+void GameLogic::updateTrickShotHint()
+{
+	// collect a finished solve
+	if (m_pendingTrickShot.valid())
+	{
+		if (m_pendingTrickShot.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return;
+
+		m_trickShotSolution = m_pendingTrickShot.get();
+
+		if (m_trickShotSolution.isFound)
+		{
+			std::cout << "[Trick Shot Hint] Power: " << static_cast<int>(m_trickShotSolution.shot.power + 0.5)
+				<< ", Pocket: " << (m_trickShotSolution.pocketIndex + 1)
+				<< ", Success Rate: " << static_cast<int>(m_trickShotSolution.successRate * 100.0 + 0.5) << "%"
+				<< (m_trickShotSolution.isFromCache ? " (cached)" : "") << "\n\n";
+		}
+		else
+		{
+			std::cout << "[Trick Shot Hint] No way to make " << TrickShotSolver::getTargetName(m_trickShotTarget) << " from here.\n\n";
+		}
+	}
+
+	// only solve once per key press
+	const bool isHintKeyDown{ m_input.isKeyDown(ALLEGRO_KEY_H) };
+	const bool wasHintKeyDown{ m_wasHintKeyDown };
+	m_wasHintKeyDown = isHintKeyDown;
+
+	if (isHintKeyDown && !wasHintKeyDown && m_trickShotTarget.isValid())
+	{
+		// copies of the table, the game keeps running while this solves
+		m_pendingTrickShot = std::async(std::launch::async, [this, gameBalls{ m_gameBalls }, gamePlayers{ m_gamePlayers }]() {
+			return m_trickShotSolver.solve(gameBalls, gamePlayers, m_trickShotTarget);
+		});
+	}
+}
+
+void GameLogic::recordShot()
+{
+	ShotDatasetWriter* const recorder{ simulation::getShotRecorder() };
+	if (!recorder || !recorder->isRecording(shotDataset::Source::played) || m_shotStartBalls.empty())
+		return;
+
+	// physics doesn't count ticks in the game, the shot's wall time is close enough
+	const int ticks{ static_cast<int>((al_get_time() - m_lastShotStartTime) / consts::physicsUpdateDelta) };
+
+	shotDataset::Row row{ shotDataset::makeRow(m_shotStartBalls, m_gameBalls, m_gamePlayers.getCurrentPlayer(), m_lastShot, m_activeTurn, ticks) };
+	row.source = shotDataset::Source::played;
+	row.player = static_cast<std::uint8_t>(m_gamePlayers.getCurrentIndex());
+	row.ballInHand = m_isShotFromBallInHand;
+	recorder->append(row);
+}
+
+void GameLogic::recordShotCounters()
+{
+	m_lastShotCounters = physics::getStepCounters().getDifference(m_shotStartCounters);
+	m_matchCounters.merge(m_lastShotCounters);
+
+	if (!physics::getCountersPath().empty())
+	{
+		std::ofstream file{ physics::getCountersPath(), std::ios::app };
+		physics::writeStepCounters(file, "shot", m_gamePlayers.getCurrentPlayer().name, m_lastShotCounters);
+	}
+}
+
+static void copyName(char (&destination)[32], const std::string& name)
+{
+	// the headers start zeroed, so stopping one short always leaves a terminator
+	name.copy(destination, sizeof(destination) - 1);
+}
+
+static std::string readName(const char (&source)[32])
+{
+	return { source, std::find(source, source + sizeof(source), '\0') };
+}
+
+void GameLogic::startJournal(const std::string& trickShotTarget)
+{
+	TurnJournal::Header header{};
+	header.gameMode = static_cast<std::uint8_t>(m_gameMode);
+	header.breaker = static_cast<std::uint8_t>(m_gamePlayers.getCurrentIndex());
+	header.ballCount = static_cast<std::uint16_t>(m_gameBalls.size());
+	copyName(header.playerNames[0], m_gamePlayers.getPlayer(0).name);
+	copyName(header.playerNames[1], m_gamePlayers.getPlayer(1).name);
+	copyName(header.trickShotTarget, trickShotTarget);
+
+	for (std::size_t i{}; i < m_gameBalls.size(); ++i)
+	{
+		header.ballX[i] = m_gameBalls[i].getX();
+		header.ballY[i] = m_gameBalls[i].getY();
+	}
+
+	// the match still plays without it, it just can't be resumed
+	if (!m_turnJournal.create(std::string{ consts::turnJournalPath }, header))
+		std::cout << "Could not create turn journal " << consts::turnJournalPath << '\n';
+}
+
+void GameLogic::journalTurn()
+{
+	TurnJournal::Turn turn{};
+	turn.turnNumber = m_turnNumber++;
+	turn.player = static_cast<std::uint8_t>(m_gamePlayers.getCurrentIndex());
+	turn.isBallInHand = m_isShotFromBallInHand;
+	turn.cueX = m_shotStartBalls[0].getX();
+	turn.cueY = m_shotStartBalls[0].getY();
+	turn.velocityX = m_lastShotVelocity.getX();
+	turn.velocityY = m_lastShotVelocity.getY();
+	turn.tableChecksum = TurnJournal::getTableChecksum(m_gameBalls);
+	m_turnJournal.append(turn);
+
+	m_isShotFromBallInHand = false;
+}
+
+bool GameLogic::resumeMatch(std::string& trickShotTarget)
+{
+	const std::string path{ consts::turnJournalPath };
+
+	TurnJournal::Contents contents;
+	if (!TurnJournal::load(path, contents) || contents.header.ballCount != m_gameBalls.size())
+	{
+		std::cout << "[Resume]: There is no unfinished match to resume.\n\n";
+		return false;
+	}
+
+	const TurnJournal::Header& header{ contents.header };
+	m_gameMode = static_cast<GameMode>(header.gameMode);
+	m_gamePlayers.getPlayer(0).name = readName(header.playerNames[0]);
+	m_gamePlayers.getPlayer(1).name = readName(header.playerNames[1]);
+	m_gamePlayers.setPlayerIndex(header.breaker);
+	trickShotTarget = readName(header.trickShotTarget);
+
+	for (std::size_t i{}; i < m_gameBalls.size(); ++i)
+	{
+		m_gameBalls[i].setPosition(header.ballX[i], header.ballY[i]);
+		m_gameBalls[i].setVelocity(0, 0);
+		m_gameBalls[i].setVisible(true);
+	}
+	m_onTable = ballMask::getOnTable(m_gameBalls);
+
+	// the same turn ending as endTurn, without any of the printing
+	std::uint32_t replayedTurns{};
+	for (const TurnJournal::Turn& turn : contents.turns)
+	{
+		if (turn.player != m_gamePlayers.getCurrentIndex())
+			break;
+
+		const Ball::balls_type ballsBefore{ m_gameBalls };
+		const Players playersBefore{ m_gamePlayers };
+
+		Ball& cueBall{ m_gameBalls[0] };
+		cueBall.setVisible(true);
+		cueBall.setPosition(turn.cueX, turn.cueY);
+		cueBall.setVelocity(turn.velocityX, turn.velocityY);
+
+		// placing the ball in hand ends that part of the turn before the shot
+		TurnInformation replayedTurn{ m_activeTurn };
+		replayedTurn.startWithBallInHand = false;
+
+		// tick by tick like updatePhysics, with no limit on how long it rolls,
+		// the headless stepPhysics only leaves out the sound
+		while (physics::areBallsMoving(m_gameBalls))
+			physics::stepPhysics(m_gameBalls, m_gamePlayers, replayedTurn);
+
+		// a different table means the rest of the journal can't be trusted,
+		// the match carries on from the last turn that matched
+		const ballMask_type onTable{ ballMask::getAfterTurn(m_onTable, replayedTurn.pocketedBalls) };
+		if (TurnJournal::getTableChecksum(m_gameBalls) != turn.tableChecksum || referee::isGameFinished(onTable))
+		{
+			m_gameBalls = ballsBefore;
+			m_gamePlayers = playersBefore;
+			break;
+		}
+
+		m_activeTurn = replayedTurn;
+		m_onTable = onTable;
+		const bool hasPocketedBall{ m_activeTurn.pocketedBalls != 0 };
+		const bool didFoul{ !referee::isTurnValid(m_gamePlayers.getCurrentPlayer(), m_activeTurn) };
+
+		if (didFoul)
+			m_gameBalls[0].setVisible(false);
+
+		referee::addTurnScores(m_gamePlayers, m_activeTurn);
+		nextTurn(didFoul, hasPocketedBall);
+		++replayedTurns;
+	}
+
+	// the replay printed every turn, anything about the journal should still show
+	clearConsole();
+
+	// anything after the last replayed turn is dropped from the journal too
+	contents.validSize = sizeof(TurnJournal::Header) + replayedTurns * sizeof(TurnJournal::Turn);
+	if (!m_turnJournal.resume(path, contents))
+	{
+		// write it out again from what was replayed, rather than play on without one
+		std::cout << "Could not reopen turn journal " << path << ", rewriting it\n";
+
+		if (m_turnJournal.create(path, contents.header))
+		{
+			for (std::uint32_t i{}; i < replayedTurns; ++i)
+				m_turnJournal.append(contents.turns[i]);
+		}
+		else
+		{
+			std::cout << "Could not rewrite turn journal " << path << ", this match can't be resumed if the game closes\n";
+		}
+	}
+
+	m_turnNumber = replayedTurns;
+
+	// ball in hand starts with the stick put away, like after a foul in play
+	if (m_activeTurn.startWithBallInHand)
+	{
+		m_gameCueStick.setCanUpdate(false);
+		m_gameCueStick.setVisible(false);
+	}
+
+	std::cout << "[Resumed]: " << replayedTurns << " of " << contents.turns.size() << " turns replayed\n";
+	return true;
+}
+
+void GameLogic::endMatch()
+{
+	// an unfinished match keeps its journal for resuming
+	m_turnJournal.close();
+
+	if (m_matchCounters.ticks > 0)
+	{
+		std::cout << "[Match Physics]\n";
+		physics::printStepCounters(m_matchCounters);
+		std::cout << '\n';
+
+		if (!physics::getCountersPath().empty())
+		{
+			std::ofstream file{ physics::getCountersPath(), std::ios::app };
+			physics::writeStepCounters(file, "match", (m_gameMode == GameMode::practice) ? "practice" : "eight_ball", m_matchCounters);
+		}
+	}
+
+	if (m_frameTimings.getHistogram(FrameTimings::Phase::frame).getCount() > 0)
+	{
+		m_frameTimings.writeReport(std::cout);
+		std::cout << '\n';
+
+		std::ofstream file{ std::string{ consts::frameReportPath }, std::ios::app };
+		file << (m_gameMode == GameMode::practice ? "Practice" : "Eight-Ball") << ": "
+			<< m_gamePlayers.getPlayer(0).name << " vs " << m_gamePlayers.getPlayer(1).name << '\n';
+		m_frameTimings.writeReport(file);
+		file << '\n';
+	}
+}
+
+simulation::ShotParameters GameLogic::getAimedShot() const
+{
+	const Ball& cueBall{ m_gameBalls[0] };
+	const double deltaX{ m_input.getMouseX() - cueBall.getX() };
+	const double deltaY{ m_input.getMouseY() - cueBall.getY() };
+
+	return { std::atan2(deltaY, deltaX), static_cast<double>(m_gameCueStick.getCuePower()) };
+}
+
 void GameLogic::shootCueBall()
 {
 	const int cuePower{ m_gameCueStick.getCuePower() };
@@ -212,18 +638,99 @@ void GameLogic::shootCueBall()
 		m_gameCueStick.updateAll(cueBall.getX(), cueBall.getY());
 		m_gameCueStick.setCanUpdate(false);
 
+		m_shotStartBalls = m_gameBalls;
+		m_shotStartCounters = physics::getStepCounters();
+		m_lastShot = { std::atan2(normalized.getY(), normalized.getX()), static_cast<double>(cuePower) };
+
+		// the players haven't changed turns yet, so the coach scores it for the shooter
+		if (m_allegro.getRenderQuality().getTier().hudDetail >= RenderQuality::HudDetail::full)
+			m_shotCoach.analyze(m_shotStartBalls, m_gamePlayers, m_lastShot);
+		else
+			m_shotCoach.cancel();
+		m_hasReportedAdvice = false;
+
 		cueBall.setVelocity(normalized);
+		m_lastShotVelocity = normalized;
+
+		if (m_gameMode == GameMode::practice)
+			m_rewindBuffer.beginShot(m_gameBalls, m_gamePlayers, m_isShotFromBallInHand);
+		m_shotPredictor.pause();
+		m_trickShotSolution = {};
 		std::cout << "[Ball Shot] Power: " << cuePower << "\n\n";
 	}
 }
 
+void GameLogic::undoShot()
+{
+	// a finished shot has been journalled, one still rolling hasn't
+	const bool wasShotFinished{ !m_rewindBuffer.isRecording() };
+
+	RewindBuffer::Turn turn{};
+	if (!m_rewindBuffer.undo(m_gameBalls, m_gamePlayers, turn))
+	{
+		std::cout << "[Undo]: Nothing left to take back\n\n";
+		return;
+	}
+
+	// take the turn back out of the journal too, so resuming doesn't replay it
+	if (wasShotFinished && m_turnNumber > 0)
+	{
+		m_turnJournal.removeLastTurn();
+		--m_turnNumber;
+	}
+
+	m_isReviewing = false;
+	m_onTable = turn.visibleMask;
+	m_activeTurn = {};
+	m_activeTurn.startWithBallInHand = turn.isBallInHand;
+	m_isShotFromBallInHand = false;
+
+	m_gameCueStick.setCuePower(0);
+	m_gameCueStick.setCanUpdate(!turn.isBallInHand);
+	m_gameCueStick.setVisible(!turn.isBallInHand);
+
+	m_placementMap.clear();
+	m_distanceField.rebuild(m_gameBalls);
+	m_shotCoach.cancel();
+	m_shotPredictor.pause();
+	m_trickShotSolution = {};
+
+	std::cout << "[Undo]: Shot taken back, " << m_rewindBuffer.getTurnCount() << " more can be\n\n";
+}
+
+void GameLogic::updateReview()
+{
+	int tick{ m_reviewTick };
+	if (m_input.isKeyDown(ALLEGRO_KEY_LEFT))
+		tick -= consts::rewindScrubTicks;
+	if (m_input.isKeyDown(ALLEGRO_KEY_RIGHT))
+		tick += consts::rewindScrubTicks;
+
+	tick = std::clamp(tick, 0, m_rewindBuffer.getShotTicks());
+	if (tick != m_reviewTick)
+	{
+		m_reviewTick = tick;
+		m_rewindBuffer.reconstruct(m_reviewTick, m_reviewBalls);
+	}
+}
+
 bool GameLogic::endTurn()
 {
+	const trace::Scope traceScope{ "endTurn" };
+
 	clearConsole();
 
-	const bool hasPocketedBall{ m_activeTurn.pocketedBalls.size() > 0 };
+	// everything has stopped, so the resting balls are worth measuring again
+	m_distanceField.rebuild(m_gameBalls);
+
+	const bool hasPocketedBall{ m_activeTurn.pocketedBalls != 0 };
 	const bool didFoul{ !referee::isTurnValid(m_gamePlayers.getCurrentPlayer(), m_activeTurn) };
 
+	recordShot();
+	recordShotCounters();
+	journalTurn();
+	m_rewindBuffer.endShot();
+
 	std::cout << "[Turn Over]: Player (" << m_gamePlayers.getCurrentPlayer().name << ")\n";
 	std::cout << "Pocketed Balls: ";
 	//std::cout << "First Hit Ball Type: " << getBallTypeName(m_activeTurn.firstHitBallType) << '\n';
@@ -233,9 +740,10 @@ bool GameLogic::endTurn()
 	if (hasPocketedBall)
 	{
 		std::cout << '\n';
-		for (Ball* ball : m_activeTurn.pocketedBalls)
+		for (const Ball& ball : m_gameBalls)
 		{
-			std::cout << "- " << ball->getBallNumber() << " (" << getBallTypeName(ball->getBallType()) << ")\n";
+			if (m_activeTurn.pocketedBalls & ballMask::getBall(ball.getBallNumber()))
+				std::cout << "- " << ball.getBallNumber() << " (" << getBallTypeName(ball.getBallType()) << ")\n";
 		}
 	}
 	else
@@ -244,9 +752,29 @@ bool GameLogic::endTurn()
 	}
 	std::cout << '\n';
 
+	m_onTable = ballMask::getAfterTurn(m_onTable, m_activeTurn.pocketedBalls);
+
 	// check and handle game overs
-	if (referee::isGameFinished(m_gameBalls))
+	if (referee::isGameFinished(m_onTable))
 	{
+		m_turnJournal.discard();
+
+		if (m_gameMode == GameMode::practice)
+		{
+			std::cout << "[Practice Over]: The eight ball has been pocketed.\n\n";
+
+			al_show_native_message_box(
+				m_allegro.getDisplay(),
+				"Practice Over",
+				"The eight ball has been pocketed. Returning to the main menu.",
+				nullptr,
+				nullptr,
+				NULL
+			);
+
+			return true;
+		}
+
 		const std::string winnerName{ (!didFoul) ? m_gamePlayers.getCurrentPlayer().name : m_gamePlayers.getNextPlayer().name };
 
 		std::cout << "[Winner]: Player (" << winnerName << ")\n\n";
@@ -286,27 +814,17 @@ bool GameLogic::endTurn()
 		m_gameBalls[0].setVisible(true);
 	}
 
-	// add scores
-	if (hasPocketedBall && m_gamePlayers.getCurrentPlayer().targetBallType != Ball::BallSuitType::unknown)
-	{
-		for (Ball* pocketedBall : m_activeTurn.pocketedBalls)
-		{
-			for (Players::PlayerType& player : m_gamePlayers.getPlayerVector())
-			{
-				if (player.targetBallType == pocketedBall->getBallType())
-				{
-					player.score++;
-				}
-			}
-		}
-	}
+	referee::addTurnScores(m_gamePlayers, m_activeTurn);
 
 	// print scores
 	std::cout << "[Match Scores]\n";
 
 	for (const Players::PlayerType& player : m_gamePlayers.getPlayerVector())
 	{
-		std::cout << "Player (" << player.name << "): " << player.score << '\n';
+		std::cout << "Player (" << player.name << "): " << player.score;
+		if (player.targetBallType != Ball::BallSuitType::unknown)
+			std::cout << " (" << referee::getRemainingBallCount(m_onTable, player.targetBallType) << " left)";
+		std::cout << '\n';
 	}
 
 	std::cout << '\n';
@@ -317,8 +835,8 @@ bool GameLogic::endTurn()
 
 void GameLogic::nextTurn(const bool didFoul, const bool hasPocketedBall)
 {
-	// switch turns
-	if (didFoul || !hasPocketedBall)
+	// switch turns, in practice the same player shoots every time
+	if ((didFoul || !hasPocketedBall) && m_gameMode != GameMode::practice)
 	{
 		m_gamePlayers.advancePlayerIndex();
 	}
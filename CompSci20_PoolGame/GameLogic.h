@@ -2,12 +2,26 @@
 
 #include "AllegroHandler.h"
 #include "Input.h"
+#include "physics.h"
 #include "Players.h"
 #include "Ball.h"
 #include "CueStick.h"
+#include "FrameTimings.h"
+#include "PlacementMap.h"
+#include "RenderQuality.h"
+#include "RewindBuffer.h"
+#include "TableDistanceField.h"
+#include "ShotCoach.h"
+#include "ShotDifficultyTable.h"
+#include "ShotPredictor.h"
+#include "TrickShotSolver.h"
+#include "TurnJournal.h"
+#include "simulation.h"
 
 #include "Input.h"
 
+#include <cstdint>
+#include <future>
 #include <vector>
 #include <string>
 
@@ -20,22 +34,93 @@ private:
 
 	Players m_gamePlayers;
 	Ball::balls_type m_gameBalls;
+	// the balls on the table as of the last finished turn, see ballMask::getAfterTurn
+	ballMask_type m_onTable{};
 
 	CueStick m_gameCueStick{ true, true };
 	TurnInformation m_activeTurn{};
+	GameMode m_gameMode{};
 
 	double m_lastShotStartTime{};
 
+	// distances to the cushions, pockets and resting balls, rebuilt whenever the balls stop
+	TableDistanceField m_distanceField;
+
+	// legal ball in hand spots, built when placing starts
+	PlacementMap m_placementMap;
+
+	// the table and shot as they were when the cue ball was hit, for the shot recorder
+	Ball::balls_type m_shotStartBalls;
+	simulation::ShotParameters m_lastShot{};
+	bool m_isShotFromBallInHand{};
+
+	// every finished turn, so the match can be resumed after a crash
+	TurnJournal m_turnJournal;
+	Vector2 m_lastShotVelocity{};
+	std::uint32_t m_turnNumber{};
+
+	// stepPhysics counters, only the game's own ticks run on this thread
+	physics::StepCounters m_shotStartCounters{};
+	physics::StepCounters m_lastShotCounters{};
+	physics::StepCounters m_matchCounters{};
+	bool m_isShowingCounters{};
+	bool m_wasCountersKeyDown{};
+	bool m_wasLogKeyDown{};
+	bool m_isShowingPhysicsOverlay{};
+	bool m_wasOverlayKeyDown{};
+	bool m_wasQualityKeyDown{};
+
+	// every frame of the match, reported when it ends
+	FrameTimings m_frameTimings;
+	double m_lastFrameStart{ -1.0 };
+
+	// live "will this go in" estimate while aiming
+	ShotDifficultyTable m_difficultyTable;
+	ShotPredictor m_shotPredictor;
+
+	// what the best shot from the same table would have been, worked out after each shot
+	ShotCoach m_shotCoach;
+	bool m_hasReportedAdvice{};
+
+	// practice mode undo (Z) and review of the last shot (R, the arrow keys scrub)
+	RewindBuffer m_rewindBuffer;
+	Ball::balls_type m_reviewBalls;
+	int m_reviewTick{};
+	bool m_isReviewing{};
+	bool m_wasUndoKeyDown{};
+	bool m_wasReviewKeyDown{};
+
+	// practice mode trick shot hints, solved in the background
+	TrickShotSolver m_trickShotSolver;
+	TrickShotSolver::Target m_trickShotTarget{};
+	TrickShotSolver::Solution m_trickShotSolution{};
+	std::future<TrickShotSolver::Solution> m_pendingTrickShot;
+	bool m_wasHintKeyDown{};
+
+	void updateTrickShotHint();
+	void undoShot();
+	void updateReview();
+	void recordShot();
+	void recordShotCounters();
+	void startJournal(const std::string& trickShotTarget);
+	void journalTurn();
+	// replays the journal of the unfinished match, false if there isn't a usable one
+	bool resumeMatch(std::string& trickShotTarget);
+
 public:
-	GameLogic(AllegroHandler& allegro, const std::string& playerName1, const std::string& playerName2);
+	// isResuming picks the unfinished match back up from its journal, the names, mode and target are then ignored
+	GameLogic(AllegroHandler& allegro, const std::string& playerName1, const std::string& playerName2, const GameMode gameMode, const std::string& trickShotTarget, const bool isResuming);
 
 	bool endTurn();
 	void nextTurn(const bool didFoul, const bool hasPocketedBall);
 	void shootCueBall();
+	simulation::ShotParameters getAimedShot() const;
 
 	void updatePhysics();
 	void updateRender();
 
 	// returns true once the game has ended
 	bool frameUpdate();
+	// when leaving the match, however it ended, reports the physics counters and frame times
+	void endMatch();
 };
@@ -0,0 +1,195 @@
+#include "HardwareCounters.h"
+
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif // __linux__
+
+bool HardwareCounters::Sample::has(const Event event) const
+{
+	return isCounted[static_cast<int>(event)];
+}
+
+std::uint64_t HardwareCounters::Sample::get(const Event event) const
+{
+	return values[static_cast<int>(event)];
+}
+
+double HardwareCounters::Sample::getInstructionsPerCycle() const
+{
+	if (!has(Event::cycles) || !has(Event::instructions) || get(Event::cycles) == 0)
+		return 0.0;
+
+	return static_cast<double>(get(Event::instructions)) / get(Event::cycles);
+}
+
+HardwareCounters::HardwareCounters()
+{
+	m_descriptors.fill(-1);
+}
+
+HardwareCounters::~HardwareCounters()
+{
+#ifdef __linux__
+	for (const int descriptor : m_descriptors)
+	{
+		if (descriptor >= 0)
+			close(descriptor);
+	}
+#endif // __linux__
+}
+
+#ifdef __linux__
+static perf_event_attr getEventAttributes(const HardwareCounters::Event event)
+{
+	perf_event_attr attributes{};
+	attributes.size = sizeof(attributes);
+	attributes.disabled = 1;
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+	// time enabled and running, for scaling multiplexed counts
+	attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	switch (event)
+	{
+	case HardwareCounters::Event::cycles:
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+		break;
+	case HardwareCounters::Event::instructions:
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+		break;
+	case HardwareCounters::Event::branchMisses:
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+		break;
+	case HardwareCounters::Event::l1DataMisses:
+		attributes.type = PERF_TYPE_HW_CACHE;
+		attributes.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		break;
+	default:
+		attributes.type = PERF_TYPE_HW_CACHE;
+		attributes.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		break;
+	}
+
+	return attributes;
+}
+#endif // __linux__
+
+bool HardwareCounters::open()
+{
+#ifdef __linux__
+	for (int eventIndex{}; eventIndex < eventCount; ++eventIndex)
+	{
+		if (m_descriptors[eventIndex] >= 0)
+			continue;
+
+		perf_event_attr attributes{ getEventAttributes(static_cast<Event>(eventIndex)) };
+		// this thread, any cpu
+		m_descriptors[eventIndex] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+
+		if (m_descriptors[eventIndex] < 0 && m_error.empty())
+		{
+			m_error = std::string{ "perf_event_open: " } + std::strerror(errno);
+			if (errno == EACCES || errno == EPERM)
+				m_error += " (check /proc/sys/kernel/perf_event_paranoid)";
+		}
+	}
+
+	if (isOpen())
+		m_error.clear();
+	return isOpen();
+#else
+	m_error = "hardware counters are only read on linux";
+	return false;
+#endif // __linux__
+}
+
+bool HardwareCounters::isOpen() const
+{
+	for (const int descriptor : m_descriptors)
+	{
+		if (descriptor >= 0)
+			return true;
+	}
+	return false;
+}
+
+const std::string& HardwareCounters::getError() const
+{
+	return m_error;
+}
+
+void HardwareCounters::start()
+{
+#ifdef __linux__
+	for (const int descriptor : m_descriptors)
+	{
+		if (descriptor < 0)
+			continue;
+
+		ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+		ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif // __linux__
+}
+
+HardwareCounters::Sample HardwareCounters::stop()
+{
+	Sample sample{};
+
+#ifdef __linux__
+	// disabled first so reading the others isn't counted
+	for (const int descriptor : m_descriptors)
+	{
+		if (descriptor >= 0)
+			ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+	}
+
+	for (int eventIndex{}; eventIndex < eventCount; ++eventIndex)
+	{
+		if (m_descriptors[eventIndex] < 0)
+			continue;
+
+		// value, time enabled, time running
+		std::uint64_t values[3]{};
+		if (read(m_descriptors[eventIndex], values, sizeof(values)) != sizeof(values) || values[2] == 0)
+			continue;
+
+		sample.values[eventIndex] = (values[2] < values[1])
+			? static_cast<std::uint64_t>(static_cast<double>(values[0]) * values[1] / values[2])
+			: values[0];
+		sample.isCounted[eventIndex] = true;
+	}
+#endif // __linux__
+
+	return sample;
+}
+
+const char* HardwareCounters::getEventName(const Event event)
+{
+	switch (event)
+	{
+	case Event::cycles:
+		return "cycles";
+	case Event::instructions:
+		return "instructions";
+	case Event::branchMisses:
+		return "branch misses";
+	case Event::l1DataMisses:
+		return "L1D misses";
+	case Event::lastLevelMisses:
+		return "LLC misses";
+	default:
+		return "unknown";
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// cpu performance counters around a block of code, for judging physics changes
+// by what the cpu actually did instead of only wall time
+// - linux only (perf_event_open), counts this thread in user space
+// - every event is opened on its own, so a cpu or vm that lacks one still
+//   reports the rest, and counts are scaled up if the kernel had to multiplex
+class HardwareCounters
+{
+public:
+	enum class Event
+	{
+		cycles,
+		instructions,
+		branchMisses,
+		l1DataMisses, // l1 data cache read misses
+		lastLevelMisses, // llc misses
+		count
+	};
+
+	static constexpr int eventCount{ static_cast<int>(Event::count) };
+
+	struct Sample
+	{
+		std::array<std::uint64_t, eventCount> values{};
+		std::array<bool, eventCount> isCounted{};
+
+		bool has(const Event event) const;
+		std::uint64_t get(const Event event) const;
+		// instructions per cycle, 0 if either wasn't counted
+		double getInstructionsPerCycle() const;
+	};
+
+private:
+	std::array<int, eventCount> m_descriptors{};
+	std::string m_error;
+
+public:
+	HardwareCounters();
+	~HardwareCounters();
+
+	HardwareCounters(const HardwareCounters&) = delete;
+	HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+	// false if no event could be opened, getError says why
+	bool open();
+	bool isOpen() const;
+	const std::string& getError() const;
+
+	// zeroes and starts every open event
+	void start();
+	// stops them and returns the counts since start
+	Sample stop();
+
+	static const char* getEventName(const Event event);
+};
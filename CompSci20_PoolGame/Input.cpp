@@ -1,6 +1,7 @@
 #include "Input.h"
 
 #include "Vector2.h"
+#include "view.h"
 
 #include <allegro5/allegro5.h>
 
@@ -56,19 +57,24 @@ ALLEGRO_MOUSE_STATE& Input::getMouseState()
 	return m_mouseState;
 }
 
-int Input::getMouseX()
+void Input::setView(const view::Transform& transform)
 {
-	return m_mouseState.x;
+	m_view = transform;
 }
 
-int Input::getMouseY()
+double Input::getMouseX()
 {
-	return m_mouseState.y;
+	return getMouseVector().getX();
+}
+
+double Input::getMouseY()
+{
+	return getMouseVector().getY();
 }
 
 Vector2 Input::getMouseVector()
 {
-	return Vector2(m_mouseState.x, m_mouseState.y);
+	return view::toWorld(m_view, m_mouseState.x, m_mouseState.y);
 }
 
 void Input::updateAllStates()
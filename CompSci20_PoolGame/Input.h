@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Vector2.h"
+#include "view.h"
 
 #include <allegro5/allegro5.h>
 
@@ -17,6 +18,7 @@ private:
 	const int m_keyReleased{ 2 };
 
 	ALLEGRO_MOUSE_STATE m_mouseState;
+	view::Transform m_view{};
 	std::array<char, ALLEGRO_KEY_MAX> m_keyStates;
 
 public:
@@ -33,8 +35,10 @@ public:
 	ALLEGRO_MOUSE_STATE& getMouseState();
 	void updateMouseState();
 
+	// the mouse position is in world units, the view it's mapped through is kept up to date by AllegroHandler
+	void setView(const view::Transform& transform);
 	bool isMouseButtonDown(int button);
 	Vector2 getMouseVector();
-	int getMouseX();
-	int getMouseY();
+	double getMouseX();
+	double getMouseY();
 };
@@ -0,0 +1,133 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <string>
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	HANDLE file{ CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping{ CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view{ MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) };
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_data = static_cast<const unsigned char*>(view);
+	m_size = static_cast<std::size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mappingHandle)
+		CloseHandle(m_mappingHandle);
+	if (m_fileHandle)
+		CloseHandle(m_fileHandle);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_mappingHandle = nullptr;
+	m_fileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	const int fileDescriptor{ ::open(path.c_str(), O_RDONLY) };
+	if (fileDescriptor < 0)
+		return false;
+
+	struct stat fileStatus {};
+	if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		::close(fileDescriptor);
+		return false;
+	}
+
+	void* view{ mmap(nullptr, static_cast<std::size_t>(fileStatus.st_size), PROT_READ, MAP_SHARED, fileDescriptor, 0) };
+	if (view == MAP_FAILED)
+	{
+		::close(fileDescriptor);
+		return false;
+	}
+
+	m_fileDescriptor = fileDescriptor;
+	m_data = static_cast<const unsigned char*>(view);
+	m_size = static_cast<std::size_t>(fileStatus.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+	if (m_fileDescriptor >= 0)
+		::close(m_fileDescriptor);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_fileDescriptor = -1;
+}
+
+#endif // _WIN32
+
+bool MappedFile::isOpen() const
+{
+	return m_data != nullptr;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+	return m_data;
+}
+
+std::size_t MappedFile::getSize() const
+{
+	return m_size;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// read only memory mapping of a whole file, the OS pages it in on demand
+// so large tables and datasets cost nothing until they are touched
+class MappedFile
+{
+private:
+	const unsigned char* m_data{};
+	std::size_t m_size{};
+
+#ifdef _WIN32
+	// HANDLEs, kept as void* so Windows.h stays out of the header
+	void* m_fileHandle{};
+	void* m_mappingHandle{};
+#else
+	int m_fileDescriptor{ -1 };
+#endif
+
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const;
+	const unsigned char* getData() const;
+	std::size_t getSize() const;
+};
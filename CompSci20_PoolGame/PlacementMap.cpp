@@ -0,0 +1,216 @@
+#include "PlacementMap.h"
+
+#include "common.h"
+#include "constants.h"
+#include "TableDistanceField.h"
+#include "Vector2.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+PlacementMap::PlacementMap()
+	: m_columns{ (consts::playSurface.xPos2 - consts::playSurface.xPos1 + consts::distanceFieldCellSize - 1) / consts::distanceFieldCellSize },
+	m_rows{ (consts::playSurface.yPos2 - consts::playSurface.yPos1 + consts::distanceFieldCellSize - 1) / consts::distanceFieldCellSize }
+{
+}
+
+void PlacementMap::buildNearestCells()
+{
+	m_nearestLegal.assign(m_legal.size(), Cell{});
+	for (int row{}; row < m_rows; ++row)
+	{
+		for (int column{}; column < m_columns; ++column)
+		{
+			if (m_legal[static_cast<std::size_t>(row) * m_columns + column])
+				m_nearestLegal[static_cast<std::size_t>(row) * m_columns + column] = { static_cast<std::int16_t>(column), static_cast<std::int16_t>(row) };
+		}
+	}
+
+	// hands each cell's closest legal cell on to its neighbours, once down
+	// the grid and once back up, which is close enough to the true closest
+	const auto offerNeighbour{ [this](const int column, const int row, const int neighbourColumn, const int neighbourRow) {
+		if (neighbourColumn < 0 || neighbourColumn >= m_columns || neighbourRow < 0 || neighbourRow >= m_rows)
+			return;
+
+		const Cell candidate{ m_nearestLegal[static_cast<std::size_t>(neighbourRow) * m_columns + neighbourColumn] };
+		if (candidate.column < 0)
+			return;
+
+		Cell& nearest{ m_nearestLegal[static_cast<std::size_t>(row) * m_columns + column] };
+		const auto getDistanceSquared{ [column, row](const Cell& cell) {
+			const int deltaX{ cell.column - column };
+			const int deltaY{ cell.row - row };
+			return deltaX * deltaX + deltaY * deltaY;
+		} };
+
+		if (nearest.column < 0 || getDistanceSquared(candidate) < getDistanceSquared(nearest))
+			nearest = candidate;
+	} };
+
+	for (int row{}; row < m_rows; ++row)
+	{
+		for (int column{}; column < m_columns; ++column)
+		{
+			offerNeighbour(column, row, column - 1, row);
+			offerNeighbour(column, row, column - 1, row - 1);
+			offerNeighbour(column, row, column, row - 1);
+			offerNeighbour(column, row, column + 1, row - 1);
+		}
+		for (int column{ m_columns - 1 }; column >= 0; --column)
+			offerNeighbour(column, row, column + 1, row);
+	}
+
+	for (int row{ m_rows - 1 }; row >= 0; --row)
+	{
+		for (int column{ m_columns - 1 }; column >= 0; --column)
+		{
+			offerNeighbour(column, row, column + 1, row);
+			offerNeighbour(column, row, column + 1, row + 1);
+			offerNeighbour(column, row, column, row + 1);
+			offerNeighbour(column, row, column - 1, row + 1);
+		}
+		for (int column{}; column < m_columns; ++column)
+			offerNeighbour(column, row, column - 1, row);
+	}
+}
+
+void PlacementMap::buildBlockedAreas()
+{
+	m_blockedAreas.clear();
+
+	// runs of illegal cells, stacked onto the rectangle above when they line up
+	std::vector<std::size_t> openAreas;
+	std::vector<std::size_t> nextOpenAreas;
+
+	for (int row{}; row < m_rows; ++row)
+	{
+		const int top{ consts::playSurface.yPos1 + row * consts::distanceFieldCellSize };
+		const int bottom{ std::min(top + consts::distanceFieldCellSize, consts::playSurface.yPos2) };
+		nextOpenAreas.clear();
+
+		for (int column{}; column < m_columns;)
+		{
+			if (m_legal[static_cast<std::size_t>(row) * m_columns + column])
+			{
+				++column;
+				continue;
+			}
+
+			const int firstColumn{ column };
+			while (column < m_columns && !m_legal[static_cast<std::size_t>(row) * m_columns + column])
+				++column;
+
+			const int left{ consts::playSurface.xPos1 + firstColumn * consts::distanceFieldCellSize };
+			const int right{ std::min(consts::playSurface.xPos1 + column * consts::distanceFieldCellSize, consts::playSurface.xPos2) };
+
+			const auto above{ std::find_if(openAreas.begin(), openAreas.end(), [this, left, right](const std::size_t area) {
+				return m_blockedAreas[area].xPos1 == left && m_blockedAreas[area].xPos2 == right;
+			}) };
+
+			if (above != openAreas.end())
+			{
+				m_blockedAreas[*above].yPos2 = bottom;
+				nextOpenAreas.push_back(*above);
+			}
+			else
+			{
+				m_blockedAreas.push_back({ left, top, right, bottom });
+				nextOpenAreas.push_back(m_blockedAreas.size() - 1);
+			}
+		}
+
+		openAreas.swap(nextOpenAreas);
+	}
+}
+
+void PlacementMap::rebuild(const TableDistanceField& distanceField, const double radius)
+{
+	const double cellSize{ static_cast<double>(consts::distanceFieldCellSize) };
+	const double halfDiagonal{ cellSize * std::sqrt(2.0) / 2.0 };
+
+	m_legal.assign(static_cast<std::size_t>(m_columns) * m_rows, 0);
+
+	// the distances are exact at the cell centres, so moving anywhere in the cell
+	// brings a pocket or ball no closer than half the diagonal, and a cushion no
+	// closer than half the cell
+	for (int row{}; row < m_rows; ++row)
+	{
+		for (int column{}; column < m_columns; ++column)
+		{
+			m_legal[static_cast<std::size_t>(row) * m_columns + column] =
+				distanceField.getCellCushionClearance(column, row) - cellSize / 2.0 >= radius
+				&& distanceField.getCellPocketClearance(column, row) - halfDiagonal > radius
+				&& distanceField.getCellBallClearance(column, row, ballMask::cue) - halfDiagonal > radius;
+		}
+	}
+
+	buildNearestCells();
+	buildBlockedAreas();
+	m_isBuilt = true;
+}
+
+void PlacementMap::clear()
+{
+	m_isBuilt = false;
+}
+
+bool PlacementMap::isBuilt() const
+{
+	return m_isBuilt;
+}
+
+int PlacementMap::getCellIndex(const double xPos, const double yPos) const
+{
+	const int column{ static_cast<int>(std::floor((xPos - consts::playSurface.xPos1) / consts::distanceFieldCellSize)) };
+	const int row{ static_cast<int>(std::floor((yPos - consts::playSurface.yPos1) / consts::distanceFieldCellSize)) };
+
+	if (column < 0 || column >= m_columns || row < 0 || row >= m_rows)
+		return -1;
+
+	return row * m_columns + column;
+}
+
+bool PlacementMap::isValid(const double xPos, const double yPos) const
+{
+	const int cell{ getCellIndex(xPos, yPos) };
+	return m_isBuilt && cell >= 0 && m_legal[cell];
+}
+
+bool PlacementMap::isValid(const Vector2& position) const
+{
+	return isValid(position.getX(), position.getY());
+}
+
+bool PlacementMap::findNearestValid(const Vector2& position, Vector2& nearest) const
+{
+	if (!m_isBuilt)
+		return false;
+
+	if (isValid(position))
+	{
+		nearest = position;
+		return true;
+	}
+
+	// off the table counts as the closest edge cell
+	const double cellSize{ static_cast<double>(consts::distanceFieldCellSize) };
+	const int column{ std::clamp(static_cast<int>(std::floor((position.getX() - consts::playSurface.xPos1) / cellSize)), 0, m_columns - 1) };
+	const int row{ std::clamp(static_cast<int>(std::floor((position.getY() - consts::playSurface.yPos1) / cellSize)), 0, m_rows - 1) };
+
+	const Cell& cell{ m_nearestLegal[static_cast<std::size_t>(row) * m_columns + column] };
+	if (cell.column < 0)
+		return false;
+
+	nearest = Vector2{
+		consts::playSurface.xPos1 + (cell.column + 0.5) * cellSize,
+		consts::playSurface.yPos1 + (cell.row + 0.5) * cellSize
+	};
+	return true;
+}
+
+const std::vector<Rectangle>& PlacementMap::getBlockedAreas() const
+{
+	return m_blockedAreas;
+}
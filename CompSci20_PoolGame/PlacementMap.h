@@ -0,0 +1,57 @@
+#pragma once
+
+#include "common.h"
+#include "TableDistanceField.h"
+#include "Vector2.h"
+
+#include <cstdint>
+#include <vector>
+
+// where the cue ball can go with ball in hand, worked out once per placement
+// instead of checking every ball each time the mouse moves
+// - uses the cells of the table's distance field, a cell is legal only if the
+//   cue ball fits anywhere inside it (clear of the cushions, the pockets and
+//   every other ball), so a legal cell never gives a slightly overlapping spot
+// - every cell also knows the closest legal cell, for snapping to it
+class PlacementMap
+{
+private:
+	int m_columns{};
+	int m_rows{};
+
+	struct Cell
+	{
+		std::int16_t column{ -1 }; // -1 if there is nowhere legal
+		std::int16_t row{ -1 };
+	};
+
+	std::vector<std::uint8_t> m_legal;
+	std::vector<Cell> m_nearestLegal;
+
+	// the illegal cells merged into rectangles, for shading them in
+	std::vector<Rectangle> m_blockedAreas;
+	bool m_isBuilt{};
+
+	void buildNearestCells();
+	void buildBlockedAreas();
+
+	int getCellIndex(const double xPos, const double yPos) const;
+
+public:
+	PlacementMap();
+
+	// radius is the cue ball's, which is never in its own way
+	void rebuild(const TableDistanceField& distanceField, const double radius);
+	void clear();
+	bool isBuilt() const;
+
+	// constant time, false anywhere off the play surface
+	bool isValid(const double xPos, const double yPos) const;
+	bool isValid(const Vector2& position) const;
+
+	// position itself if it is legal, otherwise the middle of the closest legal
+	// cell, false if the ball fits nowhere
+	bool findNearestValid(const Vector2& position, Vector2& nearest) const;
+
+	const std::vector<Rectangle>& getBlockedAreas() const;
+};
@@ -0,0 +1,308 @@
+#include "PositionIndex.h"
+
+#include "Ball.h"
+#include "constants.h"
+#include "ShotDataset.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+PositionIndex::features_type PositionIndex::getFeatures(
+	const std::array<float, shotDataset::maxBalls>& ballX,
+	const std::array<float, shotDataset::maxBalls>& ballY,
+	const std::uint16_t onTable,
+	const Ball::BallSuitType shooterSuit
+)
+{
+	// both axes are scaled by the table length so distances mean the same either way
+	const float left{ static_cast<float>(consts::playSurface.xPos1) };
+	const float top{ static_cast<float>(consts::playSurface.yPos1) };
+	const float scale{ 1.0f / static_cast<float>(consts::playSurface.xPos2 - consts::playSurface.xPos1) };
+	const float centreY{ static_cast<float>(consts::playSurface.yPos2 - consts::playSurface.yPos1) * 0.5f * scale };
+
+	features_type features{};
+
+	// a ball that isn't on the table is far from anywhere one could be
+	const auto setBall{ [&](const int ball, const int feature) {
+		const bool isOnTable{ ((onTable >> ball) & 1u) != 0 };
+		features[feature] = isOnTable ? (ballX[ball] - left) * scale : -1.0f;
+		features[feature + 1] = isOnTable ? (ballY[ball] - top) * scale : -1.0f;
+	} };
+
+	setBall(0, 0);
+	setBall(8, 2);
+
+	// which ball of a group is where doesn't matter, only how the group is spread out
+	const bool isShooterStriped{ shooterSuit == Ball::BallSuitType::striped };
+	for (int group{}; group < 2; ++group)
+	{
+		const bool isStriped{ (group == 0) == isShooterStriped };
+		const int firstBall{ isStriped ? 9 : 1 };
+
+		int count{};
+		float sumX{};
+		float sumY{};
+		float sumSquaresX{};
+		float sumSquaresY{};
+
+		for (int ball{ firstBall }; ball < firstBall + 7; ++ball)
+		{
+			if (((onTable >> ball) & 1u) == 0)
+				continue;
+
+			const float x{ (ballX[ball] - left) * scale };
+			const float y{ (ballY[ball] - top) * scale };
+			++count;
+			sumX += x;
+			sumY += y;
+			sumSquaresX += x * x;
+			sumSquaresY += y * y;
+		}
+
+		const int feature{ 4 + group * 5 };
+		features[feature] = count / 7.0f;
+
+		// an empty group sits in the middle of the table with no spread
+		const float meanX{ (count > 0) ? sumX / count : 0.5f };
+		const float meanY{ (count > 0) ? sumY / count : centreY };
+		features[feature + 1] = meanX;
+		features[feature + 2] = meanY;
+		features[feature + 3] = (count > 0) ? std::sqrt(std::max(0.0f, sumSquaresX / count - meanX * meanX)) : 0.0f;
+		features[feature + 4] = (count > 0) ? std::sqrt(std::max(0.0f, sumSquaresY / count - meanY * meanY)) : 0.0f;
+	}
+
+	return features;
+}
+
+PositionIndex::features_type PositionIndex::getFeatures(const Ball::balls_type& gameBalls, const Ball::BallSuitType shooterSuit)
+{
+	std::array<float, shotDataset::maxBalls> ballX{};
+	std::array<float, shotDataset::maxBalls> ballY{};
+	for (int i{}; i < static_cast<int>(gameBalls.size()) && i < shotDataset::maxBalls; ++i)
+	{
+		ballX[i] = static_cast<float>(gameBalls[i].getX());
+		ballY[i] = static_cast<float>(gameBalls[i].getY());
+	}
+
+	return getFeatures(ballX, ballY, ballMask::getOnTable(gameBalls), shooterSuit);
+}
+
+bool PositionIndex::addDataset(const std::string& path)
+{
+	ShotDatasetReader reader;
+	if (!reader.load(path))
+		return false;
+
+	const int ballXColumn{ reader.findColumn("ball_x") };
+	const int ballYColumn{ reader.findColumn("ball_y") };
+	const int onTableColumn{ reader.findColumn("on_table") };
+	const int targetSuitColumn{ reader.findColumn("target_suit") };
+	const int sourceColumn{ reader.findColumn("source") };
+
+	if (ballXColumn < 0 || ballYColumn < 0 || onTableColumn < 0 || targetSuitColumn < 0 || sourceColumn < 0)
+		return false;
+
+	const std::uint32_t file{ static_cast<std::uint32_t>(m_files.size()) };
+	m_files.push_back(path);
+	m_nodes.clear();
+
+	std::uint32_t firstRow{};
+	for (int block{}; block < reader.getBlockCount(); ++block)
+	{
+		const float* ballX{ reader.getColumnValues<float>(block, ballXColumn) };
+		const float* ballY{ reader.getColumnValues<float>(block, ballYColumn) };
+		const std::uint16_t* onTable{ reader.getColumnValues<std::uint16_t>(block, onTableColumn) };
+		const std::uint8_t* targetSuits{ reader.getColumnValues<std::uint8_t>(block, targetSuitColumn) };
+		const std::uint8_t* sources{ reader.getColumnValues<std::uint8_t>(block, sourceColumn) };
+
+		for (int row{}; row < reader.getBlockRowCount(block); ++row)
+		{
+			// every simulated shot starts from a table that was played anyway
+			if (sources[row] != static_cast<std::uint8_t>(shotDataset::Source::played))
+				continue;
+
+			std::array<float, shotDataset::maxBalls> x{};
+			std::array<float, shotDataset::maxBalls> y{};
+			std::copy_n(ballX + row * shotDataset::maxBalls, shotDataset::maxBalls, x.begin());
+			std::copy_n(ballY + row * shotDataset::maxBalls, shotDataset::maxBalls, y.begin());
+
+			Entry entry{};
+			entry.features = getFeatures(x, y, onTable[row], static_cast<Ball::BallSuitType>(targetSuits[row]));
+			entry.file = file;
+			entry.row = firstRow + static_cast<std::uint32_t>(row);
+			m_entries.push_back(entry);
+		}
+
+		firstRow += static_cast<std::uint32_t>(reader.getBlockRowCount(block));
+	}
+
+	return true;
+}
+
+void PositionIndex::addEntry(const Entry& entry)
+{
+	m_entries.push_back(entry);
+	m_nodes.clear();
+}
+
+std::uint32_t PositionIndex::buildNode(const std::uint32_t begin, const std::uint32_t end)
+{
+	const std::uint32_t nodeIndex{ static_cast<std::uint32_t>(m_nodes.size()) };
+	m_nodes.emplace_back();
+
+	if (end - begin <= leafSize)
+	{
+		m_nodes[nodeIndex].isLeaf = true;
+		m_nodes[nodeIndex].first = begin;
+		m_nodes[nodeIndex].second = end;
+		return nodeIndex;
+	}
+
+	// split the widest dimension at the median
+	features_type lowest{ m_entries[begin].features };
+	features_type highest{ m_entries[begin].features };
+	for (std::uint32_t i{ begin + 1 }; i < end; ++i)
+	{
+		for (int feature{}; feature < featureCount; ++feature)
+		{
+			lowest[feature] = std::min(lowest[feature], m_entries[i].features[feature]);
+			highest[feature] = std::max(highest[feature], m_entries[i].features[feature]);
+		}
+	}
+
+	std::uint32_t dimension{};
+	for (int feature{ 1 }; feature < featureCount; ++feature)
+	{
+		if (highest[feature] - lowest[feature] > highest[dimension] - lowest[dimension])
+			dimension = static_cast<std::uint32_t>(feature);
+	}
+
+	const std::uint32_t middle{ begin + (end - begin) / 2 };
+	std::nth_element(m_entries.begin() + begin, m_entries.begin() + middle, m_entries.begin() + end, [dimension](const Entry& a, const Entry& b) {
+		return a.features[dimension] < b.features[dimension];
+	});
+
+	// the children can move m_nodes around, so nothing holds onto a reference
+	const std::uint32_t left{ buildNode(begin, middle) };
+	const std::uint32_t right{ buildNode(middle, end) };
+
+	Node& node{ m_nodes[nodeIndex] };
+	node.split = m_entries[middle].features[dimension];
+	node.dimension = dimension;
+	node.first = left;
+	node.second = right;
+	return nodeIndex;
+}
+
+void PositionIndex::build()
+{
+	m_nodes.clear();
+	if (m_entries.empty())
+		return;
+
+	m_nodes.reserve(m_entries.size() / leafSize * 2 + 1);
+	buildNode(0, static_cast<std::uint32_t>(m_entries.size()));
+}
+
+void PositionIndex::clear()
+{
+	m_files.clear();
+	m_entries.clear();
+	m_nodes.clear();
+}
+
+bool PositionIndex::isBuilt() const
+{
+	return !m_nodes.empty();
+}
+
+std::size_t PositionIndex::getEntryCount() const
+{
+	return m_entries.size();
+}
+
+const PositionIndex::Entry& PositionIndex::getEntry(const std::size_t entry) const
+{
+	return m_entries[entry];
+}
+
+const std::string& PositionIndex::getFilePath(const std::uint32_t file) const
+{
+	return m_files[file];
+}
+
+std::vector<PositionIndex::Neighbour> PositionIndex::findNearest(const features_type& query, const int count, const int maxChecks) const
+{
+	std::vector<Neighbour> neighbours;
+	if (!isBuilt() || count <= 0)
+		return neighbours;
+
+	// unexplored branches, closest possible distance first
+	using bin_type = std::pair<float, std::uint32_t>;
+	std::priority_queue<bin_type, std::vector<bin_type>, std::greater<bin_type>> bins;
+	bins.push({ 0.0f, 0 });
+
+	// the best so far, worst on top
+	const auto isCloser{ [](const Neighbour& a, const Neighbour& b) { return a.distanceSquared < b.distanceSquared; } };
+	std::priority_queue<Neighbour, std::vector<Neighbour>, decltype(isCloser)> best{ isCloser };
+
+	int checks{};
+	while (!bins.empty())
+	{
+		auto [bound, nodeIndex] = bins.top();
+		bins.pop();
+
+		if (static_cast<int>(best.size()) == count && bound >= best.top().distanceSquared)
+			break;
+		if (maxChecks > 0 && checks >= maxChecks)
+			break;
+
+		// down to the leaf on the query's side, leaving the other sides for later
+		while (!m_nodes[nodeIndex].isLeaf)
+		{
+			const Node& node{ m_nodes[nodeIndex] };
+			const float difference{ query[node.dimension] - node.split };
+
+			bins.push({ std::max(bound, difference * difference), (difference < 0.0f) ? node.second : node.first });
+			nodeIndex = (difference < 0.0f) ? node.first : node.second;
+		}
+
+		const Node& leaf{ m_nodes[nodeIndex] };
+		for (std::uint32_t i{ leaf.first }; i < leaf.second; ++i)
+		{
+			float distanceSquared{};
+			for (int feature{}; feature < featureCount; ++feature)
+			{
+				const float difference{ query[feature] - m_entries[i].features[feature] };
+				distanceSquared += difference * difference;
+			}
+			++checks;
+
+			if (static_cast<int>(best.size()) < count)
+			{
+				best.push({ &m_entries[i], distanceSquared });
+			}
+			else if (distanceSquared < best.top().distanceSquared)
+			{
+				best.pop();
+				best.push({ &m_entries[i], distanceSquared });
+			}
+		}
+	}
+
+	neighbours.resize(best.size());
+	for (auto neighbour{ neighbours.rbegin() }; neighbour != neighbours.rend(); ++neighbour)
+	{
+		*neighbour = best.top();
+		best.pop();
+	}
+
+	return neighbours;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Ball.h"
+#include "ShotDataset.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// k nearest neighbour search over archived table positions
+// - a position is turned into a short feature vector that doesn't care which
+//   ball of a group is where, only about the cue ball, the eight ball and how
+//   the shooter's and the opponent's groups are spread over the table
+// - the vectors go into a k-d tree (flat arrays, small leaves), searched best
+//   bin first, either exactly or giving up after a set number of positions
+class PositionIndex
+{
+public:
+	// cue x y, eight x y, then for the shooter's group and the other group:
+	// count, mean x y, spread x y
+	static constexpr int featureCount{ 14 };
+	using features_type = std::array<float, featureCount>;
+
+	struct Entry
+	{
+		features_type features{};
+		std::uint32_t file{};
+		std::uint32_t row{}; // within the file
+	};
+
+	struct Neighbour
+	{
+		const Entry* entry{};
+		float distanceSquared{};
+	};
+
+private:
+	struct Node
+	{
+		float split{};
+		std::uint32_t dimension{};
+		// children for a split, entries for a leaf
+		std::uint32_t first{};
+		std::uint32_t second{};
+		bool isLeaf{};
+	};
+
+	static constexpr int leafSize{ 16 };
+
+	std::vector<std::string> m_files;
+	std::vector<Entry> m_entries; // reordered so every leaf is one range
+	std::vector<Node> m_nodes;
+
+	std::uint32_t buildNode(const std::uint32_t begin, const std::uint32_t end);
+
+public:
+	// positions with the table still open count solids as the shooter's group
+	static features_type getFeatures(
+		const std::array<float, shotDataset::maxBalls>& ballX,
+		const std::array<float, shotDataset::maxBalls>& ballY,
+		const std::uint16_t onTable,
+		const Ball::BallSuitType shooterSuit
+	);
+	static features_type getFeatures(const Ball::balls_type& gameBalls, const Ball::BallSuitType shooterSuit);
+
+	// adds the table before every played shot in the file, the index has to be built again after
+	bool addDataset(const std::string& path);
+	void addEntry(const Entry& entry);
+	void build();
+	void clear();
+
+	bool isBuilt() const;
+	std::size_t getEntryCount() const;
+	const Entry& getEntry(const std::size_t entry) const;
+	const std::string& getFilePath(const std::uint32_t file) const;
+
+	// closest first, maxChecks = 0 searches exhaustively, otherwise the search
+	// stops after that many positions have been compared (approximate)
+	std::vector<Neighbour> findNearest(const features_type& query, const int count, const int maxChecks = 0) const;
+};
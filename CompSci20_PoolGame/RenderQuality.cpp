@@ -0,0 +1,88 @@
+#include "RenderQuality.h"
+
+#include "constants.h"
+#include "FrameTimings.h"
+
+#include <iostream>
+#include <string_view>
+
+const RenderQuality::Tier& RenderQuality::getTier() const
+{
+	return tiers[m_tier];
+}
+
+int RenderQuality::getTierIndex() const
+{
+	return m_tier;
+}
+
+bool RenderQuality::isSettled() const
+{
+	return m_isSettled;
+}
+
+bool RenderQuality::isOverridden() const
+{
+	return m_isOverridden;
+}
+
+void RenderQuality::setOverride(const int tier)
+{
+	if (tier < 0 || tier >= static_cast<int>(tiers.size()))
+		return;
+
+	m_tier = tier;
+	m_isOverridden = true;
+	m_isSettled = true;
+}
+
+bool RenderQuality::findTier(std::string_view name, int& tier)
+{
+	for (std::size_t i{}; i < tiers.size(); ++i)
+	{
+		if (tiers[i].name == name)
+		{
+			tier = static_cast<int>(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void RenderQuality::restartBenchmark()
+{
+	m_measuredSeconds = 0.0;
+	m_frameTimes = {};
+}
+
+bool RenderQuality::recordFrame(const double frameSeconds)
+{
+	if (m_isSettled)
+		return false;
+
+	m_measuredSeconds += frameSeconds;
+	if (m_measuredSeconds < consts::qualityWarmupSeconds)
+		return false;
+
+	m_frameTimes.record(frameSeconds);
+	if (m_measuredSeconds < consts::qualityWarmupSeconds + consts::qualityBenchmarkSeconds)
+		return false;
+
+	const double frameTime{ m_frameTimes.getPercentileSeconds(consts::qualityPercentile) };
+	const bool doesHold{ frameTime <= consts::frameTime * consts::qualityFrameSlack };
+
+	std::cout << "[Render Quality] " << tiers[m_tier].name << ": p" << static_cast<int>(consts::qualityPercentile * 100.0 + 0.5)
+		<< " frame " << frameTime * 1000.0 << " ms over " << m_frameTimes.getCount() << " frames"
+		<< (doesHold ? ", keeping it\n\n" : ", too slow\n\n");
+
+	if (doesHold || m_tier + 1 >= static_cast<int>(tiers.size()))
+	{
+		m_isSettled = true;
+		return false;
+	}
+
+	++m_tier;
+	restartBenchmark();
+	return true;
+}
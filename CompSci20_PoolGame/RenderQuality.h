@@ -0,0 +1,66 @@
+#pragma once
+
+#include "FrameTimings.h"
+
+#include <array>
+#include <string_view>
+
+// how much the game draws, picked from the frame times of the first seconds of play
+// - every tier starts with qualityWarmupSeconds that aren't counted, so display
+//   creation and the first sprite rasterizing don't count against it
+// - a tier holds if qualityPercentile of its frames arrive within qualityFrameSlack
+//   of a 60 Hz frame, otherwise the next tier down is tried
+// - once one holds (or the lowest is reached) it stays for the session
+// - an override skips all of this
+class RenderQuality
+{
+public:
+	enum class HudDetail
+	{
+		minimal, // the table, the balls and what's needed to play
+		standard, // plus the aim guide and the shot prediction
+		full // plus the coach
+	};
+
+	struct Tier
+	{
+		std::string_view name;
+		int multisamples{}; // 0 turns multisampling off
+		bool isLinearFiltering{};
+		// primitives get the display's multisampling, sprites are drawn without it but cost a blit
+		bool hasBallSprites{};
+		HudDetail hudDetail{};
+	};
+
+	// best first
+	static constexpr std::array<Tier, 4> tiers
+	{ {
+		{ "high", 8, true, false, HudDetail::full },
+		{ "medium", 4, true, true, HudDetail::full },
+		{ "low", 0, true, true, HudDetail::standard },
+		{ "minimal", 0, false, true, HudDetail::minimal }
+	} };
+
+private:
+	int m_tier{};
+	bool m_isSettled{};
+	bool m_isOverridden{};
+
+	double m_measuredSeconds{};
+	FrameTimings::Histogram m_frameTimes{};
+
+	void restartBenchmark();
+
+public:
+	const Tier& getTier() const;
+	int getTierIndex() const;
+	bool isSettled() const;
+	bool isOverridden() const;
+
+	void setOverride(const int tier);
+	// false if there is no tier called name
+	static bool findTier(std::string_view name, int& tier);
+
+	// the time since the last frame started, true when the tier has just been lowered
+	bool recordFrame(const double frameSeconds);
+};
@@ -0,0 +1,289 @@
+#include "ReplayAnalyzer.h"
+
+#include "constants.h"
+#include "referee.h"
+#include "ShotDataset.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+ReplayAnalyzer::ReplayAnalyzer(const int threadCount)
+	: m_threadCount{ std::max(1, threadCount) }
+{
+}
+
+void ReplayAnalyzer::Statistics::merge(const Statistics& other)
+{
+	files += other.files;
+	skippedFiles += other.skippedFiles;
+	matches += other.matches;
+	shots += other.shots;
+	fouledShots += other.fouledShots;
+	cueBallsPocketed += other.cueBallsPocketed;
+
+	for (std::size_t i{}; i < pocketCounts.size(); ++i)
+		pocketCounts[i] += other.pocketCounts[i];
+	for (std::size_t i{}; i < foulCounts.size(); ++i)
+		foulCounts[i] += other.foulCounts[i];
+	for (std::size_t i{}; i < cueRestCounts.size(); ++i)
+		cueRestCounts[i] += other.cueRestCounts[i];
+
+	for (const auto& [name, player] : other.players)
+	{
+		PlayerStatistics& merged{ players[name] };
+		merged.matches += player.matches;
+		merged.shots += player.shots;
+		merged.successfulShots += player.successfulShots;
+		merged.fouledShots += player.fouledShots;
+		merged.ballsPocketed += player.ballsPocketed;
+	}
+}
+
+bool ReplayAnalyzer::findReplays(const std::string& directory, std::vector<std::string>& paths)
+{
+	std::error_code error;
+	std::filesystem::directory_iterator iterator{ directory, error };
+	if (error)
+		return false;
+
+	for (const std::filesystem::directory_entry& entry : iterator)
+	{
+		if (entry.is_regular_file(error))
+			paths.push_back(entry.path().string());
+	}
+
+	std::sort(paths.begin(), paths.end());
+	return true;
+}
+
+void ReplayAnalyzer::analyzeFile(const std::string& path, Statistics& statistics)
+{
+	++statistics.files;
+
+	ShotDatasetReader reader;
+	if (!reader.load(path))
+	{
+		++statistics.skippedFiles;
+		return;
+	}
+
+	const int pocketedColumn{ reader.findColumn("pocketed") };
+	const int pocketCountsColumn{ reader.findColumn("pocket_counts") };
+	const int foulColumn{ reader.findColumn("fouls") };
+	const int cueRestXColumn{ reader.findColumn("cue_rest_x") };
+	const int cueRestYColumn{ reader.findColumn("cue_rest_y") };
+	const int sourceColumn{ reader.findColumn("source") };
+	const int playerColumn{ reader.findColumn("player") };
+	const int matchColumn{ reader.findColumn("match") };
+
+	if (pocketedColumn < 0 || pocketCountsColumn < 0 || foulColumn < 0 || cueRestXColumn < 0
+		|| cueRestYColumn < 0 || sourceColumn < 0 || playerColumn < 0 || matchColumn < 0)
+	{
+		++statistics.skippedFiles;
+		return;
+	}
+
+	// the names are looked up once per file rather than per shot
+	std::array<PlayerStatistics*, 2> players{};
+	for (int i{}; i < 2; ++i)
+	{
+		const std::string_view name{ reader.getPlayerName(i) };
+		players[i] = &statistics.players[name.empty() ? "Player " + std::to_string(i + 1) : std::string{ name }];
+	}
+
+	// a file may hold many matches (e.g. a whole tournament recorded with --record-shots)
+	std::set<std::uint32_t> matches;
+	std::set<std::pair<std::uint32_t, int>> playerMatches;
+	long long playedShots{};
+
+	const double cellWidth{ static_cast<double>(consts::playSurface.xPos2 - consts::playSurface.xPos1) / heatmapColumns };
+	const double cellHeight{ static_cast<double>(consts::playSurface.yPos2 - consts::playSurface.yPos1) / heatmapRows };
+
+	for (int block{}; block < reader.getBlockCount(); ++block)
+	{
+		const std::uint16_t* pocketed{ reader.getColumnValues<std::uint16_t>(block, pocketedColumn) };
+		const std::uint8_t* pocketCounts{ reader.getColumnValues<std::uint8_t>(block, pocketCountsColumn) };
+		const std::uint8_t* fouls{ reader.getColumnValues<std::uint8_t>(block, foulColumn) };
+		const float* cueRestX{ reader.getColumnValues<float>(block, cueRestXColumn) };
+		const float* cueRestY{ reader.getColumnValues<float>(block, cueRestYColumn) };
+		const std::uint8_t* sources{ reader.getColumnValues<std::uint8_t>(block, sourceColumn) };
+		const std::uint8_t* playerIndexes{ reader.getColumnValues<std::uint8_t>(block, playerColumn) };
+		const std::uint32_t* matchIds{ reader.getColumnValues<std::uint32_t>(block, matchColumn) };
+
+		for (int row{}; row < reader.getBlockRowCount(block); ++row)
+		{
+			// simulated shots are what the ai thought about, not what happened
+			if (sources[row] != static_cast<std::uint8_t>(shotDataset::Source::played) || playerIndexes[row] > 1)
+				continue;
+
+			++playedShots;
+			matches.insert(matchIds[row]);
+			playerMatches.insert({ matchIds[row], playerIndexes[row] });
+
+			const bool didFoul{ fouls[row] != 0 };
+			const int ballsPocketed{ static_cast<int>(std::bitset<16>{ pocketed[row] & ~1u }.count()) };
+
+			PlayerStatistics& player{ *players[playerIndexes[row]] };
+			++player.shots;
+			player.successfulShots += (!didFoul && ballsPocketed > 0);
+			player.fouledShots += didFoul;
+			player.ballsPocketed += ballsPocketed;
+
+			statistics.fouledShots += didFoul;
+			for (int foul{}; foul < referee::foulTypeCount; ++foul)
+				statistics.foulCounts[foul] += (fouls[row] >> foul) & 1u;
+
+			for (int pocket{}; pocket < shotDataset::pocketCount; ++pocket)
+				statistics.pocketCounts[pocket] += pocketCounts[row * shotDataset::pocketCount + pocket];
+
+			if (std::isnan(cueRestX[row]))
+			{
+				++statistics.cueBallsPocketed;
+				continue;
+			}
+
+			const int column{ std::clamp(static_cast<int>((cueRestX[row] - consts::playSurface.xPos1) / cellWidth), 0, heatmapColumns - 1) };
+			const int heatmapRow{ std::clamp(static_cast<int>((cueRestY[row] - consts::playSurface.yPos1) / cellHeight), 0, heatmapRows - 1) };
+			++statistics.cueRestCounts[heatmapRow * heatmapColumns + column];
+		}
+	}
+
+	if (playedShots == 0)
+	{
+		++statistics.skippedFiles;
+		return;
+	}
+
+	statistics.shots += playedShots;
+	statistics.matches += static_cast<long long>(matches.size());
+	for (const auto& [match, player] : playerMatches)
+		++players[player]->matches;
+}
+
+ReplayAnalyzer::Statistics ReplayAnalyzer::analyze(const std::vector<std::string>& paths) const
+{
+	const int threadCount{ std::clamp(m_threadCount, 1, std::max(1, static_cast<int>(paths.size()))) };
+
+	// one accumulator per thread, nothing is shared until the merge
+	std::vector<Statistics> threadStatistics(threadCount);
+	std::atomic<std::size_t> nextFile{};
+
+	std::vector<std::thread> threads;
+	for (int i{}; i < threadCount; ++i)
+	{
+		threads.emplace_back([&paths, &nextFile, &statistics = threadStatistics[i]]() {
+			for (std::size_t file{ nextFile++ }; file < paths.size(); file = nextFile++)
+				analyzeFile(paths[file], statistics);
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	Statistics statistics{};
+	for (const Statistics& partial : threadStatistics)
+		statistics.merge(partial);
+
+	return statistics;
+}
+
+void ReplayAnalyzer::printStatistics(const Statistics& statistics)
+{
+	const double shotCount{ static_cast<double>(std::max(1LL, statistics.shots)) };
+
+	std::cout << "[Replay Analysis]\n";
+	std::cout << "Files: " << statistics.files << " (" << statistics.skippedFiles << " skipped)\n";
+	std::cout << "Matches: " << statistics.matches << '\n';
+	std::cout << "Shots: " << statistics.shots << "\n\n";
+
+	std::cout << std::fixed << std::setprecision(1);
+
+	// laid out like the table, pockets 0-2 along the top and 3-5 along the bottom
+	long long pocketedBalls{};
+	for (const long long count : statistics.pocketCounts)
+		pocketedBalls += count;
+
+	std::cout << "[Pocket Usage] " << pocketedBalls << " balls\n";
+	for (int side{}; side < 2; ++side)
+	{
+		for (int i{}; i < 3; ++i)
+		{
+			const long long count{ statistics.pocketCounts[side * 3 + i] };
+			std::cout << std::setw(10) << count << " (" << std::setw(4) << count * 100.0 / std::max(1LL, pocketedBalls) << "%)";
+		}
+		std::cout << '\n';
+	}
+
+	// darker = the cue ball stopped there more often
+	static constexpr char shades[]{ " .:-=+*#%@" };
+	static constexpr int shadeCount{ sizeof(shades) - 2 };
+
+	const long long mostRests{ *std::max_element(statistics.cueRestCounts.begin(), statistics.cueRestCounts.end()) };
+	std::cout << "\n[Cue Ball Rest] " << statistics.cueBallsPocketed << " pocketed (" << statistics.cueBallsPocketed / shotCount * 100.0 << "%)\n";
+	std::cout << '+' << std::string(heatmapColumns, '-') << "+\n";
+	for (int row{}; row < heatmapRows; ++row)
+	{
+		std::cout << '|';
+		for (int column{}; column < heatmapColumns; ++column)
+		{
+			const long long count{ statistics.cueRestCounts[row * heatmapColumns + column] };
+			// square root so the quieter areas still show up next to the break spot
+			const int shade{ (count == 0 || mostRests == 0) ? 0
+				: std::max(1, static_cast<int>(std::round(std::sqrt(static_cast<double>(count) / mostRests) * shadeCount))) };
+			std::cout << shades[shade];
+		}
+		std::cout << "|\n";
+	}
+	std::cout << '+' << std::string(heatmapColumns, '-') << "+\n";
+
+	std::cout << "\n[Fouls] " << statistics.fouledShots / shotCount * 100.0 << "% of shots\n";
+	for (int foul{}; foul < referee::foulTypeCount; ++foul)
+		std::cout << referee::getFoulName(1u << foul) << ": " << statistics.foulCounts[foul] / shotCount * 100.0 << "%\n";
+
+	std::cout << "\n[Players]\n";
+	std::cout << std::left << std::setw(16) << "Name" << std::right << std::setw(8) << "Matches" << std::setw(9) << "Shots"
+		<< std::setw(10) << "Success" << std::setw(8) << "Fouls" << std::setw(12) << "Balls/Shot" << '\n';
+	for (const auto& [name, player] : statistics.players)
+	{
+		if (player.shots == 0)
+			continue;
+
+		const double playerShots{ static_cast<double>(player.shots) };
+		std::cout << std::left << std::setw(16) << name << std::right << std::setw(8) << player.matches << std::setw(9) << player.shots
+			<< std::setw(9) << player.successfulShots / playerShots * 100.0 << '%'
+			<< std::setw(7) << player.fouledShots / playerShots * 100.0 << '%'
+			<< std::setw(12) << std::setprecision(2) << player.ballsPocketed / playerShots << std::setprecision(1) << '\n';
+	}
+	std::cout << '\n' << std::defaultfloat;
+}
+
+bool ReplayAnalyzer::writeHeatmap(const Statistics& statistics, const std::string& path)
+{
+	std::ofstream file{ path, std::ios::trunc };
+	if (!file)
+		return false;
+
+	for (int row{}; row < heatmapRows; ++row)
+	{
+		for (int column{}; column < heatmapColumns; ++column)
+			file << ((column > 0) ? "," : "") << statistics.cueRestCounts[row * heatmapColumns + column];
+		file << '\n';
+	}
+
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "referee.h"
+#include "ShotDataset.h"
+
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+// aggregate stats over a directory of recorded matches (shot dataset files)
+// - map: every worker thread takes the next file, maps it and adds its played
+//   shots into its own Statistics, no locks or shared counters while scanning
+// - reduce: the per-thread Statistics are merged once all the files are done
+class ReplayAnalyzer
+{
+public:
+	// cue ball resting positions over the play surface
+	static constexpr int heatmapColumns{ 48 };
+	static constexpr int heatmapRows{ 24 };
+
+	struct PlayerStatistics
+	{
+		long long matches{};
+		long long shots{};
+		long long successfulShots{}; // potted a ball without fouling
+		long long fouledShots{};
+		long long ballsPocketed{};
+	};
+
+	struct Statistics
+	{
+		long long files{};
+		long long skippedFiles{}; // not a dataset, or no played shots
+		long long matches{};
+		long long shots{};
+		long long fouledShots{};
+
+		std::array<long long, shotDataset::pocketCount> pocketCounts{};
+		std::array<long long, referee::foulTypeCount> foulCounts{};
+
+		std::array<long long, heatmapColumns * heatmapRows> cueRestCounts{};
+		long long cueBallsPocketed{};
+
+		// keyed by the names in the file header, "Player 1" and "Player 2" if it has none
+		std::map<std::string, PlayerStatistics> players;
+
+		void merge(const Statistics& other);
+	};
+
+private:
+	int m_threadCount{ 1 };
+
+	static void analyzeFile(const std::string& path, Statistics& statistics);
+
+public:
+	ReplayAnalyzer() = default;
+	ReplayAnalyzer(const int threadCount);
+
+	// every regular file in the directory, sorted so runs are repeatable
+	static bool findReplays(const std::string& directory, std::vector<std::string>& paths);
+
+	Statistics analyze(const std::vector<std::string>& paths) const;
+
+	static void printStatistics(const Statistics& statistics);
+	// one row per heatmap row, counts separated by commas
+	static bool writeHeatmap(const Statistics& statistics, const std::string& path);
+};
@@ -0,0 +1,246 @@
+#include "RewindBuffer.h"
+
+#include "Ball.h"
+#include "common.h"
+#include "physics.h"
+#include "Players.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+RewindBuffer::RewindBuffer()
+	: RewindBuffer{ Config{} }
+{
+}
+
+RewindBuffer::RewindBuffer(const Config& config)
+	: m_config{ config }
+{
+	m_config.turnCapacity = std::max(m_config.turnCapacity, 1);
+	m_config.keyframeCapacity = std::max(m_config.keyframeCapacity, 1);
+	m_config.ballStateCapacity = std::max(m_config.ballStateCapacity, maxBalls);
+	m_config.keyframeTicks = std::max(m_config.keyframeTicks, 1);
+
+	m_turns.resize(m_config.turnCapacity);
+	m_keyframes.resize(m_config.keyframeCapacity);
+	m_ballStates.resize(m_config.ballStateCapacity);
+}
+
+const RewindBuffer::Config& RewindBuffer::getConfig() const
+{
+	return m_config;
+}
+
+std::size_t RewindBuffer::getMemoryBytes() const
+{
+	return m_turns.size() * sizeof(Turn) + m_keyframes.size() * sizeof(Keyframe) + m_ballStates.size() * sizeof(BallState);
+}
+
+void RewindBuffer::clear()
+{
+	m_nextTurn = 0;
+	m_turnCount = 0;
+	m_isRecording = false;
+	m_oldestKeyframe = m_keyframesWritten;
+	m_oldestBallState = m_ballStatesWritten;
+}
+
+RewindBuffer::Turn& RewindBuffer::getNewestTurn()
+{
+	return m_turns[(m_nextTurn + m_turns.size() - 1) % m_turns.size()];
+}
+
+const RewindBuffer::Turn& RewindBuffer::getNewestTurn() const
+{
+	return m_turns[(m_nextTurn + m_turns.size() - 1) % m_turns.size()];
+}
+
+bool RewindBuffer::beginShot(const Ball::balls_type& gameBalls, const Players& gamePlayers, const bool isBallInHand)
+{
+	if (gameBalls.size() > maxBalls || gamePlayers.getPlayerCount() > maxPlayers)
+		return false;
+
+	Turn& turn{ m_turns[m_nextTurn] };
+	turn = {};
+
+	for (std::size_t i{}; i < gameBalls.size(); ++i)
+	{
+		turn.ballX[i] = gameBalls[i].getX();
+		turn.ballY[i] = gameBalls[i].getY();
+	}
+
+	turn.visibleMask = ballMask::getOnTable(gameBalls);
+	turn.cueVelocityX = gameBalls[0].getVX();
+	turn.cueVelocityY = gameBalls[0].getVY();
+
+	// Players has no const getPlayer
+	Players players{ gamePlayers };
+	for (int i{}; i < players.getPlayerCount(); ++i)
+	{
+		turn.scores[i] = players.getPlayer(i).score;
+		turn.targetBallTypes[i] = players.getPlayer(i).targetBallType;
+	}
+
+	turn.currentPlayer = static_cast<std::uint8_t>(players.getCurrentIndex());
+	turn.isBallInHand = isBallInHand;
+	turn.firstKeyframe = m_keyframesWritten;
+	turn.firstBallState = m_ballStatesWritten;
+
+	m_nextTurn = (m_nextTurn + 1) % m_turns.size();
+	m_turnCount = std::min(m_turnCount + 1, static_cast<int>(m_turns.size()));
+	m_isRecording = true;
+	return true;
+}
+
+void RewindBuffer::recordTick(const Ball::balls_type& gameBalls)
+{
+	if (!m_isRecording)
+		return;
+
+	Turn& turn{ getNewestTurn() };
+	++turn.shotTicks;
+
+	if (turn.shotTicks % m_config.keyframeTicks == 0)
+		writeKeyframe(turn, gameBalls);
+}
+
+void RewindBuffer::writeKeyframe(const Turn& turn, const Ball::balls_type& gameBalls)
+{
+	Keyframe& keyframe{ m_keyframes[m_keyframesWritten % m_keyframes.size()] };
+	keyframe = {};
+	keyframe.firstBallState = m_ballStatesWritten;
+	keyframe.tick = turn.shotTicks;
+	keyframe.visibleMask = ballMask::getOnTable(gameBalls);
+
+	// the delta, balls that are still where the shot left them are rebuilt from the turn
+	for (std::size_t i{}; i < gameBalls.size(); ++i)
+	{
+		// pocketed balls too, where they went down is part of the table checksum
+		const Ball& ball{ gameBalls[i] };
+		if (ball.getX() == turn.ballX[i] && ball.getY() == turn.ballY[i] && ball.getVX() == 0.0 && ball.getVY() == 0.0)
+			continue;
+
+		m_ballStates[m_ballStatesWritten % m_ballStates.size()] = { ball.getX(), ball.getY(), ball.getVX(), ball.getVY(), static_cast<std::uint8_t>(i) };
+		++m_ballStatesWritten;
+		++keyframe.ballStateCount;
+	}
+
+	++m_keyframesWritten;
+	if (m_keyframesWritten - m_oldestKeyframe > m_keyframes.size())
+		m_oldestKeyframe = m_keyframesWritten - m_keyframes.size();
+	if (m_ballStatesWritten - m_oldestBallState > m_ballStates.size())
+		m_oldestBallState = m_ballStatesWritten - m_ballStates.size();
+}
+
+bool RewindBuffer::isKeyframeValid(const std::uint64_t keyframe) const
+{
+	return keyframe >= m_oldestKeyframe && keyframe < m_keyframesWritten
+		&& m_keyframes[keyframe % m_keyframes.size()].firstBallState >= m_oldestBallState;
+}
+
+void RewindBuffer::endShot()
+{
+	if (m_isRecording)
+		getNewestTurn().isShotFinished = true;
+
+	m_isRecording = false;
+}
+
+bool RewindBuffer::isRecording() const
+{
+	return m_isRecording;
+}
+
+int RewindBuffer::getTurnCount() const
+{
+	return m_turnCount;
+}
+
+int RewindBuffer::getShotTicks() const
+{
+	return (m_turnCount > 0) ? getNewestTurn().shotTicks : 0;
+}
+
+void RewindBuffer::restoreTable(const Turn& turn, Ball::balls_type& gameBalls, Players& gamePlayers)
+{
+	for (std::size_t i{}; i < gameBalls.size(); ++i)
+	{
+		gameBalls[i].setPosition(turn.ballX[i], turn.ballY[i]);
+		gameBalls[i].setVelocity(0, 0);
+		gameBalls[i].setVisible((turn.visibleMask & ballMask::getBall(gameBalls[i].getBallNumber())) != 0);
+	}
+
+	for (int i{}; i < gamePlayers.getPlayerCount(); ++i)
+	{
+		gamePlayers.getPlayer(i).score = turn.scores[i];
+		gamePlayers.getPlayer(i).targetBallType = turn.targetBallTypes[i];
+	}
+
+	gamePlayers.setPlayerIndex(turn.currentPlayer);
+}
+
+bool RewindBuffer::undo(Ball::balls_type& gameBalls, Players& gamePlayers, Turn& turn)
+{
+	if (m_turnCount == 0 || gameBalls.size() > maxBalls)
+		return false;
+
+	turn = getNewestTurn();
+	restoreTable(turn, gameBalls, gamePlayers);
+
+	m_nextTurn = (m_nextTurn + m_turns.size() - 1) % m_turns.size();
+	--m_turnCount;
+	m_isRecording = false;
+
+	// the shot's keyframes are the newest ones, so their space is handed back,
+	// anything they overwrote stays gone
+	m_keyframesWritten = std::max(turn.firstKeyframe, m_oldestKeyframe);
+	m_ballStatesWritten = std::max(turn.firstBallState, m_oldestBallState);
+	return true;
+}
+
+bool RewindBuffer::reconstruct(int tick, Ball::balls_type& gameBalls) const
+{
+	if (m_turnCount == 0 || gameBalls.size() > maxBalls)
+		return false;
+
+	const Turn& turn{ getNewestTurn() };
+	tick = std::clamp(tick, 0, turn.shotTicks);
+
+	// the shot's keyframes are evenly spaced, so the nearest one is worked out
+	// rather than searched for, falling back to earlier ones if it was overwritten
+	int keyframeIndex{ tick / m_config.keyframeTicks - 1 };
+	while (keyframeIndex >= 0 && !isKeyframeValid(turn.firstKeyframe + keyframeIndex))
+		--keyframeIndex;
+
+	Players players{ maxPlayers };
+	restoreTable(turn, gameBalls, players);
+
+	int startTick{};
+	if (keyframeIndex >= 0)
+	{
+		const Keyframe& keyframe{ m_keyframes[(turn.firstKeyframe + keyframeIndex) % m_keyframes.size()] };
+		startTick = keyframe.tick;
+
+		for (std::size_t i{}; i < gameBalls.size(); ++i)
+			gameBalls[i].setVisible((keyframe.visibleMask & ballMask::getBall(gameBalls[i].getBallNumber())) != 0);
+
+		for (int i{}; i < keyframe.ballStateCount; ++i)
+		{
+			const BallState& state{ m_ballStates[(keyframe.firstBallState + i) % m_ballStates.size()] };
+			gameBalls[state.ballNumber].setPosition(state.x, state.y);
+			gameBalls[state.ballNumber].setVelocity(state.vx, state.vy);
+		}
+	}
+	else
+	{
+		gameBalls[0].setVelocity(turn.cueVelocityX, turn.cueVelocityY);
+	}
+
+	// the same ticks the game ran, without the sound
+	TurnInformation turnInformation{};
+	for (int i{ startTick }; i < tick; ++i)
+		physics::stepPhysics(gameBalls, players, turnInformation);
+
+	return true;
+}
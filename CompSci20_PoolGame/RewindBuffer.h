@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Ball.h"
+#include "common.h"
+#include "constants.h"
+#include "Players.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// practice mode undo and shot review, in a fixed amount of memory
+// - one Turn per shot, the table at rest just before it, which is all undo needs
+// - every keyframeTicks ticks of a shot a keyframe, which only stores the balls
+//   that differ from the shot's Turn, so the balls that never moved cost nothing
+// - scrubbing rebuilds the nearest keyframe at or before the tick and
+//   re-simulates the rest, at most keyframeTicks - 1 ticks
+// all three are rings allocated up front, the oldest entries are overwritten,
+// a keyframe whose ball states were overwritten is skipped for an earlier one
+class RewindBuffer
+{
+public:
+	static constexpr int maxBalls{ 16 };
+	static constexpr int maxPlayers{ 2 };
+
+	struct Config
+	{
+		int turnCapacity{ consts::rewindTurns };
+		int keyframeCapacity{ consts::rewindKeyframes };
+		int ballStateCapacity{ consts::rewindBallStates };
+		int keyframeTicks{ consts::rewindKeyframeTicks };
+	};
+
+	struct Turn
+	{
+		std::array<double, maxBalls> ballX{};
+		std::array<double, maxBalls> ballY{};
+		ballMask_type visibleMask{};
+		std::array<int, maxPlayers> scores{};
+		std::array<Ball::BallSuitType, maxPlayers> targetBallTypes{};
+		std::uint8_t currentPlayer{};
+		bool isBallInHand{}; // the cue ball was placed for this shot
+		bool isShotFinished{};
+		double cueVelocityX{};
+		double cueVelocityY{};
+		int shotTicks{};
+		// where this shot's keyframes start in the rings
+		std::uint64_t firstKeyframe{};
+		std::uint64_t firstBallState{};
+	};
+
+private:
+	struct Keyframe
+	{
+		std::uint64_t firstBallState{};
+		int tick{};
+		ballMask_type visibleMask{};
+		std::uint8_t ballStateCount{};
+	};
+
+	struct BallState
+	{
+		double x{};
+		double y{};
+		double vx{};
+		double vy{};
+		std::uint8_t ballNumber{};
+	};
+
+	Config m_config;
+
+	std::vector<Turn> m_turns;
+	std::size_t m_nextTurn{};
+	int m_turnCount{};
+	bool m_isRecording{};
+
+	// sequence numbers, the ring slot is the number modulo the capacity,
+	// anything older than the oldest number has been overwritten
+	std::vector<Keyframe> m_keyframes;
+	std::uint64_t m_keyframesWritten{};
+	std::uint64_t m_oldestKeyframe{};
+
+	std::vector<BallState> m_ballStates;
+	std::uint64_t m_ballStatesWritten{};
+	std::uint64_t m_oldestBallState{};
+
+	Turn& getNewestTurn();
+	const Turn& getNewestTurn() const;
+	void writeKeyframe(const Turn& turn, const Ball::balls_type& gameBalls);
+	bool isKeyframeValid(const std::uint64_t keyframe) const;
+
+	static void restoreTable(const Turn& turn, Ball::balls_type& gameBalls, Players& gamePlayers);
+
+public:
+	RewindBuffer();
+	explicit RewindBuffer(const Config& config);
+
+	const Config& getConfig() const;
+	std::size_t getMemoryBytes() const;
+	void clear();
+
+	// call once the cue ball has its velocity, false if the table is too big to keep
+	bool beginShot(const Ball::balls_type& gameBalls, const Players& gamePlayers, const bool isBallInHand);
+	// after every stepPhysics tick of the shot
+	void recordTick(const Ball::balls_type& gameBalls);
+	void endShot();
+	bool isRecording() const;
+
+	int getTurnCount() const;
+	// ticks the newest shot took, so far if it's still rolling
+	int getShotTicks() const;
+
+	// puts the table back to before the newest shot and forgets it,
+	// turn is what was taken back
+	bool undo(Ball::balls_type& gameBalls, Players& gamePlayers, Turn& turn);
+	// the newest shot tick ticks in, gameBalls must already hold the same balls
+	bool reconstruct(int tick, Ball::balls_type& gameBalls) const;
+};
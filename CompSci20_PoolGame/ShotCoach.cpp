@@ -0,0 +1,123 @@
+#include "ShotCoach.h"
+
+#include "Ball.h"
+#include "Players.h"
+#include "common.h"
+#include "constants.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+double ShotCoach::Advice::getScoreDifference() const
+{
+	return std::max(0.0, bestOutcome.score - playedOutcome.score);
+}
+
+ShotCoach::ShotCoach()
+	: m_candidates{ simulation::generateCandidateShots(consts::coachAngles, consts::coachPowerLevels) }
+{
+	m_worker = std::thread{ &ShotCoach::workerLoop, this };
+}
+
+ShotCoach::~ShotCoach()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_isStopping = true;
+	}
+	m_workAvailable.notify_all();
+	m_worker.join();
+}
+
+void ShotCoach::analyze(const Ball::balls_type& gameBalls, const Players& gamePlayers, const simulation::ShotParameters& shot)
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_request.gameBalls = gameBalls;
+		m_request.gamePlayers = gamePlayers;
+		m_request.shot = shot;
+		m_advice = {};
+		m_hasRequest = true;
+		m_currentGeneration = ++m_generation;
+	}
+	m_workAvailable.notify_all();
+}
+
+void ShotCoach::cancel()
+{
+	std::lock_guard<std::mutex> lock{ m_mutex };
+	m_advice = {};
+	m_hasRequest = false;
+	m_currentGeneration = ++m_generation;
+}
+
+ShotCoach::Advice ShotCoach::getAdvice() const
+{
+	std::lock_guard<std::mutex> lock{ m_mutex };
+	return m_advice;
+}
+
+void ShotCoach::workerLoop()
+{
+	using clock = std::chrono::steady_clock;
+
+	lowerCurrentThreadPriority();
+
+	Request request{};
+	while (true)
+	{
+		std::uint64_t generation;
+		{
+			std::unique_lock<std::mutex> lock{ m_mutex };
+			m_workAvailable.wait(lock, [this]() { return m_isStopping || m_hasRequest; });
+
+			if (m_isStopping)
+				return;
+
+			request = m_request;
+			generation = m_generation;
+			m_hasRequest = false;
+		}
+
+		const auto isStale{ [this, generation]() { return m_currentGeneration.load() != generation; } };
+
+		Advice advice{};
+		advice.playedShot = request.shot;
+		advice.playedOutcome = simulation::simulateShot(request.gameBalls, request.gamePlayers, request.shot);
+		advice.bestShot = request.shot;
+		advice.bestOutcome = advice.playedOutcome;
+		advice.cueBallPosition = request.gameBalls[0].getPositionVector();
+		advice.shooterIndex = request.gamePlayers.getCurrentIndex();
+
+		for (const simulation::ShotParameters& candidate : m_candidates)
+		{
+			if (isStale())
+				break;
+
+			const clock::time_point start{ clock::now() };
+
+			const simulation::ShotOutcome outcome{ simulation::simulateShot(request.gameBalls, request.gamePlayers, candidate) };
+			if (outcome.score > advice.bestOutcome.score)
+			{
+				advice.bestShot = candidate;
+				advice.bestOutcome = outcome;
+			}
+			++advice.candidatesTried;
+
+			// rest for long enough that the work stays at the cpu share,
+			// a cancel wakes nothing up, the next candidate check catches it
+			const double busySeconds{ std::chrono::duration<double>(clock::now() - start).count() };
+			std::this_thread::sleep_for(std::chrono::duration<double>{ busySeconds * (1.0 - consts::coachCpuShare) / consts::coachCpuShare });
+		}
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		if (m_generation == generation)
+		{
+			advice.isReady = true;
+			m_advice = advice;
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Ball.h"
+#include "Players.h"
+#include "simulation.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// after each shot, searches for the best shot the player could have taken from
+// the same table, so the game can show what was left on the table
+// - one low priority worker that sleeps between candidate shots so it only takes
+//   coachCpuShare of a core, the frame loop and the predictor come first
+// - a new shot cancels the analysis of the last one within a candidate
+// - memory is the one table copy and the candidate list, whatever the search finds
+class ShotCoach
+{
+public:
+	struct Advice
+	{
+		bool isReady{};
+		simulation::ShotParameters playedShot{};
+		simulation::ShotOutcome playedOutcome{};
+		simulation::ShotParameters bestShot{};
+		simulation::ShotOutcome bestOutcome{};
+		Vector2 cueBallPosition{}; // where both shots were taken from
+		int shooterIndex{ -1 }; // only shown while this player is to shoot
+		int candidatesTried{};
+
+		// how much better the best shot scored, 0 if the player found it
+		double getScoreDifference() const;
+	};
+
+private:
+	struct Request
+	{
+		Ball::balls_type gameBalls;
+		Players gamePlayers{ 2 };
+		simulation::ShotParameters shot{};
+	};
+
+	Request m_request{};
+	Advice m_advice{};
+	std::uint64_t m_generation{}; // a new request or a cancel makes the running search stale
+	bool m_hasRequest{};
+	bool m_isStopping{};
+
+	// guards everything above, the worker holds it only to copy in and out
+	mutable std::mutex m_mutex;
+	std::condition_variable m_workAvailable;
+	std::atomic<std::uint64_t> m_currentGeneration{};
+
+	std::vector<simulation::ShotParameters> m_candidates;
+	std::thread m_worker;
+
+	void workerLoop();
+
+public:
+	ShotCoach();
+	~ShotCoach();
+
+	ShotCoach(const ShotCoach&) = delete;
+	ShotCoach& operator=(const ShotCoach&) = delete;
+
+	// the table and players from just before the shot was taken
+	void analyze(const Ball::balls_type& gameBalls, const Players& gamePlayers, const simulation::ShotParameters& shot);
+	void cancel();
+
+	// a copy, isReady is false until the whole search is done
+	Advice getAdvice() const;
+};
@@ -0,0 +1,558 @@
+#include "ShotDataset.h"
+
+#include "Ball.h"
+#include "MappedFile.h"
+#include "Players.h"
+#include "common.h"
+#include "referee.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// both are written and mapped as is, so their layout must not change
+static_assert(sizeof(shotDataset::FileHeader) == 88, "Shot dataset header layout changed");
+static_assert(sizeof(shotDataset::ColumnHeader) == 32, "Shot dataset column layout changed");
+static_assert(sizeof(shotDataset::BlockHeader) == 8, "Shot dataset block layout changed");
+
+// every column starts 8 byte aligned so mapped values can be read in place
+static std::size_t getPaddedSize(const std::size_t size)
+{
+	return (size + 7) & ~static_cast<std::size_t>(7);
+}
+
+// fixed size, zero padded text fields
+static std::string_view getFixedString(const char* text, const std::size_t size)
+{
+	return { text, static_cast<std::size_t>(std::find(text, text + size, '\0') - text) };
+}
+
+static shotDataset::ColumnHeader makeColumnHeader(const shotDataset::ColumnDefinition& definition)
+{
+	shotDataset::ColumnHeader header{};
+	std::memcpy(header.name, definition.name.data(), std::min(definition.name.size(), sizeof(header.name) - 1));
+	header.type = definition.type;
+	header.elementSize = static_cast<std::uint8_t>(shotDataset::getElementSize(definition.type));
+	header.elementCount = static_cast<std::uint16_t>(definition.elementCount);
+	return header;
+}
+
+namespace shotDataset
+{
+	int getElementSize(const ColumnType type)
+	{
+		switch (type)
+		{
+		case ColumnType::u8:
+		case ColumnType::i8:
+			return 1;
+		case ColumnType::u16:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	Row makeRow(
+		const Ball::balls_type& startBalls,
+		const Ball::balls_type& restingBalls,
+		const Players::PlayerType& shooter,
+		const simulation::ShotParameters& shot,
+		const TurnInformation& turn,
+		const int ticks
+	)
+	{
+		Row row{};
+
+		for (int i{}; i < static_cast<int>(startBalls.size()) && i < maxBalls; ++i)
+		{
+			row.ballX[i] = static_cast<float>(startBalls[i].getX());
+			row.ballY[i] = static_cast<float>(startBalls[i].getY());
+		}
+		row.onTable = ballMask::getOnTable(startBalls);
+
+		row.targetSuit = static_cast<std::uint8_t>(shooter.targetBallType);
+		row.score = static_cast<std::uint8_t>(shooter.score);
+		row.angle = static_cast<float>(shot.angle);
+		row.power = static_cast<float>(shot.power);
+		row.firstHitType = static_cast<std::uint8_t>(turn.firstHitBallType);
+		row.firstHitBall = static_cast<std::int8_t>(turn.firstHitBallNumber);
+
+		// pocketed balls stay where they dropped, so the closest pocket is the one they went in
+		row.pocketed = turn.pocketedBalls;
+		for (const Ball& ball : restingBalls)
+		{
+			if (turn.pocketedBalls & ballMask::getBall(ball.getBallNumber()))
+				++row.pocketCounts[simulation::getNearestPocketIndex(ball.getX(), ball.getY())];
+		}
+
+		row.fouls = static_cast<std::uint8_t>(referee::getFouls(shooter, turn));
+
+		const Ball& cueBall{ restingBalls[0] };
+		row.cueRestX = cueBall.isVisible() ? static_cast<float>(cueBall.getX()) : std::numeric_limits<float>::quiet_NaN();
+		row.cueRestY = cueBall.isVisible() ? static_cast<float>(cueBall.getY()) : std::numeric_limits<float>::quiet_NaN();
+		row.ticks = static_cast<std::uint16_t>(std::clamp(ticks, 0, 65535));
+
+		return row;
+	}
+
+	// where a column's value lives in a Row
+	static const void* getRowField(const Row& row, const int column)
+	{
+		switch (column)
+		{
+		case ballX: return row.ballX.data();
+		case ballY: return row.ballY.data();
+		case onTable: return &row.onTable;
+		case targetSuit: return &row.targetSuit;
+		case score: return &row.score;
+		case ballInHand: return &row.ballInHand;
+		case angle: return &row.angle;
+		case power: return &row.power;
+		case firstHitType: return &row.firstHitType;
+		case firstHitBall: return &row.firstHitBall;
+		case pocketed: return &row.pocketed;
+		case pocketCounts: return row.pocketCounts.data();
+		case fouls: return &row.fouls;
+		case cueRestX: return &row.cueRestX;
+		case cueRestY: return &row.cueRestY;
+		case source: return &row.source;
+		case player: return &row.player;
+		case match: return &row.match;
+		default: return &row.ticks;
+		}
+	}
+}
+
+static std::atomic<std::uint64_t> s_nextWriterId{ 1 };
+
+ShotDatasetWriter::ShotDatasetWriter()
+	: m_id{ s_nextWriterId.fetch_add(1, std::memory_order_relaxed) }
+{
+}
+
+ShotDatasetWriter::~ShotDatasetWriter()
+{
+	close();
+}
+
+bool ShotDatasetWriter::open(const std::string& path, const bool recordsPlayed, const bool recordsSimulated, const std::string& playerName1, const std::string& playerName2)
+{
+	close();
+
+	// pick up where an existing file of the same schema left off,
+	// dropping a block that was cut short by a crash
+	bool isAppending{};
+	{
+		ShotDatasetReader reader;
+		if (reader.load(path) && reader.getColumnCount() == static_cast<int>(shotDataset::columns.size()))
+		{
+			isAppending = true;
+			for (int i{}; i < reader.getColumnCount(); ++i)
+			{
+				const shotDataset::ColumnHeader expected{ makeColumnHeader(shotDataset::columns[i]) };
+				isAppending = isAppending && std::memcmp(&reader.getColumn(i), &expected, sizeof(expected)) == 0;
+			}
+
+			if (isAppending)
+			{
+				const std::size_t validSize{ reader.getValidSize() };
+				reader.close();
+
+				std::error_code error;
+				std::filesystem::resize_file(path, validSize, error);
+				isAppending = !error;
+			}
+		}
+	}
+
+	if (isAppending)
+	{
+		m_file.open(path, std::ios::binary | std::ios::app);
+	}
+	else
+	{
+		m_file.open(path, std::ios::binary | std::ios::trunc);
+
+		shotDataset::FileHeader header{};
+		header.columnCount = static_cast<std::uint32_t>(shotDataset::columns.size());
+		header.rowsPerBlock = shotDataset::rowsPerBlock;
+		std::memcpy(header.playerNames[0], playerName1.data(), std::min(playerName1.size(), sizeof(header.playerNames[0]) - 1));
+		std::memcpy(header.playerNames[1], playerName2.data(), std::min(playerName2.size(), sizeof(header.playerNames[1]) - 1));
+
+		m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (const shotDataset::ColumnDefinition& definition : shotDataset::columns)
+		{
+			const shotDataset::ColumnHeader columnHeader{ makeColumnHeader(definition) };
+			m_file.write(reinterpret_cast<const char*>(&columnHeader), sizeof(columnHeader));
+		}
+	}
+
+	if (!m_file)
+	{
+		m_file.close();
+		return false;
+	}
+
+	// room for a whole block, so appending never allocates
+	std::size_t offset{};
+	for (int i{}; i < static_cast<int>(shotDataset::columns.size()); ++i)
+	{
+		const std::size_t valueSize{ static_cast<std::size_t>(shotDataset::getElementSize(shotDataset::columns[i].type)) * shotDataset::columns[i].elementCount };
+		m_columnOffsets[i] = offset;
+		offset += getPaddedSize(valueSize * shotDataset::rowsPerBlock);
+	}
+	m_blockSize = sizeof(shotDataset::BlockHeader) + offset;
+
+	m_isStopping = false;
+	m_spareBlocks.clear();
+	m_writer = std::thread{ &ShotDatasetWriter::writeBlocks, this };
+
+	{
+		std::lock_guard<std::mutex> lock{ m_blocksMutex };
+		m_isOpen = true;
+
+		// threads that appended before close get their blocks back
+		for (const std::unique_ptr<Block>& block : m_blocks)
+		{
+			std::lock_guard<std::mutex> blockLock{ block->mutex };
+			block->columnData.assign(m_blockSize, 0);
+			block->rowCount = 0;
+			block->isAccepting = true;
+		}
+	}
+
+	m_recordsPlayed.store(recordsPlayed, std::memory_order_relaxed);
+	m_recordsSimulated.store(recordsSimulated, std::memory_order_relaxed);
+	return true;
+}
+
+void ShotDatasetWriter::close()
+{
+	std::lock_guard<std::mutex> lock{ m_blocksMutex };
+
+	if (!m_isOpen)
+		return;
+
+	m_isOpen = false;
+	m_recordsPlayed.store(false, std::memory_order_relaxed);
+	m_recordsSimulated.store(false, std::memory_order_relaxed);
+
+	// once a block stops accepting its thread never touches it again
+	for (const std::unique_ptr<Block>& block : m_blocks)
+	{
+		std::lock_guard<std::mutex> blockLock{ block->mutex };
+		block->isAccepting = false;
+	}
+
+	// the full blocks go first, then what every thread had left
+	{
+		std::lock_guard<std::mutex> queueLock{ m_queueMutex };
+		m_isStopping = true;
+	}
+	m_wakeup.notify_one();
+	m_writer.join();
+
+	for (const std::unique_ptr<Block>& block : m_blocks)
+		writePartialBlock(*block);
+
+	m_file.close();
+}
+
+bool ShotDatasetWriter::isOpen() const
+{
+	return m_file.is_open();
+}
+
+bool ShotDatasetWriter::isRecording(const shotDataset::Source source) const
+{
+	// only a hint, append checks its block again under the block's lock
+	return (source == shotDataset::Source::played)
+		? m_recordsPlayed.load(std::memory_order_relaxed)
+		: m_recordsSimulated.load(std::memory_order_relaxed);
+}
+
+ShotDatasetWriter::Block& ShotDatasetWriter::getThreadBlock()
+{
+	// the last few writers this thread appended to, a thread seldom has more than two
+	struct CachedBlock
+	{
+		std::uint64_t writerId{};
+		Block* block{};
+	};
+
+	static thread_local std::array<CachedBlock, 4> cache{};
+	static thread_local std::size_t nextCacheSlot{};
+
+	for (const CachedBlock& cached : cache)
+	{
+		if (cached.writerId == m_id)
+			return *cached.block;
+	}
+
+	std::lock_guard<std::mutex> lock{ m_blocksMutex };
+
+	// pushed out of the cache but still registered
+	const std::thread::id threadId{ std::this_thread::get_id() };
+	Block* block{};
+	for (const std::unique_ptr<Block>& existing : m_blocks)
+	{
+		if (existing->owner == threadId)
+		{
+			block = existing.get();
+			break;
+		}
+	}
+
+	if (!block)
+	{
+		m_blocks.push_back(std::make_unique<Block>());
+		block = m_blocks.back().get();
+		block->owner = threadId;
+
+		if (m_isOpen)
+		{
+			block->columnData.assign(m_blockSize, 0);
+			block->isAccepting = true;
+		}
+	}
+
+	cache[nextCacheSlot++ % cache.size()] = { m_id, block };
+	return *block;
+}
+
+void ShotDatasetWriter::append(const shotDataset::Row& row)
+{
+	Block& block{ getThreadBlock() };
+	std::lock_guard<std::mutex> lock{ block.mutex };
+
+	if (!block.isAccepting)
+		return;
+
+	unsigned char* const columns{ block.columnData.data() + sizeof(shotDataset::BlockHeader) };
+	for (int i{}; i < static_cast<int>(shotDataset::columns.size()); ++i)
+	{
+		const std::size_t valueSize{ static_cast<std::size_t>(shotDataset::getElementSize(shotDataset::columns[i].type)) * shotDataset::columns[i].elementCount };
+		std::memcpy(columns + m_columnOffsets[i] + valueSize * block.rowCount, shotDataset::getRowField(row, i), valueSize);
+	}
+
+	if (++block.rowCount == shotDataset::rowsPerBlock)
+		queueBlock(block);
+}
+
+void ShotDatasetWriter::queueBlock(Block& block)
+{
+	shotDataset::BlockHeader header{};
+	header.rowCount = static_cast<std::uint32_t>(block.rowCount);
+	std::memcpy(block.columnData.data(), &header, sizeof(header));
+
+	{
+		std::lock_guard<std::mutex> lock{ m_queueMutex };
+		m_fullBlocks.push_back(std::move(block.columnData));
+
+		if (!m_spareBlocks.empty())
+		{
+			block.columnData = std::move(m_spareBlocks.back());
+			m_spareBlocks.pop_back();
+		}
+	}
+	m_wakeup.notify_one();
+
+	// only until the writer has written a block or two, then they go round
+	if (block.columnData.size() != m_blockSize)
+		block.columnData.assign(m_blockSize, 0);
+
+	block.rowCount = 0;
+}
+
+void ShotDatasetWriter::writeBlocks()
+{
+	std::vector<std::vector<unsigned char>> batch;
+
+	std::unique_lock<std::mutex> lock{ m_queueMutex };
+	while (true)
+	{
+		m_wakeup.wait(lock, [this]() { return m_isStopping || !m_fullBlocks.empty(); });
+
+		batch.swap(m_fullBlocks);
+		const bool isStopping{ m_isStopping };
+
+		// the simulating threads keep filling blocks while this waits on the disk
+		lock.unlock();
+
+		for (const std::vector<unsigned char>& block : batch)
+			m_file.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size()));
+		m_file.flush();
+
+		lock.lock();
+		for (std::vector<unsigned char>& block : batch)
+			m_spareBlocks.push_back(std::move(block));
+		batch.clear();
+
+		if (isStopping && m_fullBlocks.empty())
+			return;
+	}
+}
+
+void ShotDatasetWriter::writePartialBlock(Block& block)
+{
+	if (block.rowCount == 0)
+		return;
+
+	shotDataset::BlockHeader header{};
+	header.rowCount = static_cast<std::uint32_t>(block.rowCount);
+	std::memcpy(block.columnData.data(), &header, sizeof(header));
+
+	// its columns are moved down to where a block this short keeps them
+	unsigned char* const columns{ block.columnData.data() + sizeof(shotDataset::BlockHeader) };
+	std::size_t offset{};
+	for (int i{}; i < static_cast<int>(shotDataset::columns.size()); ++i)
+	{
+		const std::size_t valueSize{ static_cast<std::size_t>(shotDataset::getElementSize(shotDataset::columns[i].type)) * shotDataset::columns[i].elementCount };
+		const std::size_t columnSize{ valueSize * block.rowCount };
+
+		std::memmove(columns + offset, columns + m_columnOffsets[i], columnSize);
+		std::memset(columns + offset + columnSize, 0, getPaddedSize(columnSize) - columnSize);
+		offset += getPaddedSize(columnSize);
+	}
+
+	m_file.write(reinterpret_cast<const char*>(block.columnData.data()), static_cast<std::streamsize>(sizeof(shotDataset::BlockHeader) + offset));
+	m_file.flush();
+	block.rowCount = 0;
+}
+
+bool ShotDatasetReader::load(const std::string& path)
+{
+	close();
+
+	if (!m_file.open(path) || m_file.getSize() < sizeof(shotDataset::FileHeader))
+	{
+		close();
+		return false;
+	}
+
+	const shotDataset::FileHeader expected{};
+	m_header = reinterpret_cast<const shotDataset::FileHeader*>(m_file.getData());
+
+	const std::size_t schemaEnd{ sizeof(shotDataset::FileHeader) + m_header->columnCount * sizeof(shotDataset::ColumnHeader) };
+	if (std::memcmp(m_header->magic, expected.magic, sizeof(expected.magic)) != 0 || m_header->version != expected.version
+		|| m_header->columnCount == 0 || m_header->rowsPerBlock == 0 || m_file.getSize() < schemaEnd)
+	{
+		close();
+		return false;
+	}
+
+	m_columns = reinterpret_cast<const shotDataset::ColumnHeader*>(m_file.getData() + sizeof(shotDataset::FileHeader));
+
+	// walk the blocks, a block that runs past the end of the file was cut short and is ignored
+	const shotDataset::BlockHeader expectedBlock{};
+	std::size_t offset{ schemaEnd };
+
+	while (offset + sizeof(shotDataset::BlockHeader) <= m_file.getSize())
+	{
+		const shotDataset::BlockHeader* block{ reinterpret_cast<const shotDataset::BlockHeader*>(m_file.getData() + offset) };
+		if (std::memcmp(block->magic, expectedBlock.magic, sizeof(expectedBlock.magic)) != 0
+			|| block->rowCount == 0 || block->rowCount > m_header->rowsPerBlock)
+		{
+			break;
+		}
+
+		std::size_t blockSize{ sizeof(shotDataset::BlockHeader) };
+		for (int i{}; i < getColumnCount(); ++i)
+			blockSize += getPaddedSize(static_cast<std::size_t>(m_columns[i].elementSize) * m_columns[i].elementCount * block->rowCount);
+
+		if (offset + blockSize > m_file.getSize())
+			break;
+
+		m_blockOffsets.push_back(offset);
+		m_blockRowCounts.push_back(static_cast<int>(block->rowCount));
+		m_rowCount += block->rowCount;
+		offset += blockSize;
+	}
+
+	m_validSize = offset;
+	return true;
+}
+
+void ShotDatasetReader::close()
+{
+	m_file.close();
+	m_header = nullptr;
+	m_columns = nullptr;
+	m_blockOffsets.clear();
+	m_blockRowCounts.clear();
+	m_rowCount = 0;
+	m_validSize = 0;
+}
+
+int ShotDatasetReader::getColumnCount() const
+{
+	return m_header ? static_cast<int>(m_header->columnCount) : 0;
+}
+
+const shotDataset::ColumnHeader& ShotDatasetReader::getColumn(const int column) const
+{
+	return m_columns[column];
+}
+
+int ShotDatasetReader::findColumn(std::string_view name) const
+{
+	for (int i{}; i < getColumnCount(); ++i)
+	{
+		if (getFixedString(m_columns[i].name, sizeof(m_columns[i].name)) == name)
+			return i;
+	}
+	return -1;
+}
+
+int ShotDatasetReader::getBlockCount() const
+{
+	return static_cast<int>(m_blockOffsets.size());
+}
+
+int ShotDatasetReader::getBlockRowCount(const int block) const
+{
+	return m_blockRowCounts[block];
+}
+
+long long ShotDatasetReader::getRowCount() const
+{
+	return m_rowCount;
+}
+
+std::size_t ShotDatasetReader::getValidSize() const
+{
+	return m_validSize;
+}
+
+std::string_view ShotDatasetReader::getPlayerName(const int player) const
+{
+	if (!m_header || player < 0 || player > 1)
+		return {};
+
+	return getFixedString(m_header->playerNames[player], sizeof(m_header->playerNames[player]));
+}
+
+const unsigned char* ShotDatasetReader::getColumnData(const int block, const int column) const
+{
+	const std::size_t rowCount{ static_cast<std::size_t>(m_blockRowCounts[block]) };
+	std::size_t offset{ m_blockOffsets[block] + sizeof(shotDataset::BlockHeader) };
+
+	for (int i{}; i < column; ++i)
+		offset += getPaddedSize(static_cast<std::size_t>(m_columns[i].elementSize) * m_columns[i].elementCount * rowCount);
+
+	return m_file.getData() + offset;
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "Ball.h"
+#include "MappedFile.h"
+#include "Players.h"
+#include "common.h"
+#include "simulation.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// fixed width columnar shot records for offline analysis
+// file layout:
+//   FileHeader
+//   ColumnHeader x columnCount (the schema)
+//   blocks of up to rowsPerBlock rows, each a BlockHeader followed by every
+//   column's values for those rows back to back (each column padded to 8 bytes)
+// nothing is ever rewritten, so files can be appended to and mapped while growing
+namespace shotDataset
+{
+	enum class ColumnType : std::uint8_t
+	{
+		f32,
+		u8,
+		i8,
+		u16,
+		u32
+	};
+
+	enum class Source : std::uint8_t
+	{
+		played,
+		simulated
+	};
+
+	struct FileHeader
+	{
+		char magic[8]{ 'P', 'O', 'O', 'L', 'S', 'H', 'O', 'T' };
+		std::uint32_t version{ 1 };
+		std::uint32_t columnCount{};
+		std::uint32_t rowsPerBlock{};
+		std::uint32_t reserved{};
+		char playerNames[2][32]{}; // only set for files that hold a single match
+	};
+
+	struct ColumnHeader
+	{
+		char name[24]{};
+		ColumnType type{};
+		std::uint8_t elementSize{};
+		std::uint16_t elementCount{}; // values per row
+		std::uint32_t reserved{};
+	};
+
+	struct BlockHeader
+	{
+		char magic[4]{ 'B', 'L', 'K', '1' };
+		std::uint32_t rowCount{};
+	};
+
+	struct ColumnDefinition
+	{
+		std::string_view name;
+		ColumnType type;
+		int elementCount;
+	};
+
+	inline constexpr int maxBalls{ 16 };
+	inline constexpr int pocketCount{ 6 };
+
+	// the order here is the order in the file
+	inline constexpr std::array<ColumnDefinition, 19> columns{ {
+		{ "ball_x", ColumnType::f32, maxBalls }, // before the shot
+		{ "ball_y", ColumnType::f32, maxBalls },
+		{ "on_table", ColumnType::u16, 1 }, // bit n = ball n
+		{ "target_suit", ColumnType::u8, 1 }, // Ball::BallSuitType of the shooter after the shot
+		{ "score", ColumnType::u8, 1 },
+		{ "ball_in_hand", ColumnType::u8, 1 },
+		{ "angle", ColumnType::f32, 1 },
+		{ "power", ColumnType::f32, 1 },
+		{ "first_hit_type", ColumnType::u8, 1 },
+		{ "first_hit_ball", ColumnType::i8, 1 }, // -1 = nothing hit
+		{ "pocketed", ColumnType::u16, 1 }, // bit n = ball n
+		{ "pocket_counts", ColumnType::u8, pocketCount }, // balls that went into each pocket
+		{ "fouls", ColumnType::u8, 1 }, // referee::foul bits
+		{ "cue_rest_x", ColumnType::f32, 1 }, // NaN if the cue ball was pocketed
+		{ "cue_rest_y", ColumnType::f32, 1 },
+		{ "source", ColumnType::u8, 1 },
+		{ "player", ColumnType::u8, 1 }, // index into playerNames, 255 if simulated
+		{ "match", ColumnType::u32, 1 },
+		{ "ticks", ColumnType::u16, 1 }
+	} };
+
+	// columns[] indices, keep in sync
+	enum Column
+	{
+		ballX,
+		ballY,
+		onTable,
+		targetSuit,
+		score,
+		ballInHand,
+		angle,
+		power,
+		firstHitType,
+		firstHitBall,
+		pocketed,
+		pocketCounts,
+		fouls,
+		cueRestX,
+		cueRestY,
+		source,
+		player,
+		match,
+		ticks
+	};
+
+	inline constexpr int rowsPerBlock{ 4096 };
+
+	int getElementSize(const ColumnType type);
+
+	// one shot, in the same layout the columns store it
+	struct Row
+	{
+		std::array<float, maxBalls> ballX{};
+		std::array<float, maxBalls> ballY{};
+		std::uint16_t onTable{};
+		std::uint8_t targetSuit{};
+		std::uint8_t score{};
+		std::uint8_t ballInHand{};
+		float angle{};
+		float power{};
+		std::uint8_t firstHitType{};
+		std::int8_t firstHitBall{ -1 };
+		std::uint16_t pocketed{};
+		std::array<std::uint8_t, pocketCount> pocketCounts{};
+		std::uint8_t fouls{};
+		float cueRestX{};
+		float cueRestY{};
+		Source source{};
+		std::uint8_t player{ 255 };
+		std::uint32_t match{};
+		std::uint16_t ticks{};
+	};
+
+	// startBalls is the table before the shot, restingBalls after it,
+	// shooter is the player after the shot (the suits may have just been assigned)
+	Row makeRow(
+		const Ball::balls_type& startBalls,
+		const Ball::balls_type& restingBalls,
+		const Players::PlayerType& shooter,
+		const simulation::ShotParameters& shot,
+		const TurnInformation& turn,
+		const int ticks
+	);
+}
+
+// appends rows to a dataset file, rows are gathered into blocks in memory
+// and every block goes out in one write
+// - each appending thread fills a block of its own, so a shot only costs a copy
+//   and a lock that nothing but close ever competes for
+// - a full block is swapped for an empty one under a short lock and a writer
+//   thread writes it, the disk never holds up a simulating thread
+// - blocks of different threads go out in the order they fill up, the unfinished
+//   ones when the writer closes
+class ShotDatasetWriter
+{
+private:
+	struct Block
+	{
+		std::mutex mutex; // its thread's appends and close
+		std::vector<unsigned char> columnData; // column by column
+		int rowCount{};
+		bool isAccepting{};
+		std::thread::id owner;
+	};
+
+	const std::uint64_t m_id; // finds this writer's block in each thread's cache
+
+	std::ofstream m_file;
+	std::array<std::size_t, shotDataset::columns.size()> m_columnOffsets{};
+	std::size_t m_blockSize{};
+
+	// every thread that appended keeps its block until the writer is destroyed,
+	// so a thread's cached pointer stays good across close and open
+	std::mutex m_blocksMutex;
+	std::vector<std::unique_ptr<Block>> m_blocks;
+	bool m_isOpen{};
+
+	// full blocks on their way to the disk, and written ones to swap in
+	std::mutex m_queueMutex;
+	std::condition_variable m_wakeup;
+	std::vector<std::vector<unsigned char>> m_fullBlocks;
+	std::vector<std::vector<unsigned char>> m_spareBlocks;
+	bool m_isStopping{};
+	std::thread m_writer;
+
+	// read without a lock by every simulating thread, written by open and close
+	std::atomic<bool> m_recordsPlayed{};
+	std::atomic<bool> m_recordsSimulated{};
+
+	Block& getThreadBlock();
+	// the block's mutex is held
+	void queueBlock(Block& block);
+	void writeBlocks();
+	void writePartialBlock(Block& block);
+
+public:
+	ShotDatasetWriter();
+	~ShotDatasetWriter();
+
+	ShotDatasetWriter(const ShotDatasetWriter&) = delete;
+	ShotDatasetWriter& operator=(const ShotDatasetWriter&) = delete;
+
+	// appends if path already holds a dataset with the same schema
+	bool open(const std::string& path, const bool recordsPlayed, const bool recordsSimulated, const std::string& playerName1 = {}, const std::string& playerName2 = {});
+	void close();
+
+	bool isOpen() const;
+	bool isRecording(const shotDataset::Source source) const;
+
+	void append(const shotDataset::Row& row);
+};
+
+// maps a dataset file and hands out pointers straight into the columns
+class ShotDatasetReader
+{
+private:
+	MappedFile m_file;
+	const shotDataset::FileHeader* m_header{};
+	const shotDataset::ColumnHeader* m_columns{};
+
+	// where each complete block starts
+	std::vector<std::size_t> m_blockOffsets;
+	std::vector<int> m_blockRowCounts;
+	long long m_rowCount{};
+	std::size_t m_validSize{}; // up to the end of the last complete block
+
+public:
+	bool load(const std::string& path);
+	void close();
+
+	int getColumnCount() const;
+	const shotDataset::ColumnHeader& getColumn(const int column) const;
+	// -1 if the file has no such column
+	int findColumn(std::string_view name) const;
+
+	int getBlockCount() const;
+	int getBlockRowCount(const int block) const;
+	long long getRowCount() const;
+	std::size_t getValidSize() const;
+	std::string_view getPlayerName(const int player) const;
+
+	const unsigned char* getColumnData(const int block, const int column) const;
+
+	template <typename T>
+	const T* getColumnValues(const int block, const int column) const
+	{
+		return reinterpret_cast<const T*>(getColumnData(block, column));
+	}
+};
@@ -0,0 +1,279 @@
+#include "ShotDifficultyTable.h"
+
+#include "Ball.h"
+#include "Players.h"
+#include "constants.h"
+#include "simulation.h"
+#include "Vector2.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the header is written and mapped as is, so its layout must not change
+static_assert(sizeof(ShotDifficultyTable::Header) == 52, "Difficulty table header layout changed");
+
+bool ShotDifficultyTable::load(const std::string& path)
+{
+	m_header = nullptr;
+	m_values = nullptr;
+
+	if (!m_file.open(path) || m_file.getSize() < sizeof(Header))
+		return false;
+
+	const Header* header{ reinterpret_cast<const Header*>(m_file.getData()) };
+	const Header expected{};
+
+	if (std::memcmp(header->magic, expected.magic, sizeof(expected.magic)) != 0 || header->version != expected.version)
+	{
+		m_file.close();
+		return false;
+	}
+
+	std::size_t valueCount{ 1 };
+	for (const std::uint32_t binCount : header->binCounts)
+	{
+		// need at least two bins per axis to interpolate
+		if (binCount < 2)
+		{
+			m_file.close();
+			return false;
+		}
+		valueCount *= binCount;
+	}
+
+	if (m_file.getSize() != sizeof(Header) + valueCount * sizeof(float))
+	{
+		m_file.close();
+		return false;
+	}
+
+	m_header = header;
+	m_values = reinterpret_cast<const float*>(m_file.getData() + sizeof(Header));
+	return true;
+}
+
+bool ShotDifficultyTable::isLoaded() const
+{
+	return m_values != nullptr;
+}
+
+float ShotDifficultyTable::getValue(const int cutIndex, const int pocketIndex, const int cueIndex) const
+{
+	return m_values[(cutIndex * m_header->binCounts[1] + pocketIndex) * m_header->binCounts[2] + cueIndex];
+}
+
+float ShotDifficultyTable::estimate(const double cutAngle, const double pocketDistance, const double cueDistance) const
+{
+	if (!isLoaded())
+		return -1.0f;
+
+	const std::array<double, axisCount> values{ cutAngle, pocketDistance, cueDistance };
+	std::array<int, axisCount> lowIndex{};
+	std::array<float, axisCount> fraction{};
+
+	// find the cell and how far into it we are, clamped to the table edges
+	for (int axis{}; axis < axisCount; ++axis)
+	{
+		const int binCount{ static_cast<int>(m_header->binCounts[axis]) };
+		const float range{ m_header->maximums[axis] - m_header->minimums[axis] };
+		const float position{ std::clamp(static_cast<float>((values[axis] - m_header->minimums[axis]) / range * (binCount - 1)), 0.0f, static_cast<float>(binCount - 1)) };
+
+		lowIndex[axis] = std::min(static_cast<int>(position), binCount - 2);
+		fraction[axis] = position - lowIndex[axis];
+	}
+
+	// trilinear interpolation of the 8 surrounding entries
+	float result{};
+	for (int corner{}; corner < 8; ++corner)
+	{
+		float weight{ 1.0f };
+		std::array<int, axisCount> index{};
+
+		for (int axis{}; axis < axisCount; ++axis)
+		{
+			const bool isHigh{ ((corner >> axis) & 1) != 0 };
+			index[axis] = lowIndex[axis] + (isHigh ? 1 : 0);
+			weight *= isHigh ? fraction[axis] : 1.0f - fraction[axis];
+		}
+
+		result += weight * getValue(index[0], index[1], index[2]);
+	}
+
+	return result;
+}
+
+// power that gets the object ball to the pocket with some to spare
+static double getCutShotPower(const double cutAngle, const double pocketDistance, const double cueDistance)
+{
+	const double objectSpeed{ 1.5 * consts::rollingFriction * pocketDistance };
+	const double contactSpeed{ objectSpeed / (std::max(std::cos(cutAngle), 0.2) * consts::collisionFriction) };
+	return std::clamp(contactSpeed + consts::rollingFriction * cueDistance, 3.0, static_cast<double>(consts::cueStickMaxPower));
+}
+
+static bool isInsidePlaySurface(const Vector2& position)
+{
+	const double margin{ consts::defaultBallRadius + 1.0 };
+	return position.getX() > consts::playSurface.xPos1 + margin && position.getX() < consts::playSurface.xPos2 - margin
+		&& position.getY() > consts::playSurface.yPos1 + margin && position.getY() < consts::playSurface.yPos2 - margin;
+}
+
+// places the cue ball (0) and the object ball (1) so the object ball is pocketDistance
+// from a random pocket and the cue ball has to travel cueDistance to cut it in
+static bool setupCutShot(Ball::balls_type& gameBalls, const double cutAngle, const double pocketDistance, const double cueDistance, std::mt19937& randomEngine, int& pocketIndex, double& shotAngle)
+{
+	static constexpr double pi{ 3.14159265358979323846 };
+	std::uniform_int_distribution<int> pocketDistribution{ 0, static_cast<int>(consts::pocketCoordinates.size()) - 1 };
+	std::uniform_real_distribution<double> angleDistribution{ 0.0, 2.0 * pi };
+
+	for (int attempt{}; attempt < 200; ++attempt)
+	{
+		pocketIndex = pocketDistribution(randomEngine);
+		const Vector2 pocket(consts::pocketCoordinates[pocketIndex][0], consts::pocketCoordinates[pocketIndex][1]);
+
+		const double placementAngle{ angleDistribution(randomEngine) };
+		const Vector2 objectPosition{ pocket.copyAndAdd(Vector2(std::cos(placementAngle), std::sin(placementAngle)).copyAndMultiply(pocketDistance)) };
+		if (!isInsidePlaySurface(objectPosition))
+			continue;
+
+		// ghost ball, then back off along the cut to the cue ball
+		const Vector2 toPocket{ pocket.copyAndSubtract(objectPosition).getNormalized() };
+		const Vector2 ghostBall{ objectPosition.copyAndSubtract(toPocket.copyAndMultiply(2.0 * consts::defaultBallRadius)) };
+
+		const double side{ (randomEngine() & 1) ? 1.0 : -1.0 };
+		const double cueAngle{ std::atan2(toPocket.getY(), toPocket.getX()) + side * cutAngle };
+		const Vector2 cueDirection(std::cos(cueAngle), std::sin(cueAngle));
+		const Vector2 cuePosition{ ghostBall.copyAndSubtract(cueDirection.copyAndMultiply(cueDistance)) };
+
+		if (!isInsidePlaySurface(cuePosition)
+			|| cuePosition.copyAndSubtract(objectPosition).getLength() < 2.0 * consts::defaultBallRadius + 1.0)
+		{
+			continue;
+		}
+
+		gameBalls[0].setPosition(cuePosition);
+		gameBalls[1].setPosition(objectPosition);
+		if (gameBalls[0].isInPocket() || gameBalls[1].isInPocket())
+			continue;
+
+		shotAngle = cueAngle;
+		return true;
+	}
+
+	return false;
+}
+
+bool ShotDifficultyTable::generate(const std::string& path, const int samplesPerEntry)
+{
+	Header header{};
+	header.samplesPerEntry = samplesPerEntry;
+
+	std::size_t valueCount{ 1 };
+	for (int axis{}; axis < axisCount; ++axis)
+	{
+		header.binCounts[axis] = consts::difficultyTableBins[axis];
+		header.minimums[axis] = consts::difficultyTableMinimums[axis];
+		header.maximums[axis] = consts::difficultyTableMaximums[axis];
+		valueCount *= consts::difficultyTableBins[axis];
+	}
+
+	const auto getAxisValue{ [&header](const int axis, const int index) {
+		return header.minimums[axis] + (header.maximums[axis] - header.minimums[axis]) * index / (header.binCounts[axis] - 1);
+	} };
+
+	// NaN marks entries that can't be set up on this table
+	std::vector<float> values(valueCount, std::numeric_limits<float>::quiet_NaN());
+
+	const auto generateEntries{ [&](const int firstEntry, const int entryStep) {
+		std::mt19937 randomEngine{ std::random_device{}() };
+		std::normal_distribution<double> aimNoise{ 0.0, consts::predictorAimNoise };
+		std::normal_distribution<double> powerNoise{ 0.0, consts::predictorPowerNoise };
+
+		// only the cue ball and one object ball on the table
+		Ball::balls_type gameBalls;
+		simulation::createBalls(gameBalls, 16, consts::defaultBallRadius, consts::defaultBallMass);
+		for (int i{ 2 }; i < static_cast<int>(gameBalls.size()); ++i)
+			gameBalls[i].setVisible(false);
+
+		const Players gamePlayers{ 2 };
+		Ball::balls_type restingBalls;
+
+		for (int entry{ firstEntry }; entry < static_cast<int>(valueCount); entry += entryStep)
+		{
+			const int cueIndex{ entry % static_cast<int>(header.binCounts[2]) };
+			const int pocketIndex{ (entry / static_cast<int>(header.binCounts[2])) % static_cast<int>(header.binCounts[1]) };
+			const int cutIndex{ entry / static_cast<int>(header.binCounts[2] * header.binCounts[1]) };
+
+			const double cutAngle{ getAxisValue(0, cutIndex) };
+			const double pocketDistance{ getAxisValue(1, pocketIndex) };
+			const double cueDistance{ getAxisValue(2, cueIndex) };
+			const double power{ getCutShotPower(cutAngle, pocketDistance, cueDistance) };
+
+			int successes{};
+			int samples{};
+			for (int sample{}; sample < samplesPerEntry; ++sample)
+			{
+				int targetPocket;
+				double shotAngle;
+				if (!setupCutShot(gameBalls, cutAngle, pocketDistance, cueDistance, randomEngine, targetPocket, shotAngle))
+					break;
+
+				simulation::ShotParameters shot{};
+				shot.angle = shotAngle + aimNoise(randomEngine);
+				shot.power = std::max(0.0, power * (1.0 + powerNoise(randomEngine)));
+
+				const simulation::ShotOutcome outcome{ simulation::simulateShot(gameBalls, gamePlayers, shot, restingBalls) };
+				successes += (outcome.pocketedMask & 2u) && !outcome.cueBallPocketed
+					&& simulation::getNearestPocketIndex(restingBalls[1].getX(), restingBalls[1].getY()) == targetPocket;
+				++samples;
+			}
+
+			if (samples > 0)
+				values[entry] = static_cast<float>(successes) / samples;
+		}
+	} };
+
+	const int threadCount{ std::max(1, static_cast<int>(std::thread::hardware_concurrency())) };
+	std::vector<std::thread> threads;
+	for (int i{}; i < threadCount; ++i)
+	{
+		threads.emplace_back(generateEntries, i, threadCount);
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	// impossible entries copy the next shorter cue distance, or failing that the next
+	// shorter pocket distance, so the interpolation never reads garbage
+	const std::size_t cueCount{ header.binCounts[2] };
+	const std::size_t pocketCount{ header.binCounts[1] };
+	for (std::size_t entry{}; entry < valueCount; ++entry)
+	{
+		if (!std::isnan(values[entry]))
+			continue;
+
+		if (entry % cueCount != 0)
+			values[entry] = values[entry - 1];
+		else if ((entry / cueCount) % pocketCount != 0)
+			values[entry] = values[entry - cueCount];
+		else
+			values[entry] = 0.0f;
+	}
+
+	std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+	if (!file)
+		return false;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(float)));
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// success rates of plain cut shots, indexed by
+// [cut angle][object ball to pocket distance][cue ball to ghost ball distance]
+// the table is generated offline from batch simulations (--generate-difficulty-table)
+// and memory mapped at runtime, so an estimate is just a trilinear interpolation
+class ShotDifficultyTable
+{
+public:
+	static constexpr int axisCount{ 3 };
+
+	// file layout: Header followed by the float values, last axis varies fastest
+	struct Header
+	{
+		char magic[8]{ 'P', 'O', 'O', 'L', 'D', 'I', 'F', 'F' };
+		std::uint32_t version{ 1 };
+		std::uint32_t samplesPerEntry{};
+		std::array<std::uint32_t, axisCount> binCounts{};
+		std::array<float, axisCount> minimums{};
+		std::array<float, axisCount> maximums{};
+	};
+
+private:
+	MappedFile m_file;
+	const Header* m_header{};
+	const float* m_values{};
+
+	float getValue(const int cutIndex, const int pocketIndex, const int cueIndex) const;
+
+public:
+	bool load(const std::string& path);
+	bool isLoaded() const;
+
+	// chance (0 to 1) that the cut shot goes in, or -1 if no table is loaded
+	float estimate(const double cutAngle, const double pocketDistance, const double cueDistance) const;
+
+	// runs the batch simulations and writes a new table file
+	static bool generate(const std::string& path, const int samplesPerEntry);
+};
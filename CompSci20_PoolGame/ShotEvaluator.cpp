@@ -0,0 +1,341 @@
+#include "ShotEvaluator.h"
+
+#include "Ball.h"
+#include "Players.h"
+#include "constants.h"
+#include "physics.h"
+#include "referee.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+ShotEvaluator::ShotEvaluator(const int refineCount)
+{
+	setRefineCount(refineCount);
+}
+
+int ShotEvaluator::getRefineCount() const
+{
+	return m_refineCount;
+}
+
+void ShotEvaluator::setRefineCount(const int refineCount)
+{
+	if (refineCount > 0)
+		m_refineCount = refineCount;
+}
+
+float ShotEvaluator::evaluateCoarse(
+	coarseBalls_type balls,
+	const Ball::balls_type& gameBalls,
+	const Players::PlayerType& shooter,
+	const simulation::ShotParameters& shot
+) const
+{
+	const int ballCount{ std::min(static_cast<int>(gameBalls.size()), maxCoarseBalls) };
+	const float radius{ static_cast<float>(consts::defaultBallRadius) };
+	const float substepLength{ radius * consts::coarseSubstepScale };
+
+	// n ticks of friction merged into a single step
+	const float decay{ std::pow(1.0f - static_cast<float>(consts::rollingFriction), static_cast<float>(consts::coarseTicksPerStep)) };
+	const float travel{ (1.0f - decay) / static_cast<float>(consts::rollingFriction) };
+	const float stopVelocity{ static_cast<float>(consts::stoppingVelocity) };
+	const float wallFriction{ static_cast<float>(consts::collisionFriction) };
+	const float pocketRange{ radius + static_cast<float>(consts::pocketRadius - consts::pocketSensitivity) };
+
+	balls[0].vx = static_cast<float>(std::cos(shot.angle) * shot.power);
+	balls[0].vy = static_cast<float>(std::sin(shot.angle) * shot.power);
+
+	int firstHitBall{ -1 };
+	int firstPocketedSuitBall{ -1 };
+	ballMask_type pocketedMask{};
+	// No Rail rule, tracked like stepPhysics: set by the first hit, cleared by a cushion or a pocket after it
+	bool didNoRailFoul{};
+
+	bool anyMoving{ true };
+	for (int tick{}; anyMoving && tick < consts::maxSimulationTicks; tick += consts::coarseTicksPerStep)
+	{
+		anyMoving = false;
+
+		for (int i{}; i < ballCount; ++i)
+		{
+			CoarseBall& ball{ balls[i] };
+			if (!ball.isVisible || (ball.vx == 0.0f && ball.vy == 0.0f))
+				continue;
+
+			const float moveX{ ball.vx * travel };
+			const float moveY{ ball.vy * travel };
+			int substeps{ static_cast<int>(std::ceil((std::abs(moveX) + std::abs(moveY)) / substepLength)) };
+			const float stepX{ moveX / substeps };
+			const float stepY{ moveY / substeps };
+
+			bool hasCollided{};
+			while (substeps > 0 && !hasCollided)
+			{
+				ball.x += stepX;
+				ball.y += stepY;
+
+				for (int j{}; j < ballCount; ++j)
+				{
+					CoarseBall& other{ balls[j] };
+					if (j == i || !other.isVisible)
+						continue;
+
+					const float dx{ ball.x - other.x };
+					const float dy{ ball.y - other.y };
+					const float distanceSquared{ dx * dx + dy * dy };
+					if (distanceSquared > 4.0f * radius * radius)
+						continue;
+
+					const float distance{ std::sqrt(distanceSquared) };
+					const float nx{ (distance > 0.0f) ? dx / distance : 1.0f };
+					const float ny{ (distance > 0.0f) ? dy / distance : 0.0f };
+
+					// push apart
+					const float overlap{ (distance - 2.0f * radius) / 2.0f };
+					ball.x -= nx * overlap;
+					ball.y -= ny * overlap;
+					other.x += nx * overlap;
+					other.y += ny * overlap;
+
+					// exchange momentum
+					const float momentum{ 2.0f * (nx * (ball.vx - other.vx) + ny * (ball.vy - other.vy)) / (ball.mass + other.mass) * wallFriction };
+					ball.vx -= nx * momentum * other.mass;
+					ball.vy -= ny * momentum * other.mass;
+					other.vx += nx * momentum * ball.mass;
+					other.vy += ny * momentum * ball.mass;
+
+					if (firstHitBall < 0)
+					{
+						firstHitBall = (i == 0) ? j : i;
+						didNoRailFoul = true;
+					}
+
+					hasCollided = true;
+					anyMoving = true;
+				}
+
+				--substeps;
+			}
+
+			// pockets
+			bool isPocketed{};
+			for (const auto& [pocketX, pocketY] : consts::pocketCoordinates)
+			{
+				const float dx{ ball.x - pocketX };
+				const float dy{ ball.y - pocketY };
+				if (dx * dx + dy * dy <= pocketRange * pocketRange)
+				{
+					isPocketed = true;
+					break;
+				}
+			}
+
+			if (isPocketed)
+			{
+				ball.isVisible = false;
+				ball.vx = 0.0f;
+				ball.vy = 0.0f;
+				pocketedMask |= ballMask::getBall(i);
+				didNoRailFoul = false;
+
+				if (firstPocketedSuitBall < 0 && gameBalls[i].isSuitBall())
+					firstPocketedSuitBall = i;
+
+				continue;
+			}
+
+			// friction
+			if (ball.vx * ball.vx + ball.vy * ball.vy < stopVelocity)
+			{
+				ball.vx = 0.0f;
+				ball.vy = 0.0f;
+			}
+			else
+			{
+				ball.vx *= decay;
+				ball.vy *= decay;
+				anyMoving = true;
+			}
+
+			// cushions
+			bool hitCushion{};
+			if (ball.x - radius < consts::playSurface.xPos1)
+			{
+				ball.x = consts::playSurface.xPos1 + radius;
+				ball.vx = -ball.vx * wallFriction;
+				hitCushion = true;
+			}
+			else if (ball.x + radius > consts::playSurface.xPos2)
+			{
+				ball.x = consts::playSurface.xPos2 - radius;
+				ball.vx = -ball.vx * wallFriction;
+				hitCushion = true;
+			}
+
+			if (ball.y - radius < consts::playSurface.yPos1)
+			{
+				ball.y = consts::playSurface.yPos1 + radius;
+				ball.vy = -ball.vy * wallFriction;
+				hitCushion = true;
+			}
+			else if (ball.y + radius > consts::playSurface.yPos2)
+			{
+				ball.y = consts::playSurface.yPos2 - radius;
+				ball.vy = -ball.vy * wallFriction;
+				hitCushion = true;
+			}
+
+			if (hitCushion)
+				didNoRailFoul = false;
+		}
+	}
+
+	// turn the tracked state into an outcome and score it like the fine tier
+	Ball::BallSuitType targetType{ shooter.targetBallType };
+	if (targetType == Ball::BallSuitType::unknown && firstPocketedSuitBall >= 0)
+		targetType = gameBalls[firstPocketedSuitBall].getBallType();
+
+	simulation::ShotOutcome outcome{};
+	outcome.firstHitBallType = (firstHitBall >= 0) ? gameBalls[firstHitBall].getBallType() : Ball::BallSuitType::unknown;
+	outcome.firstHitBallNumber = firstHitBall;
+
+	const ballMask_type targetMask{ simulation::getTargetMask(targetType) };
+	outcome.pocketedMask = pocketedMask;
+	outcome.cueBallPocketed = (pocketedMask & ballMask::cue) != 0;
+	outcome.eightBallPocketed = (pocketedMask & ballMask::eight) != 0;
+	outcome.ownBallsPocketed = ballMask::getCount(pocketedMask & targetMask);
+	outcome.opponentBallsPocketed = ballMask::getCount(pocketedMask & (ballMask::solids | ballMask::stripes) & ~targetMask);
+
+	int remainingTargets{};
+	for (int i{}; i < ballCount; ++i)
+	{
+		if (balls[i].isVisible && (targetMask & ballMask::getBall(i)))
+		{
+			outcome.averagePocketDistance += simulation::getNearestPocketDistance(balls[i].x, balls[i].y);
+			++remainingTargets;
+		}
+	}
+
+	if (remainingTargets > 0)
+		outcome.averagePocketDistance /= remainingTargets;
+
+	// the fine tier's rules, fed with what the coarse tier tracked
+	TurnInformation turn{};
+	turn.pocketedBalls = pocketedMask;
+	turn.firstHitBallType = outcome.firstHitBallType;
+	turn.didNoRailFoul = didNoRailFoul;
+	outcome.didFoul = referee::getFouls(shooter, turn) != 0;
+
+	return static_cast<float>(simulation::scoreOutcome(outcome));
+}
+
+ShotEvaluator::Report ShotEvaluator::evaluate(const Ball::balls_type& gameBalls, const Players& gamePlayers, const std::vector<simulation::ShotParameters>& candidates) const
+{
+	using clock = std::chrono::steady_clock;
+
+	Report report{};
+	report.candidates.reserve(candidates.size());
+
+	// the starting table only needs to be converted once
+	coarseBalls_type startBalls{};
+	for (int i{}; i < static_cast<int>(gameBalls.size()) && i < maxCoarseBalls; ++i)
+	{
+		const Ball& ball{ gameBalls[i] };
+		startBalls[i] = {
+			static_cast<float>(ball.getX()),
+			static_cast<float>(ball.getY()),
+			0.0f,
+			0.0f,
+			static_cast<float>(ball.getMass()),
+			ball.isVisible()
+		};
+	}
+
+	Players players{ gamePlayers };
+	const Players::PlayerType shooter{ players.getCurrentPlayer() };
+
+	// coarse tier, rank everything
+	const clock::time_point coarseStart{ clock::now() };
+
+	for (const simulation::ShotParameters& shot : candidates)
+	{
+		Candidate candidate{};
+		candidate.shot = shot;
+		candidate.coarseScore = evaluateCoarse(startBalls, gameBalls, shooter, shot);
+		report.candidates.push_back(candidate);
+	}
+
+	std::stable_sort(report.candidates.begin(), report.candidates.end(),
+		[](const Candidate& a, const Candidate& b) { return a.coarseScore > b.coarseScore; });
+
+	for (int i{}; i < static_cast<int>(report.candidates.size()); ++i)
+		report.candidates[i].coarseRank = i;
+
+	const clock::time_point fineStart{ clock::now() };
+	const physics::StepCounters fineCountersStart{ physics::getStepCounters() };
+
+	// fine tier, re-simulate the best few with the real physics
+	report.refinedCount = std::min(m_refineCount, static_cast<int>(report.candidates.size()));
+
+	for (int i{}; i < report.refinedCount; ++i)
+	{
+		Candidate& candidate{ report.candidates[i] };
+		candidate.fineScore = simulation::simulateShot(gameBalls, gamePlayers, candidate.shot).score;
+	}
+
+	std::stable_sort(report.candidates.begin(), report.candidates.begin() + report.refinedCount,
+		[](const Candidate& a, const Candidate& b) { return a.fineScore > b.fineScore; });
+
+	report.coarseSeconds = std::chrono::duration<double>(fineStart - coarseStart).count();
+	report.fineSeconds = std::chrono::duration<double>(clock::now() - fineStart).count();
+	report.fineCounters = physics::getStepCounters().getDifference(fineCountersStart);
+
+	// spearman's rho over the refined candidates
+	// (their coarse ranks are already 0 to refinedCount - 1)
+	double squaredRankDifference{};
+	for (int i{}; i < report.refinedCount; ++i)
+	{
+		Candidate& candidate{ report.candidates[i] };
+		candidate.fineRank = i;
+
+		const double difference{ static_cast<double>(candidate.coarseRank - candidate.fineRank) };
+		squaredRankDifference += difference * difference;
+	}
+
+	const double n{ static_cast<double>(report.refinedCount) };
+	report.rankAgreement = (report.refinedCount > 1)
+		? 1.0 - (6.0 * squaredRankDifference) / (n * (n * n - 1.0))
+		: 1.0;
+	report.bestShotAgrees = report.refinedCount > 0 && report.candidates[0].coarseRank == 0;
+
+	return report;
+}
+
+void ShotEvaluator::printReport(const Report& report)
+{
+	std::cout << "[Shot Evaluation]\n";
+	std::cout << "Candidates: " << report.candidates.size() << " (" << report.refinedCount << " refined)\n";
+	std::cout << "Coarse Tier: " << report.coarseSeconds * 1000.0 << " ms\n";
+	std::cout << "Fine Tier: " << report.fineSeconds * 1000.0 << " ms\n";
+	std::cout << "Rank Agreement: " << std::fixed << std::setprecision(3) << report.rankAgreement << '\n';
+	std::cout << "Best Shot Agrees: " << (report.bestShotAgrees ? "Yes" : "No") << "\n\n";
+
+	if (!report.candidates.empty())
+	{
+		const Candidate& best{ report.candidates[0] };
+		std::cout << "[Best Shot] Angle: " << best.shot.angle << ", Power: " << best.shot.power
+			<< ", Score: " << best.fineScore << " (coarse rank " << best.coarseRank << ")\n\n";
+	}
+
+	std::cout << std::defaultfloat;
+
+	std::cout << "[Fine Tier Physics]\n";
+	physics::printStepCounters(report.fineCounters);
+	std::cout << '\n';
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Ball.h"
+#include "physics.h"
+#include "Players.h"
+#include "simulation.h"
+#include "constants.h"
+
+#include <array>
+#include <vector>
+
+// two tier shot ranking:
+// - the coarse tier runs every candidate through a cheap float simulation
+//   (merged ticks, long substeps, no audio, only the first hit, cushion
+//   contact and pocketed balls are tracked, enough for referee::getFouls)
+// - only the best refineCount candidates are re-simulated with stepPhysics
+class ShotEvaluator
+{
+public:
+	struct Candidate
+	{
+		simulation::ShotParameters shot{};
+		float coarseScore{};
+		double fineScore{};
+		int coarseRank{};
+		int fineRank{ -1 }; // -1 if the candidate was never refined
+	};
+
+	struct Report
+	{
+		// sorted best first, refined candidates come before the rest
+		std::vector<Candidate> candidates;
+
+		int refinedCount{};
+		// spearman rank correlation of the refined candidates between tiers,
+		// 1 = both tiers agree completely, -1 = completely reversed
+		double rankAgreement{};
+		bool bestShotAgrees{};
+
+		double coarseSeconds{};
+		double fineSeconds{};
+		physics::StepCounters fineCounters{}; // the coarse tier doesn't use stepPhysics
+	};
+
+private:
+	// float copy of the only ball state the coarse tier needs
+	struct CoarseBall
+	{
+		float x{};
+		float y{};
+		float vx{};
+		float vy{};
+		float mass{};
+		bool isVisible{};
+	};
+
+	static constexpr int maxCoarseBalls{ 16 };
+	using coarseBalls_type = std::array<CoarseBall, maxCoarseBalls>;
+
+	int m_refineCount{ consts::defaultRefineCount };
+
+	float evaluateCoarse(
+		coarseBalls_type balls,
+		const Ball::balls_type& gameBalls,
+		const Players::PlayerType& shooter,
+		const simulation::ShotParameters& shot
+	) const;
+
+public:
+	ShotEvaluator() = default;
+	ShotEvaluator(const int refineCount);
+
+	int getRefineCount() const;
+	void setRefineCount(const int refineCount);
+
+	Report evaluate(const Ball::balls_type& gameBalls, const Players& gamePlayers, const std::vector<simulation::ShotParameters>& candidates) const;
+
+	static void printReport(const Report& report);
+};
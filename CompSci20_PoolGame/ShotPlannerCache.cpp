@@ -0,0 +1,253 @@
+#include "ShotPlannerCache.h"
+
+#include "Ball.h"
+#include "constants.h"
+#include "metrics.h"
+#include "simulation.h"
+#include "Vector2.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool ShotPlannerCache::Entry::isPottable() const
+{
+	return isAvailable && isPocketPathClear && isCuePathClear && cutAngle < consts::plannerMaxCutAngle;
+}
+
+void ShotPlannerCache::Corridor::set(const Vector2& start, const Vector2& end, const double width)
+{
+	startX = start.getX();
+	startY = start.getY();
+	endX = end.getX();
+	endY = end.getY();
+	minX = std::min(startX, endX) - width;
+	minY = std::min(startY, endY) - width;
+	maxX = std::max(startX, endX) + width;
+	maxY = std::max(startY, endY) + width;
+}
+
+bool ShotPlannerCache::Corridor::isNear(const Vector2& position, const double width) const
+{
+	const double x{ position.getX() };
+	const double y{ position.getY() };
+	if (x < minX || x > maxX || y < minY || y > maxY)
+		return false;
+
+	return simulation::isPointNearPath(position, Vector2(startX, startY), Vector2(endX, endY), width);
+}
+
+int ShotPlannerCache::getLegIndex(const int ballIndex, const int pocketIndex)
+{
+	return ballIndex * pocketCount + pocketIndex;
+}
+
+void ShotPlannerCache::computePocketLeg(const Ball::balls_type& gameBalls, const int ballIndex, const int pocketIndex)
+{
+	Entry& entry{ m_entries[ballIndex][pocketIndex] };
+	const Ball& ball{ gameBalls[ballIndex] };
+
+	entry.isAvailable = ball.isVisible();
+	if (!entry.isAvailable)
+	{
+		entry.isPocketPathClear = false;
+		return;
+	}
+
+	const Vector2 pocket(consts::pocketCoordinates[pocketIndex][0], consts::pocketCoordinates[pocketIndex][1]);
+	const Vector2 toPocket{ pocket.copyAndSubtract(ball.getPositionVector()) };
+
+	entry.pocketDistance = toPocket.getLength();
+	entry.ghostBall = ball.getPositionVector().copyAndSubtract(toPocket.getNormalized().copyAndMultiply(2.0 * ball.getRadius()));
+	m_legs[ballIndex][pocketIndex].pocketCorridor.set(ball.getPositionVector(), pocket, 2.0 * ball.getRadius());
+	entry.isPocketPathClear = simulation::isPathClear(gameBalls, ball.getPositionVector(), pocket, 1u << ballIndex);
+}
+
+void ShotPlannerCache::computeCueLeg(const Ball::balls_type& gameBalls, const int ballIndex, const int pocketIndex)
+{
+	Entry& entry{ m_entries[ballIndex][pocketIndex] };
+	const Ball& cueBall{ gameBalls[0] };
+
+	if (!entry.isAvailable || !cueBall.isVisible())
+	{
+		entry.isCuePathClear = false;
+		entry.cueDistance = 0.0;
+		entry.cutAngle = 0.0;
+		return;
+	}
+
+	const Vector2 pocket(consts::pocketCoordinates[pocketIndex][0], consts::pocketCoordinates[pocketIndex][1]);
+	const Vector2 toGhost{ entry.ghostBall.copyAndSubtract(cueBall.getPositionVector()) };
+	const Vector2 objectDirection{ pocket.copyAndSubtract(gameBalls[ballIndex].getPositionVector()).getNormalized() };
+
+	m_legs[ballIndex][pocketIndex].cueCorridor.set(cueBall.getPositionVector(), entry.ghostBall, 2.0 * cueBall.getRadius());
+
+	entry.cueDistance = toGhost.getLength();
+	entry.cutAngle = std::acos(std::clamp(toGhost.getNormalized().getDotProduct(objectDirection), -1.0, 1.0));
+	entry.isCuePathClear = simulation::isPathClear(gameBalls, cueBall.getPositionVector(), entry.ghostBall, 1u | (1u << ballIndex));
+}
+
+void ShotPlannerCache::rebuild(const Ball::balls_type& gameBalls)
+{
+	m_ballCount = std::min(static_cast<int>(gameBalls.size()), maxBalls);
+
+	for (int i{}; i < m_ballCount; ++i)
+	{
+		m_positions[i] = gameBalls[i].getPositionVector();
+		m_isVisible[i] = gameBalls[i].isVisible();
+	}
+
+	// the cue ball is never an object ball
+	for (int ballIndex{ 1 }; ballIndex < m_ballCount; ++ballIndex)
+	{
+		for (int pocketIndex{}; pocketIndex < pocketCount; ++pocketIndex)
+		{
+			computePocketLeg(gameBalls, ballIndex, pocketIndex);
+			computeCueLeg(gameBalls, ballIndex, pocketIndex);
+		}
+	}
+
+	m_statistics.pocketLegsRecomputed += (m_ballCount - 1) * pocketCount;
+	m_statistics.cueLegsRecomputed += (m_ballCount - 1) * pocketCount;
+	m_isBuilt = true;
+}
+
+void ShotPlannerCache::invalidateAround(const Vector2& position, const double radius, const int movedBall, legMask_type& dirtyPocketLegs, legMask_type& dirtyCueLegs) const
+{
+	// same corridor width isPathClear uses
+	const double corridorWidth{ 2.0 * radius };
+
+	for (int ballIndex{ 1 }; ballIndex < m_ballCount; ++ballIndex)
+	{
+		// the moved ball's own entries are redone anyway
+		if (ballIndex == movedBall || !m_isVisible[ballIndex])
+			continue;
+
+		for (int pocketIndex{}; pocketIndex < pocketCount; ++pocketIndex)
+		{
+			const int legIndex{ getLegIndex(ballIndex, pocketIndex) };
+			const Legs& legs{ m_legs[ballIndex][pocketIndex] };
+
+			if (!dirtyPocketLegs[legIndex] && legs.pocketCorridor.isNear(position, corridorWidth))
+				dirtyPocketLegs.set(legIndex);
+
+			if (!dirtyCueLegs[legIndex] && m_entries[ballIndex][pocketIndex].isAvailable && m_isVisible[0]
+				&& legs.cueCorridor.isNear(position, corridorWidth))
+			{
+				dirtyCueLegs.set(legIndex);
+			}
+		}
+	}
+}
+
+int ShotPlannerCache::update(const Ball::balls_type& gameBalls)
+{
+	if (!m_isBuilt || std::min(static_cast<int>(gameBalls.size()), maxBalls) != m_ballCount)
+	{
+		rebuild(gameBalls);
+
+		const int legs{ 2 * (m_ballCount - 1) * pocketCount };
+		metrics::recordPlannerCacheUpdate(legs, legs);
+		return legs;
+	}
+
+	++m_statistics.updates;
+
+	legMask_type dirtyPocketLegs{};
+	legMask_type dirtyCueLegs{};
+
+	// find what moved and which corridors it was or is now in
+	// (done against the old positions, before any of them are replaced)
+	for (int i{}; i < m_ballCount; ++i)
+	{
+		const Ball& ball{ gameBalls[i] };
+		const bool wasVisible{ m_isVisible[i] };
+		const bool isVisible{ ball.isVisible() };
+
+		const bool hasMoved{
+			wasVisible != isVisible
+			|| (isVisible && (ball.getX() != m_positions[i].getX() || ball.getY() != m_positions[i].getY()))
+		};
+		if (!hasMoved)
+			continue;
+
+		// every cue leg starts at the cue ball, every leg of
+		// an object ball starts (or ends) at the object ball
+		for (int ballIndex{ 1 }; ballIndex < m_ballCount; ++ballIndex)
+		{
+			for (int pocketIndex{}; pocketIndex < pocketCount; ++pocketIndex)
+			{
+				const int legIndex{ getLegIndex(ballIndex, pocketIndex) };
+
+				if (i == 0)
+				{
+					dirtyCueLegs.set(legIndex);
+				}
+				else if (ballIndex == i)
+				{
+					dirtyPocketLegs.set(legIndex);
+					dirtyCueLegs.set(legIndex);
+				}
+			}
+		}
+
+		// marked first so the corridor tests can skip legs that are already dirty
+		if (wasVisible)
+			invalidateAround(m_positions[i], ball.getRadius(), i, dirtyPocketLegs, dirtyCueLegs);
+		if (isVisible)
+			invalidateAround(ball.getPositionVector(), ball.getRadius(), i, dirtyPocketLegs, dirtyCueLegs);
+	}
+
+	for (int i{}; i < m_ballCount; ++i)
+	{
+		m_positions[i] = gameBalls[i].getPositionVector();
+		m_isVisible[i] = gameBalls[i].isVisible();
+	}
+
+	// pocket legs first, the cue legs need their ghost ball
+	for (int ballIndex{ 1 }; ballIndex < m_ballCount; ++ballIndex)
+	{
+		for (int pocketIndex{}; pocketIndex < pocketCount; ++pocketIndex)
+		{
+			if (dirtyPocketLegs[getLegIndex(ballIndex, pocketIndex)])
+				computePocketLeg(gameBalls, ballIndex, pocketIndex);
+		}
+	}
+
+	for (int ballIndex{ 1 }; ballIndex < m_ballCount; ++ballIndex)
+	{
+		for (int pocketIndex{}; pocketIndex < pocketCount; ++pocketIndex)
+		{
+			if (dirtyCueLegs[getLegIndex(ballIndex, pocketIndex)])
+				computeCueLeg(gameBalls, ballIndex, pocketIndex);
+		}
+	}
+
+	const int pocketLegs{ static_cast<int>(dirtyPocketLegs.count()) };
+	const int cueLegs{ static_cast<int>(dirtyCueLegs.count()) };
+	m_statistics.pocketLegsRecomputed += pocketLegs;
+	m_statistics.cueLegsRecomputed += cueLegs;
+
+	metrics::recordPlannerCacheUpdate(2 * (m_ballCount - 1) * pocketCount, pocketLegs + cueLegs);
+	return pocketLegs + cueLegs;
+}
+
+void ShotPlannerCache::clear()
+{
+	m_isBuilt = false;
+	m_statistics = {};
+}
+
+bool ShotPlannerCache::isBuilt() const
+{
+	return m_isBuilt;
+}
+
+const ShotPlannerCache::Entry& ShotPlannerCache::getEntry(const int ballIndex, const int pocketIndex) const
+{
+	return m_entries[ballIndex][pocketIndex];
+}
+
+const ShotPlannerCache::Statistics& ShotPlannerCache::getStatistics() const
+{
+	return m_statistics;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Ball.h"
+#include "constants.h"
+#include "Vector2.h"
+
+#include <array>
+#include <bitset>
+
+// line of sight and cut angle for every (object ball, pocket) pair, kept between shots.
+// after a shot usually only a few balls have moved, so update() only recomputes
+// the entries whose corridors the moved balls were in before or are in now
+class ShotPlannerCache
+{
+public:
+	static constexpr int maxBalls{ 16 };
+	static constexpr int pocketCount{ static_cast<int>(consts::pocketCoordinates.size()) };
+
+	struct Entry
+	{
+		bool isAvailable{}; // false if the object ball is not on the table
+		bool isPocketPathClear{}; // object ball to pocket
+		bool isCuePathClear{}; // cue ball to ghost ball
+		Vector2 ghostBall{}; // where the cue ball has to be at contact
+		double pocketDistance{};
+		double cueDistance{};
+		double cutAngle{}; // radians, 0 = straight in
+
+		bool isPottable() const;
+	};
+
+	struct Statistics
+	{
+		int updates{};
+		int pocketLegsRecomputed{};
+		int cueLegsRecomputed{};
+	};
+
+private:
+	// a leg's path with its bounding box, so most moved balls
+	// are rejected without any vector maths
+	struct Corridor
+	{
+		double startX{};
+		double startY{};
+		double endX{};
+		double endY{};
+		double minX{};
+		double minY{};
+		double maxX{};
+		double maxY{};
+
+		void set(const Vector2& start, const Vector2& end, const double width);
+		bool isNear(const Vector2& position, const double width) const;
+	};
+
+	struct Legs
+	{
+		Corridor pocketCorridor{};
+		Corridor cueCorridor{};
+	};
+
+	// every entry is two legs, cue ball -> ghost ball and object ball -> pocket
+	using legMask_type = std::bitset<maxBalls * pocketCount>;
+
+	std::array<std::array<Entry, pocketCount>, maxBalls> m_entries{};
+	std::array<std::array<Legs, pocketCount>, maxBalls> m_legs{};
+	std::array<Vector2, maxBalls> m_positions{};
+	std::array<bool, maxBalls> m_isVisible{};
+	int m_ballCount{};
+	bool m_isBuilt{};
+
+	Statistics m_statistics{};
+
+	static int getLegIndex(const int ballIndex, const int pocketIndex);
+
+	void invalidateAround(const Vector2& position, const double radius, const int movedBall, legMask_type& dirtyPocketLegs, legMask_type& dirtyCueLegs) const;
+	void computePocketLeg(const Ball::balls_type& gameBalls, const int ballIndex, const int pocketIndex);
+	void computeCueLeg(const Ball::balls_type& gameBalls, const int ballIndex, const int pocketIndex);
+
+public:
+	// recomputes everything
+	void rebuild(const Ball::balls_type& gameBalls);
+	// recomputes only what the moved balls could have changed,
+	// returns the number of legs that were recomputed
+	int update(const Ball::balls_type& gameBalls);
+	void clear();
+
+	bool isBuilt() const;
+	const Entry& getEntry(const int ballIndex, const int pocketIndex) const;
+	const Statistics& getStatistics() const;
+};
@@ -0,0 +1,184 @@
+#include "ShotPredictor.h"
+
+#include "Ball.h"
+#include "Players.h"
+#include "common.h"
+#include "constants.h"
+#include "ShotDifficultyTable.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+
+// helpers for reading the packed progress value
+static constexpr std::uint64_t countMask{ 0xFFFFFF };
+
+static std::uint64_t getGeneration(const std::uint64_t progress)
+{
+	return progress >> 48;
+}
+
+static int getSamples(const std::uint64_t progress)
+{
+	return static_cast<int>((progress >> 24) & countMask);
+}
+
+static int getSuccesses(const std::uint64_t progress)
+{
+	return static_cast<int>(progress & countMask);
+}
+
+double ShotPredictor::Estimate::getProbability() const
+{
+	return (samples > 0) ? static_cast<double>(successes) / samples : 0.0;
+}
+
+ShotPredictor::ShotPredictor()
+{
+	// leave a core free for the game loop
+	const int hardwareThreads{ static_cast<int>(std::thread::hardware_concurrency()) };
+	const int workerCount{ std::clamp(hardwareThreads - 1, 1, consts::predictorMaxThreads) };
+
+	for (int i{}; i < workerCount; ++i)
+	{
+		m_workers.emplace_back(&ShotPredictor::workerLoop, this);
+	}
+}
+
+ShotPredictor::~ShotPredictor()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_requestMutex };
+		m_isStopping = true;
+	}
+	m_workAvailable.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+bool ShotPredictor::hasWork() const
+{
+	return m_isActive && getSamples(m_progress.load()) < consts::predictorMaxSamples;
+}
+
+void ShotPredictor::setDifficultyTable(const ShotDifficultyTable* difficultyTable)
+{
+	m_difficultyTable = difficultyTable;
+}
+
+void ShotPredictor::setAim(const Ball::balls_type& gameBalls, const Players& gamePlayers, const simulation::ShotParameters& shot)
+{
+	const int intendedBall{ simulation::findFirstBallOnPath(gameBalls, shot.angle) };
+
+	// only the game loop writes the request, so reading it here is safe
+	if (m_isActive
+		&& intendedBall == m_request.intendedBall
+		&& shot.power == m_request.shot.power
+		&& std::abs(shot.angle - m_request.shot.angle) < consts::predictorAimTolerance)
+	{
+		return;
+	}
+
+	// a few table lookups, available straight away
+	m_tableEstimate = -1.0f;
+	simulation::CutShotGeometry geometry{};
+	if (m_difficultyTable && simulation::getCutShotGeometry(gameBalls, shot.angle, geometry))
+	{
+		m_tableEstimate = m_difficultyTable->estimate(geometry.cutAngle, geometry.pocketDistance, geometry.cueDistance);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{ m_requestMutex };
+		m_request.gameBalls = gameBalls;
+		m_request.gamePlayers = gamePlayers;
+		m_request.shot = shot;
+		m_request.intendedBall = intendedBall;
+
+		// new generation with zeroed counts, stale results get dropped by the workers
+		const std::uint64_t nextGeneration{ (getGeneration(m_progress.load()) + 1) & 0xFFFF };
+		m_progress = nextGeneration << 48;
+
+		// nothing to predict if we are not aiming at a ball
+		m_isActive = intendedBall >= 0 && shot.power > 0;
+	}
+
+	m_workAvailable.notify_all();
+}
+
+void ShotPredictor::pause()
+{
+	m_isActive = false;
+}
+
+bool ShotPredictor::isActive() const
+{
+	return m_isActive;
+}
+
+ShotPredictor::Estimate ShotPredictor::getEstimate() const
+{
+	const std::uint64_t progress{ m_progress.load() };
+
+	Estimate estimate{};
+	estimate.intendedBall = m_request.intendedBall;
+	estimate.samples = getSamples(progress);
+	estimate.successes = getSuccesses(progress);
+	estimate.tableEstimate = m_tableEstimate;
+	return estimate;
+}
+
+void ShotPredictor::workerLoop()
+{
+	lowerCurrentThreadPriority();
+
+	std::mt19937 randomEngine{ std::random_device{}() };
+	std::normal_distribution<double> aimNoise{ 0.0, consts::predictorAimNoise };
+	std::normal_distribution<double> powerNoise{ 0.0, consts::predictorPowerNoise };
+
+	// private copy of the request, refreshed whenever the generation changes
+	Request request{};
+	std::uint64_t generation{ countMask << 40 }; // impossible generation
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock{ m_requestMutex };
+			m_workAvailable.wait(lock, [this]() { return m_isStopping || hasWork(); });
+
+			if (m_isStopping)
+				return;
+
+			const std::uint64_t currentGeneration{ getGeneration(m_progress.load()) };
+			if (currentGeneration != generation)
+			{
+				request = m_request;
+				generation = currentGeneration;
+			}
+		}
+
+		simulation::ShotParameters shot{ request.shot };
+		shot.angle += aimNoise(randomEngine);
+		shot.power = std::max(0.0, shot.power * (1.0 + powerNoise(randomEngine)));
+
+		const simulation::ShotOutcome outcome{ simulation::simulateShot(request.gameBalls, request.gamePlayers, shot) };
+		const bool didSucceed{ (outcome.pocketedMask & (1u << request.intendedBall)) != 0 };
+
+		// add the result unless the aim changed or enough samples were taken meanwhile
+		std::uint64_t progress{ m_progress.load() };
+		std::uint64_t updated;
+		do
+		{
+			if (getGeneration(progress) != generation || getSamples(progress) >= consts::predictorMaxSamples)
+				break;
+
+			updated = progress + (std::uint64_t{ 1 } << 24) + (didSucceed ? 1 : 0);
+		} while (!m_progress.compare_exchange_weak(progress, updated));
+	}
+}
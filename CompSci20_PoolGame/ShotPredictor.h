@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Ball.h"
+#include "Players.h"
+#include "ShotDifficultyTable.h"
+#include "simulation.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// estimates the chance that the current aim pockets the ball it is pointed at
+// by simulating the shot many times with some aim and power noise added.
+// the simulations run on low priority background threads, the game loop
+// only ever copies the table when the aim changes and reads an atomic.
+class ShotPredictor
+{
+public:
+	struct Estimate
+	{
+		int intendedBall{ -1 }; // -1 if the aim does not hit any ball
+		int samples{};
+		int successes{};
+		float tableEstimate{ -1.0f }; // instant estimate from the difficulty table, -1 if unavailable
+
+		double getProbability() const;
+	};
+
+private:
+	// the table and aim the workers are currently sampling
+	struct Request
+	{
+		Ball::balls_type gameBalls;
+		Players gamePlayers{ 2 };
+		simulation::ShotParameters shot{};
+		int intendedBall{ -1 };
+	};
+
+	Request m_request{};
+	std::mutex m_requestMutex;
+	std::condition_variable m_workAvailable;
+
+	// packed so workers can add results without a lock and never add
+	// to a newer aim: [generation 16 bits][samples 24 bits][successes 24 bits]
+	std::atomic<std::uint64_t> m_progress{};
+	std::atomic<bool> m_isActive{};
+	std::atomic<bool> m_isStopping{};
+
+	std::vector<std::thread> m_workers;
+
+	// optional, gives an estimate before the first samples come in
+	const ShotDifficultyTable* m_difficultyTable{};
+	float m_tableEstimate{ -1.0f };
+
+	void workerLoop();
+	bool hasWork() const;
+
+public:
+	ShotPredictor();
+	~ShotPredictor();
+
+	ShotPredictor(const ShotPredictor&) = delete;
+	ShotPredictor& operator=(const ShotPredictor&) = delete;
+
+	void setDifficultyTable(const ShotDifficultyTable* difficultyTable);
+
+	// restarts sampling only if the aim moved noticeably
+	void setAim(const Ball::balls_type& gameBalls, const Players& gamePlayers, const simulation::ShotParameters& shot);
+	// stops sampling (e.g. once the ball is shot)
+	void pause();
+
+	bool isActive() const;
+	Estimate getEstimate() const;
+};
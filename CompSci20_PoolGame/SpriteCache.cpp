@@ -0,0 +1,133 @@
+#include "SpriteCache.h"
+
+#include "constants.h"
+#include "render.h"
+#include "view.h"
+
+#include <allegro5/allegro5.h>
+#include <allegro5/allegro_font.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+SpriteCache::~SpriteCache()
+{
+	clear();
+}
+
+double SpriteCache::getBallSpriteHalfSize()
+{
+	// room for the border and a pixel of antialiasing past it
+	return consts::defaultBallRadius + consts::ballBorderThickness + 1.0;
+}
+
+bool SpriteCache::build(Level& level, ALLEGRO_FONT* const& gameFont, const bool hasBallSprites)
+{
+	ALLEGRO_BITMAP* const previousTarget{ al_get_target_bitmap() };
+
+	level.table = al_create_bitmap(
+		static_cast<int>(std::ceil(consts::worldWidth * level.scale)),
+		static_cast<int>(std::ceil(consts::worldHeight * level.scale))
+	);
+
+	const int ballSize{ static_cast<int>(std::ceil(getBallSpriteHalfSize() * 2.0 * level.scale)) };
+	if (hasBallSprites)
+	{
+		for (ALLEGRO_BITMAP*& ball : level.balls)
+			ball = al_create_bitmap(ballSize, ballSize);
+	}
+
+	const bool isBuilt{
+		level.table && (!hasBallSprites || std::all_of(level.balls.begin(), level.balls.end(), [](ALLEGRO_BITMAP* ball) { return ball != nullptr; }))
+	};
+	if (!isBuilt)
+	{
+		destroy(level);
+		return false;
+	}
+
+	// each bitmap keeps its own transform, so the backbuffer's is left alone
+	al_set_target_bitmap(level.table);
+	view::use({ level.scale, 0.0, 0.0 });
+	render::drawPlaysurface();
+	render::drawPockets();
+
+	for (int ballNumber{}; ballNumber < ballCount && hasBallSprites; ++ballNumber)
+	{
+		al_set_target_bitmap(level.balls[ballNumber]);
+		al_clear_to_color(al_map_rgba(0, 0, 0, 0));
+		view::use({ level.scale, getBallSpriteHalfSize() * level.scale, getBallSpriteHalfSize() * level.scale });
+		render::drawBall(ballNumber, 0.0, 0.0, consts::defaultBallRadius, gameFont);
+	}
+
+	al_set_target_bitmap(previousTarget);
+	return true;
+}
+
+void SpriteCache::destroy(Level& level)
+{
+	if (level.table)
+		al_destroy_bitmap(level.table);
+
+	for (ALLEGRO_BITMAP*& ball : level.balls)
+	{
+		if (ball)
+			al_destroy_bitmap(ball);
+		ball = nullptr;
+	}
+
+	level.table = nullptr;
+}
+
+bool SpriteCache::prepare(const double scale, ALLEGRO_FONT* const& gameFont, const bool hasBallSprites)
+{
+	const double levelScale{ view::getScaleLevel(scale) };
+	++m_useCount;
+
+	for (std::size_t i{}; i < m_levels.size(); ++i)
+	{
+		if (m_levels[i].scale == levelScale && (m_levels[i].balls[0] != nullptr) == hasBallSprites)
+		{
+			m_levels[i].lastUsed = m_useCount;
+			m_currentLevel = static_cast<int>(i);
+			return true;
+		}
+	}
+
+	// make room by dropping whichever level was used longest ago
+	if (!m_levels.empty() && static_cast<int>(m_levels.size()) >= consts::spriteCacheLevels)
+	{
+		const auto oldest{ std::min_element(m_levels.begin(), m_levels.end(), [](const Level& a, const Level& b) { return a.lastUsed < b.lastUsed; }) };
+		destroy(*oldest);
+		m_levels.erase(oldest);
+	}
+
+	Level level{};
+	level.scale = levelScale;
+	level.lastUsed = m_useCount;
+
+	if (!build(level, gameFont, hasBallSprites))
+	{
+		m_currentLevel = -1;
+		return false;
+	}
+
+	m_levels.push_back(level);
+	m_currentLevel = static_cast<int>(m_levels.size()) - 1;
+	return true;
+}
+
+void SpriteCache::clear()
+{
+	for (Level& level : m_levels)
+		destroy(level);
+
+	m_levels.clear();
+	m_currentLevel = -1;
+}
+
+const SpriteCache::Level* SpriteCache::getLevel() const
+{
+	return (m_currentLevel >= 0) ? &m_levels[m_currentLevel] : nullptr;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <allegro5/allegro5.h>
+#include <allegro5/allegro_font.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// the table and every ball rasterized once at the view's scale, so a frame costs
+// the same few bitmap draws however many pixels the display has
+// - scales are rounded to viewScaleStep, resizing a window a little reuses what's there
+// - the last spriteCacheLevels scales are kept, going fullscreen and back is free
+// - the balls are optional, a render quality tier can draw them with primitives instead
+// - the bitmaps belong to the display, clear() before it is destroyed
+class SpriteCache
+{
+public:
+	static constexpr int ballCount{ 16 };
+
+	struct Level
+	{
+		double scale{}; // pixels per world unit the bitmaps were drawn at
+		ALLEGRO_BITMAP* table{}; // cushions, play surface and pockets
+		std::array<ALLEGRO_BITMAP*, ballCount> balls{}; // all nullptr when the balls are drawn with primitives
+		std::uint64_t lastUsed{};
+	};
+
+private:
+	std::vector<Level> m_levels;
+	int m_currentLevel{ -1 };
+	std::uint64_t m_useCount{};
+
+	static bool build(Level& level, ALLEGRO_FONT* const& gameFont, const bool hasBallSprites);
+	static void destroy(Level& level);
+
+public:
+	SpriteCache() = default;
+	~SpriteCache();
+
+	SpriteCache(const SpriteCache&) = delete;
+	SpriteCache& operator=(const SpriteCache&) = delete;
+
+	// false if the bitmaps couldn't be made, drawing then falls back to primitives
+	bool prepare(const double scale, ALLEGRO_FONT* const& gameFont, const bool hasBallSprites);
+	void clear();
+
+	// nullptr when there is nothing prepared
+	const Level* getLevel() const;
+	// world units from a ball sprite's top left corner to its centre
+	static double getBallSpriteHalfSize();
+};
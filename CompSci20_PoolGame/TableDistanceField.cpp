@@ -0,0 +1,356 @@
+#include "TableDistanceField.h"
+
+#include "Ball.h"
+#include "common.h"
+#include "constants.h"
+#include "simulation.h"
+#include "Vector2.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+TableDistanceField::TableDistanceField()
+	: m_columns{ (consts::playSurface.xPos2 - consts::playSurface.xPos1 + consts::distanceFieldCellSize - 1) / consts::distanceFieldCellSize },
+	m_rows{ (consts::playSurface.yPos2 - consts::playSurface.yPos1 + consts::distanceFieldCellSize - 1) / consts::distanceFieldCellSize }
+{
+}
+
+int TableDistanceField::getColumns() const
+{
+	return m_columns;
+}
+
+int TableDistanceField::getRows() const
+{
+	return m_rows;
+}
+
+double TableDistanceField::getCellCentreX(const int column)
+{
+	return consts::playSurface.xPos1 + (column + 0.5) * consts::distanceFieldCellSize;
+}
+
+double TableDistanceField::getCellCentreY(const int row)
+{
+	return consts::playSurface.yPos1 + (row + 0.5) * consts::distanceFieldCellSize;
+}
+
+Vector2 TableDistanceField::getCellCentre(const int column, const int row) const
+{
+	return { getCellCentreX(column), getCellCentreY(row) };
+}
+
+int TableDistanceField::getCellIndex(const double xPos, const double yPos) const
+{
+	const int column{ static_cast<int>(std::floor((xPos - consts::playSurface.xPos1) / consts::distanceFieldCellSize)) };
+	const int row{ static_cast<int>(std::floor((yPos - consts::playSurface.yPos1) / consts::distanceFieldCellSize)) };
+
+	if (column < 0 || column >= m_columns || row < 0 || row >= m_rows)
+		return -1;
+
+	return row * m_columns + column;
+}
+
+void TableDistanceField::buildStaticLayers()
+{
+	const std::size_t cellCount{ static_cast<std::size_t>(m_columns) * m_rows };
+	m_cushionDistances.resize(cellCount);
+	m_pocketDistances.resize(cellCount);
+
+	// a ball centre this close to a pocket is pocketed (see Ball::isInPocket)
+	const double pocketMouth{ consts::pocketRadius - consts::pocketSensitivity };
+
+	for (int row{}; row < m_rows; ++row)
+	{
+		const double centreY{ getCellCentreY(row) };
+
+		for (int column{}; column < m_columns; ++column)
+		{
+			const double centreX{ getCellCentreX(column) };
+			const std::size_t cell{ static_cast<std::size_t>(row) * m_columns + column };
+
+			m_cushionDistances[cell] = static_cast<float>(std::min(
+				std::min(centreX - consts::playSurface.xPos1, consts::playSurface.xPos2 - centreX),
+				std::min(centreY - consts::playSurface.yPos1, consts::playSurface.yPos2 - centreY)
+			));
+
+			double pocketDistance{ std::numeric_limits<double>::max() };
+			for (const auto& [pocketX, pocketY] : consts::pocketCoordinates)
+				pocketDistance = std::min(pocketDistance, calculateHypotenuse(centreX - pocketX, centreY - pocketY) - pocketMouth);
+
+			m_pocketDistances[cell] = static_cast<float>(pocketDistance);
+		}
+	}
+}
+
+void TableDistanceField::rebuild(const Ball::balls_type& gameBalls)
+{
+	if (m_cushionDistances.empty())
+		buildStaticLayers();
+
+	m_ballCount = std::min(static_cast<int>(gameBalls.size()), static_cast<int>(m_balls.size()));
+	m_onTable = 0;
+	m_maxRadius = 0.0;
+
+	std::array<BallCircle, 16> visibleBalls{};
+	std::array<std::int8_t, 16> visibleNumbers{};
+	int visibleCount{};
+
+	for (int i{}; i < m_ballCount; ++i)
+	{
+		m_balls[i] = { gameBalls[i].getX(), gameBalls[i].getY(), gameBalls[i].getRadius() };
+		if (!gameBalls[i].isVisible())
+			continue;
+
+		visibleBalls[visibleCount] = m_balls[i];
+		visibleNumbers[visibleCount++] = static_cast<std::int8_t>(i);
+		m_onTable |= ballMask::getBall(i);
+		m_maxRadius = std::max(m_maxRadius, m_balls[i].radius);
+	}
+
+	// the closest few balls of every cell, by a sorted insert
+	// a ball further than the last slot can't get in, which the squared distance already shows
+	m_nearestBalls.resize(static_cast<std::size_t>(m_columns) * m_rows);
+	for (int row{}; row < m_rows; ++row)
+	{
+		const double centreY{ getCellCentreY(row) };
+
+		for (int column{}; column < m_columns; ++column)
+		{
+			const double centreX{ getCellCentreX(column) };
+
+			std::array<std::int8_t, nearestBallCount> nearest;
+			std::array<double, nearestBallCount> distances;
+			nearest.fill(-1);
+			distances.fill(std::numeric_limits<double>::max());
+
+			for (int i{}; i < visibleCount; ++i)
+			{
+				const BallCircle& ball{ visibleBalls[i] };
+				const double deltaX{ centreX - ball.x };
+				const double deltaY{ centreY - ball.y };
+				const double reach{ distances.back() + ball.radius };
+
+				if (nearest.back() >= 0 && deltaX * deltaX + deltaY * deltaY >= reach * reach)
+					continue;
+
+				double distance{ std::sqrt(deltaX * deltaX + deltaY * deltaY) - ball.radius };
+				std::int8_t ballNumber{ visibleNumbers[i] };
+
+				for (int slot{}; slot < nearestBallCount; ++slot)
+				{
+					if (distance < distances[slot])
+					{
+						std::swap(distance, distances[slot]);
+						std::swap(ballNumber, nearest[slot]);
+					}
+				}
+			}
+
+			m_nearestBalls[static_cast<std::size_t>(row) * m_columns + column] = nearest;
+		}
+	}
+
+	m_isBuilt = true;
+}
+
+bool TableDistanceField::isBuilt() const
+{
+	return m_isBuilt;
+}
+
+double TableDistanceField::getCellCushionClearance(const int column, const int row) const
+{
+	return m_cushionDistances[static_cast<std::size_t>(row) * m_columns + column];
+}
+
+double TableDistanceField::getCellPocketClearance(const int column, const int row) const
+{
+	return m_pocketDistances[static_cast<std::size_t>(row) * m_columns + column];
+}
+
+double TableDistanceField::getCellBallClearance(const int column, const int row, const ballMask_type ignoredMask) const
+{
+	const double centreX{ getCellCentreX(column) };
+	const double centreY{ getCellCentreY(row) };
+
+	// closest first, so the first ball that counts is the answer
+	for (const std::int8_t ball : m_nearestBalls[static_cast<std::size_t>(row) * m_columns + column])
+	{
+		if (ball < 0)
+			return std::numeric_limits<double>::max();
+
+		if (!(ignoredMask & ballMask::getBall(ball)))
+			return calculateHypotenuse(centreX - m_balls[ball].x, centreY - m_balls[ball].y) - m_balls[ball].radius;
+	}
+
+	return getExactBallClearance(centreX, centreY, ignoredMask);
+}
+
+double TableDistanceField::getCushionClearance(const double xPos, const double yPos) const
+{
+	const int cell{ getCellIndex(xPos, yPos) };
+
+	// off the play surface is as good as touching a cushion
+	if (cell < 0)
+		return 0.0;
+
+	const double deltaX{ xPos - getCellCentreX(cell % m_columns) };
+	const double deltaY{ yPos - getCellCentreY(cell / m_columns) };
+	return m_cushionDistances[cell] - std::sqrt(deltaX * deltaX + deltaY * deltaY);
+}
+
+double TableDistanceField::getCushionClearance(const Vector2& position) const
+{
+	return getCushionClearance(position.getX(), position.getY());
+}
+
+double TableDistanceField::getPocketClearance(const double xPos, const double yPos) const
+{
+	const int cell{ getCellIndex(xPos, yPos) };
+	if (cell < 0)
+		return 0.0;
+
+	const double deltaX{ xPos - getCellCentreX(cell % m_columns) };
+	const double deltaY{ yPos - getCellCentreY(cell / m_columns) };
+	return m_pocketDistances[cell] - std::sqrt(deltaX * deltaX + deltaY * deltaY);
+}
+
+double TableDistanceField::getPocketClearance(const Vector2& position) const
+{
+	return getPocketClearance(position.getX(), position.getY());
+}
+
+double TableDistanceField::getExactBallClearance(const double xPos, const double yPos, const ballMask_type ignoredMask) const
+{
+	double clearance{ std::numeric_limits<double>::max() };
+
+	for (int i{}; i < m_ballCount; ++i)
+	{
+		if (!(m_onTable & ballMask::getBall(i)) || (ignoredMask & ballMask::getBall(i)))
+			continue;
+
+		const double deltaX{ xPos - m_balls[i].x };
+		const double deltaY{ yPos - m_balls[i].y };
+		clearance = std::min(clearance, std::sqrt(deltaX * deltaX + deltaY * deltaY) - m_balls[i].radius);
+	}
+
+	return clearance;
+}
+
+double TableDistanceField::getBallClearance(const double xPos, const double yPos, const ballMask_type ignoredMask) const
+{
+	const int cell{ getCellIndex(xPos, yPos) };
+	if (cell < 0)
+		return getExactBallClearance(xPos, yPos, ignoredMask);
+
+	const auto& nearest{ m_nearestBalls[cell] };
+	double clearance{ std::numeric_limits<double>::max() };
+
+	for (const std::int8_t ball : nearest)
+	{
+		// fewer balls than slots, so every ball on the table has been looked at
+		if (ball < 0)
+			return clearance;
+
+		// the next closest ball could be anywhere
+		if (ignoredMask & ballMask::getBall(ball))
+			return getExactBallClearance(xPos, yPos, ignoredMask);
+
+		const double deltaX{ xPos - m_balls[ball].x };
+		const double deltaY{ yPos - m_balls[ball].y };
+		clearance = std::min(clearance, std::sqrt(deltaX * deltaX + deltaY * deltaY) - m_balls[ball].radius);
+	}
+
+	// any ball that isn't stored was at least as far from the cell centre as the last one that is
+	const double centreX{ getCellCentreX(cell % m_columns) };
+	const double centreY{ getCellCentreY(cell / m_columns) };
+	const BallCircle& last{ m_balls[nearest.back()] };
+
+	const double unstoredClearance{
+		calculateHypotenuse(centreX - last.x, centreY - last.y) - last.radius
+		- calculateHypotenuse(xPos - centreX, yPos - centreY)
+	};
+
+	return std::min(clearance, unstoredClearance);
+}
+
+double TableDistanceField::getBallClearance(const Vector2& position, const ballMask_type ignoredMask) const
+{
+	return getBallClearance(position.getX(), position.getY(), ignoredMask);
+}
+
+bool TableDistanceField::isPathClearExact(const Vector2& start, const Vector2& end, const ballMask_type ignoredMask) const
+{
+	for (int i{}; i < m_ballCount; ++i)
+	{
+		if (!(m_onTable & ballMask::getBall(i)) || (ignoredMask & ballMask::getBall(i)))
+			continue;
+
+		if (simulation::isPointNearPath({ m_balls[i].x, m_balls[i].y }, start, end, 2.0 * m_balls[i].radius))
+			return false;
+	}
+
+	return true;
+}
+
+bool TableDistanceField::isPathClear(const Vector2& start, const Vector2& end, const ballMask_type ignoredMask) const
+{
+	const double startX{ start.getX() };
+	const double startY{ start.getY() };
+	const double length{ calculateHypotenuse(end.getX() - startX, end.getY() - startY) };
+
+	if (!m_isBuilt || length <= 0.0)
+		return isPathClearExact(start, end, ignoredMask);
+
+	const double directionX{ (end.getX() - startX) / length };
+	const double directionY{ (end.getY() - startY) / length };
+
+	// every point within (clearance - radius) of a point on the path is far enough
+	// from every ball, so the path is clear that far on without looking any closer
+	double travelled{};
+	for (int step{}; step < consts::distanceFieldMaxSteps; ++step)
+	{
+		const double freeDistance{ getBallClearance(startX + directionX * travelled, startY + directionY * travelled, ignoredMask) - m_maxRadius };
+
+		// a ball might be in the way, only the exact check can say
+		if (freeDistance < consts::distanceFieldMinStep)
+			break;
+
+		travelled += freeDistance;
+		if (travelled >= length)
+			return true;
+	}
+
+	return isPathClearExact(start, end, ignoredMask);
+}
+
+double TableDistanceField::castBall(const Vector2& start, const Vector2& direction, const double radius, const ballMask_type ignoredMask, const double maxDistance) const
+{
+	if (!m_isBuilt)
+		return 0.0;
+
+	const double startX{ start.getX() };
+	const double startY{ start.getY() };
+
+	double travelled{};
+	for (int step{}; step < consts::distanceFieldMaxSteps; ++step)
+	{
+		const double xPos{ startX + direction.getX() * travelled };
+		const double yPos{ startY + direction.getY() * travelled };
+		const double freeDistance{ std::min(getCushionClearance(xPos, yPos), getBallClearance(xPos, yPos, ignoredMask)) - radius };
+
+		if (freeDistance < consts::distanceFieldMinStep)
+			break;
+
+		travelled += freeDistance;
+		if (travelled >= maxDistance)
+			return maxDistance;
+	}
+
+	return travelled;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Ball.h"
+#include "common.h"
+#include "Vector2.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// distances from everywhere on the play surface to the things a ball can run into
+// - static layers: the cushions and the pocket mouths, built once
+// - dynamic layer: the closest few resting balls of every cell, rebuilt whenever
+//   the balls come to rest, so any ball can be left out of a query afterwards
+// values are exact at cell centres, anywhere else they are lower bounds
+// (a distance can't shrink faster than you move), which is all the queries need
+class TableDistanceField
+{
+public:
+	static constexpr int nearestBallCount{ 3 };
+
+private:
+	struct BallCircle
+	{
+		double x{};
+		double y{};
+		double radius{};
+	};
+
+	int m_columns{};
+	int m_rows{};
+
+	std::vector<float> m_cushionDistances;
+	std::vector<float> m_pocketDistances; // to the edge of where a ball centre gets pocketed
+
+	// closest first, -1 past the last visible ball
+	std::vector<std::array<std::int8_t, nearestBallCount>> m_nearestBalls;
+	std::array<BallCircle, 16> m_balls{};
+	int m_ballCount{};
+	ballMask_type m_onTable{};
+	double m_maxRadius{};
+	bool m_isBuilt{};
+
+	void buildStaticLayers();
+
+	int getCellIndex(const double xPos, const double yPos) const;
+	static double getCellCentreX(const int column);
+	static double getCellCentreY(const int row);
+
+	// checks every ball, for queries the stored balls can't answer
+	double getExactBallClearance(const double xPos, const double yPos, const ballMask_type ignoredMask) const;
+	bool isPathClearExact(const Vector2& start, const Vector2& end, const ballMask_type ignoredMask) const;
+
+public:
+	TableDistanceField();
+
+	void rebuild(const Ball::balls_type& gameBalls);
+	bool isBuilt() const;
+
+	int getColumns() const;
+	int getRows() const;
+	Vector2 getCellCentre(const int column, const int row) const;
+
+	// exact at the centre of a cell, for walking the whole grid
+	double getCellCushionClearance(const int column, const int row) const;
+	double getCellPocketClearance(const int column, const int row) const;
+	double getCellBallClearance(const int column, const int row, const ballMask_type ignoredMask) const;
+
+	// lower bounds on the distance to the closest cushion, pocket mouth
+	// or surface of a ball not in ignoredMask
+	double getCushionClearance(const double xPos, const double yPos) const;
+	double getCushionClearance(const Vector2& position) const;
+	double getPocketClearance(const double xPos, const double yPos) const;
+	double getPocketClearance(const Vector2& position) const;
+	double getBallClearance(const double xPos, const double yPos, const ballMask_type ignoredMask) const;
+	double getBallClearance(const Vector2& position, const ballMask_type ignoredMask) const;
+
+	// the same answer as simulation::isPathClear, usually without looking at every ball
+	bool isPathClear(const Vector2& start, const Vector2& end, const ballMask_type ignoredMask) const;
+
+	// how far a ball of radius can travel from start along direction (normalized)
+	// before it touches a cushion or a ball not in ignoredMask, at most maxDistance
+	double castBall(const Vector2& start, const Vector2& direction, const double radius, const ballMask_type ignoredMask, const double maxDistance) const;
+};
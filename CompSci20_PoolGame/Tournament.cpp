@@ -0,0 +1,494 @@
+#include "Tournament.h"
+
+#include "Ball.h"
+#include "Bot.h"
+#include "Players.h"
+#include "common.h"
+#include "constants.h"
+#include "metrics.h"
+#include "physics.h"
+#include "referee.h"
+#include "ShotDataset.h"
+#include "simulation.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+Tournament::Tournament(const Settings& settings, const std::vector<Bot::Config>& configs)
+	: m_settings{ settings }
+{
+	for (const Bot::Config& config : configs)
+	{
+		Entrant entrant{};
+		entrant.config = config;
+		entrant.rating = consts::eloStartRating;
+		m_entrants.push_back(entrant);
+	}
+}
+
+bool Tournament::parseFormat(const std::string& text, Format& format)
+{
+	if (text == "round-robin")
+		format = Format::roundRobin;
+	else if (text == "swiss")
+		format = Format::swiss;
+	else
+		return false;
+
+	return true;
+}
+
+const char* Tournament::getFormatName(const Format format)
+{
+	return (format == Format::swiss) ? "swiss" : "round-robin";
+}
+
+Tournament::MatchResult Tournament::playMatch(const Bot::Config& first, const Bot::Config& second, const unsigned int seed, const std::uint32_t matchId, const std::string& replayPath)
+{
+	Ball::balls_type gameBalls;
+	simulation::createBalls(gameBalls, 16, consts::defaultBallRadius, consts::defaultBallMass);
+	// the bots take seed and seed + 1
+	std::mt19937 rackEngine{ seed + 2 };
+	simulation::setupRack(gameBalls, rackEngine);
+	ballMask_type onTable{ ballMask::getOnTable(gameBalls) };
+
+	Players gamePlayers{ 2 };
+	gamePlayers.getPlayer(0).name = first.name;
+	gamePlayers.getPlayer(1).name = second.name;
+	gamePlayers.setPlayerIndex(0);
+
+	std::array<Bot, 2> bots{ Bot{ first, seed }, Bot{ second, seed + 1 } };
+	bool hasBallInHand{};
+
+	ShotDatasetWriter* const recorder{ simulation::getShotRecorder() };
+	const bool isRecordingShots{ recorder && recorder->isRecording(shotDataset::Source::played) };
+
+	// a match that was cut short is played again from the break, so its old replay goes
+	ShotDatasetWriter replay;
+	if (!replayPath.empty())
+	{
+		std::remove(replayPath.c_str());
+		if (!replay.open(replayPath, true, false, first.name, second.name))
+			std::cout << "Could not write replay " << replayPath << '\n';
+	}
+
+	const bool isRecording{ isRecordingShots || replay.isOpen() };
+	Ball::balls_type startBalls;
+
+	for (int turnCount{}; turnCount < consts::tournamentMaxTurns; ++turnCount)
+	{
+		Bot& bot{ bots[gamePlayers.getCurrentIndex()] };
+
+		if (hasBallInHand)
+			bot.placeCueBall(gameBalls, gamePlayers);
+
+		const simulation::ShotParameters shot{ bot.chooseShot(gameBalls, gamePlayers) };
+		if (isRecording)
+			startBalls = gameBalls;
+
+		TurnInformation turn{};
+		simulation::applyShot(gameBalls, shot);
+		const int ticks{ simulation::runUntilRest(gameBalls, gamePlayers, turn) };
+
+		// runUntilRest gives up after a while, whatever is still rolling stops here
+		for (Ball& ball : gameBalls)
+			ball.setVelocity(0, 0);
+
+		if (isRecording)
+		{
+			shotDataset::Row row{ shotDataset::makeRow(startBalls, gameBalls, gamePlayers.getCurrentPlayer(), shot, turn, ticks) };
+			row.source = shotDataset::Source::played;
+			row.player = static_cast<std::uint8_t>(gamePlayers.getCurrentIndex());
+			row.match = matchId;
+			row.ballInHand = hasBallInHand;
+
+			if (isRecordingShots)
+				recorder->append(row);
+			if (replay.isOpen())
+				replay.append(row);
+		}
+
+		// the same rules GameLogic::endTurn applies
+		const bool hasPocketedBall{ turn.pocketedBalls != 0 };
+		const bool didFoul{ !referee::isTurnValid(gamePlayers.getCurrentPlayer(), turn) };
+
+		onTable = ballMask::getAfterTurn(onTable, turn.pocketedBalls);
+		if (referee::isGameFinished(onTable))
+		{
+			const bool isFirstShooting{ gamePlayers.getCurrentIndex() == 0 };
+			return (isFirstShooting != didFoul) ? MatchResult::firstWon : MatchResult::secondWon;
+		}
+
+		referee::addTurnScores(gamePlayers, turn);
+
+		if (didFoul)
+			gameBalls[0].setVisible(false);
+
+		hasBallInHand = didFoul;
+
+		if (didFoul || !hasPocketedBall)
+			gamePlayers.advancePlayerIndex();
+	}
+
+	return MatchResult::draw;
+}
+
+void Tournament::scheduleRound()
+{
+	const int entrantCount{ static_cast<int>(m_entrants.size()) };
+	std::vector<std::array<int, 2>> pairings;
+
+	if (m_settings.format == Format::roundRobin)
+	{
+		for (int i{}; i < entrantCount; ++i)
+		{
+			for (int j{ i + 1 }; j < entrantCount; ++j)
+				pairings.push_back({ i, j });
+		}
+	}
+	else
+	{
+		// how often every pair has already met
+		std::vector<int> meetings(static_cast<std::size_t>(entrantCount) * entrantCount);
+		for (const std::vector<Match>& round : m_rounds)
+		{
+			for (const Match& match : round)
+			{
+				++meetings[match.first * entrantCount + match.second];
+				++meetings[match.second * entrantCount + match.first];
+			}
+		}
+
+		std::vector<int> order(entrantCount);
+		for (int i{}; i < entrantCount; ++i)
+			order[i] = i;
+
+		std::stable_sort(order.begin(), order.end(), [this](const int a, const int b) {
+			return m_entrants[a].rating > m_entrants[b].rating;
+		});
+
+		// pair each bot with the closest rated one it has met the least,
+		// with an odd number of bots the lowest rated one left sits out
+		std::vector<bool> isPaired(entrantCount);
+		for (int i{}; i < entrantCount; ++i)
+		{
+			const int a{ order[i] };
+			if (isPaired[a])
+				continue;
+
+			int bestOpponent{ -1 };
+			for (int j{ i + 1 }; j < entrantCount; ++j)
+			{
+				const int b{ order[j] };
+				if (!isPaired[b] && (bestOpponent < 0 || meetings[a * entrantCount + b] < meetings[a * entrantCount + bestOpponent]))
+					bestOpponent = b;
+			}
+
+			if (bestOpponent < 0)
+				break;
+
+			isPaired[a] = true;
+			isPaired[bestOpponent] = true;
+			pairings.push_back({ a, bestOpponent });
+		}
+	}
+
+	std::vector<Match> round;
+	for (const auto& [a, b] : pairings)
+	{
+		for (int game{}; game < m_settings.gamesPerPairing; ++game)
+		{
+			Match match{};
+			match.first = (game % 2 == 0) ? a : b;
+			match.second = (game % 2 == 0) ? b : a;
+			round.push_back(match);
+		}
+	}
+
+	m_rounds.push_back(round);
+}
+
+void Tournament::recordResult(const int round, const int matchIndex, const MatchResult result, const physics::StepCounters& counters)
+{
+	std::lock_guard<std::mutex> lock{ m_resultMutex };
+	m_stepCounters.merge(counters);
+
+	if (!m_settings.countersPath.empty())
+	{
+		std::ofstream file{ m_settings.countersPath, std::ios::app };
+		physics::writeStepCounters(file, "match", "round" + std::to_string(round + 1) + "_match" + std::to_string(matchIndex + 1), counters);
+	}
+
+	Match& match{ m_rounds[round][matchIndex] };
+	match.result = result;
+
+	Entrant& first{ m_entrants[match.first] };
+	Entrant& second{ m_entrants[match.second] };
+
+	double firstScore{ 0.5 };
+	if (result == MatchResult::firstWon)
+	{
+		firstScore = 1.0;
+		++first.wins;
+		++second.losses;
+	}
+	else if (result == MatchResult::secondWon)
+	{
+		firstScore = 0.0;
+		++first.losses;
+		++second.wins;
+	}
+	else
+	{
+		++first.draws;
+		++second.draws;
+	}
+
+	// standard elo, applied as soon as the match is done
+	const double expectedScore{ 1.0 / (1.0 + std::pow(10.0, (second.rating - first.rating) / 400.0)) };
+	const double change{ consts::eloKFactor * (firstScore - expectedScore) };
+	first.rating += change;
+	second.rating -= change;
+
+	const char* resultName{
+		(result == MatchResult::firstWon) ? first.config.name.c_str()
+		: ((result == MatchResult::secondWon) ? second.config.name.c_str() : "nobody")
+	};
+
+	std::cout << "[Round " << (round + 1) << "] " << first.config.name << " vs " << second.config.name
+		<< ": " << resultName << " won (" << std::fixed << std::setprecision(0)
+		<< first.rating << ", " << second.rating << ")\n" << std::defaultfloat;
+
+	if (!m_settings.checkpointPath.empty() && !saveCheckpoint())
+		std::cout << "Could not write checkpoint " << m_settings.checkpointPath << '\n';
+}
+
+void Tournament::playRound(const int round)
+{
+	std::vector<int> pendingMatches;
+	for (int i{}; i < static_cast<int>(m_rounds[round].size()); ++i)
+	{
+		if (m_rounds[round][i].result == MatchResult::pending)
+			pendingMatches.push_back(i);
+	}
+
+	std::atomic<int> nextMatch{};
+
+	const auto playMatches{ [&]() {
+		std::random_device randomDevice;
+
+		for (int i{ nextMatch++ }; i < static_cast<int>(pendingMatches.size()); i = nextMatch++)
+		{
+			const std::int64_t workStart{ metrics::beginWork() };
+			metrics::setQueueDepth(std::max(0, static_cast<int>(pendingMatches.size()) - nextMatch.load()));
+
+			const int matchIndex{ pendingMatches[i] };
+			const Match& match{ m_rounds[round][matchIndex] };
+
+			// the configs never change while the round is played, only the results do
+			const std::uint32_t matchId{ static_cast<std::uint32_t>(round) << 16 | static_cast<std::uint32_t>(matchIndex) };
+			const std::string replayPath{
+				m_settings.replayDirectory.empty() ? std::string{}
+				: (std::filesystem::path{ m_settings.replayDirectory } / ("round" + std::to_string(round + 1) + "_match" + std::to_string(matchIndex + 1) + ".shots")).string()
+			};
+
+			// the bots' own lookahead simulations are counted too, they are most of the work
+			const physics::StepCounters countersBefore{ physics::getStepCounters() };
+			const MatchResult result{ playMatch(m_entrants[match.first].config, m_entrants[match.second].config, randomDevice(), matchId, replayPath) };
+			recordResult(round, matchIndex, result, physics::getStepCounters().getDifference(countersBefore));
+
+			metrics::endWork(workStart);
+		}
+	} };
+
+	const int threadCount{ std::clamp(m_settings.threadCount, 1, std::max(1, static_cast<int>(pendingMatches.size()))) };
+	metrics::setQueueDepth(static_cast<int>(pendingMatches.size()));
+	metrics::setWorkerCount(threadCount);
+
+	std::vector<std::thread> threads;
+	for (int i{}; i < threadCount; ++i)
+	{
+		threads.emplace_back(playMatches);
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	metrics::setWorkerCount(0);
+}
+
+void Tournament::run()
+{
+	if (!m_settings.checkpointPath.empty() && loadCheckpoint())
+		std::cout << "[Resuming] " << m_settings.checkpointPath << "\n\n";
+
+	std::error_code error;
+	if (!m_settings.replayDirectory.empty() && !std::filesystem::create_directories(m_settings.replayDirectory, error) && error)
+		std::cout << "Could not create replay directory " << m_settings.replayDirectory << '\n';
+
+	for (int round{}; round < m_settings.rounds; ++round)
+	{
+		// swiss pairings need the ratings from the round before, so rounds are scheduled one at a time
+		if (round >= static_cast<int>(m_rounds.size()))
+		{
+			scheduleRound();
+
+			if (!m_settings.checkpointPath.empty())
+				saveCheckpoint();
+		}
+
+		playRound(round);
+	}
+}
+
+void Tournament::printStandings() const
+{
+	std::vector<Entrant> standings{ m_entrants };
+	std::stable_sort(standings.begin(), standings.end(), [](const Entrant& a, const Entrant& b) {
+		return a.rating > b.rating;
+	});
+
+	std::cout << "\n[Standings] " << getFormatName(m_settings.format) << ", " << m_rounds.size() << " rounds\n";
+	for (const Entrant& entrant : standings)
+	{
+		std::cout << std::left << std::setw(12) << entrant.config.name << std::right
+			<< std::fixed << std::setprecision(0) << std::setw(6) << entrant.rating << std::defaultfloat
+			<< "  " << entrant.wins << "-" << entrant.losses << "-" << entrant.draws << '\n';
+	}
+
+	if (m_stepCounters.ticks > 0)
+	{
+		std::cout << "\n[Physics] matches played this run\n";
+		physics::printStepCounters(m_stepCounters);
+	}
+	std::cout << '\n';
+}
+
+// plain text so it can be read (or fixed) by hand:
+//   header, settings, one line per entrant, then every round with its matches
+bool Tournament::saveCheckpoint() const
+{
+	// written next to the real file and swapped in, so a crash never leaves half a checkpoint
+	const std::string temporaryPath{ m_settings.checkpointPath + ".tmp" };
+	{
+		std::ofstream file{ temporaryPath, std::ios::trunc };
+		if (!file)
+			return false;
+
+		file << "POOLTOURNAMENT 1\n";
+		file << "format " << getFormatName(m_settings.format) << '\n';
+		file << "games " << m_settings.gamesPerPairing << '\n';
+		file << "entrants " << m_entrants.size() << '\n';
+		file << std::setprecision(17);
+
+		for (const Entrant& entrant : m_entrants)
+		{
+			file << std::quoted(entrant.config.name) << ' ' << entrant.rating << ' '
+				<< entrant.wins << ' ' << entrant.losses << ' ' << entrant.draws << '\n';
+		}
+
+		file << "rounds " << m_rounds.size() << '\n';
+		for (const std::vector<Match>& round : m_rounds)
+		{
+			file << round.size() << '\n';
+			for (const Match& match : round)
+				file << match.first << ' ' << match.second << ' ' << static_cast<int>(match.result) << '\n';
+		}
+
+		if (!file)
+			return false;
+	}
+
+	// there is never a moment without a checkpoint
+	return replaceFile(temporaryPath, m_settings.checkpointPath);
+}
+
+bool Tournament::loadCheckpoint()
+{
+	std::ifstream file{ m_settings.checkpointPath };
+	if (!file)
+		return false;
+
+	std::string magic;
+	int version{};
+	std::string label;
+	std::string formatName;
+	int gamesPerPairing{};
+	std::size_t entrantCount{};
+
+	file >> magic >> version >> label >> formatName >> label >> gamesPerPairing >> label >> entrantCount;
+
+	Format format{};
+	if (!file || magic != "POOLTOURNAMENT" || version != 1 || !parseFormat(formatName, format))
+		return false;
+
+	// only resume the same tournament
+	if (format != m_settings.format || gamesPerPairing != m_settings.gamesPerPairing || entrantCount != m_entrants.size())
+	{
+		std::cout << "[Checkpoint] " << m_settings.checkpointPath << " is for a different tournament, starting over.\n\n";
+		return false;
+	}
+
+	std::vector<Entrant> entrants{ m_entrants };
+	for (Entrant& entrant : entrants)
+	{
+		std::string name;
+		file >> std::quoted(name) >> entrant.rating >> entrant.wins >> entrant.losses >> entrant.draws;
+
+		if (!file || name != entrant.config.name)
+		{
+			std::cout << "[Checkpoint] " << m_settings.checkpointPath << " is for different bots, starting over.\n\n";
+			return false;
+		}
+	}
+
+	std::size_t roundCount{};
+	file >> label >> roundCount;
+
+	std::vector<std::vector<Match>> rounds(roundCount);
+	for (std::vector<Match>& round : rounds)
+	{
+		std::size_t matchCount{};
+		file >> matchCount;
+
+		round.resize(matchCount);
+		for (Match& match : round)
+		{
+			int result{};
+			file >> match.first >> match.second >> result;
+
+			if (!file || match.first < 0 || match.second < 0
+				|| match.first >= static_cast<int>(entrantCount) || match.second >= static_cast<int>(entrantCount))
+			{
+				return false;
+			}
+
+			// anything that wasn't finished is played again
+			match.result = (result >= static_cast<int>(MatchResult::pending) && result <= static_cast<int>(MatchResult::draw))
+				? static_cast<MatchResult>(result)
+				: MatchResult::pending;
+		}
+	}
+
+	if (!file)
+		return false;
+
+	m_entrants = entrants;
+	m_rounds = rounds;
+	return true;
+}
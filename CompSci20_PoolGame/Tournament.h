@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Bot.h"
+#include "physics.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// plays bot configs against each other headlessly to compare them
+// - round robin (everyone plays everyone each round) or swiss (each round
+//   pairs bots with close ratings that haven't met yet)
+// - the matches of a round are played in parallel
+// - elo ratings are updated as each match finishes, and the whole state is
+//   written to a checkpoint file so a long run can be stopped and resumed
+class Tournament
+{
+public:
+	enum class Format
+	{
+		roundRobin,
+		swiss
+	};
+
+	struct Settings
+	{
+		Format format{};
+		int rounds{ 1 };
+		int gamesPerPairing{ 2 }; // players take turns breaking
+		int threadCount{ 1 };
+		std::string checkpointPath;
+		std::string replayDirectory; // every match is recorded to its own shot dataset if set
+		std::string countersPath; // every match's physics counters are appended here if set
+	};
+
+	struct Entrant
+	{
+		Bot::Config config;
+		double rating{};
+		int wins{};
+		int losses{};
+		int draws{};
+	};
+
+	enum class MatchResult
+	{
+		pending,
+		firstWon,
+		secondWon,
+		draw
+	};
+
+	struct Match
+	{
+		int first{}; // breaks
+		int second{};
+		MatchResult result{};
+	};
+
+private:
+	Settings m_settings;
+	std::vector<Entrant> m_entrants;
+	std::vector<std::vector<Match>> m_rounds;
+
+	// guards the entrants, the results and the checkpoint file while matches run
+	std::mutex m_resultMutex;
+
+	// every match played by this run, not just since the checkpoint
+	physics::StepCounters m_stepCounters{};
+
+	void scheduleRound();
+	void playRound(const int round);
+	void recordResult(const int round, const int matchIndex, const MatchResult result, const physics::StepCounters& counters);
+
+	bool saveCheckpoint() const;
+	bool loadCheckpoint();
+
+public:
+	Tournament(const Settings& settings, const std::vector<Bot::Config>& configs);
+
+	// picks up from the checkpoint file if there is one for the same bots
+	void run();
+	void printStandings() const;
+
+	// matchId only tags the recorded shots, if shots are being recorded,
+	// replayPath is overwritten with just this match's played shots if it isn't empty
+	static MatchResult playMatch(const Bot::Config& first, const Bot::Config& second, const unsigned int seed, const std::uint32_t matchId, const std::string& replayPath = {});
+
+	static bool parseFormat(const std::string& text, Format& format);
+	static const char* getFormatName(const Format format);
+};
@@ -0,0 +1,390 @@
+#include "TrickShotSolver.h"
+
+#include "Ball.h"
+#include "Players.h"
+#include "constants.h"
+#include "simulation.h"
+#include "Vector2.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+static bool isSidePocket(const int pocketIndex)
+{
+	// the middle two pockets of the pocket list
+	return pocketIndex == 1 || pocketIndex == 4;
+}
+
+static bool isPocketAllowed(const TrickShotSolver::Target& target, const int pocketIndex)
+{
+	switch (target.pockets)
+	{
+	case TrickShotSolver::PocketGroup::corner:
+		return !isSidePocket(pocketIndex);
+	case TrickShotSolver::PocketGroup::side:
+		return isSidePocket(pocketIndex);
+	case TrickShotSolver::PocketGroup::single:
+		return pocketIndex == target.pocketIndex;
+	default:
+		return true;
+	}
+}
+
+static Vector2 rotateVector(const Vector2& vec2, const double angle)
+{
+	const double cosine{ std::cos(angle) };
+	const double sine{ std::sin(angle) };
+	return Vector2(vec2.getX() * cosine - vec2.getY() * sine, vec2.getX() * sine + vec2.getY() * cosine);
+}
+
+bool TrickShotSolver::Target::isValid() const
+{
+	return !ballSequence.empty() && (pockets != PocketGroup::single || pocketIndex >= 0);
+}
+
+bool TrickShotSolver::parseTarget(std::string_view text, Target& target)
+{
+	target = {};
+
+	std::istringstream stream{ std::string{ text } };
+	std::string word;
+	while (stream >> word)
+	{
+		std::transform(word.begin(), word.end(), word.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+		if (std::isdigit(static_cast<unsigned char>(word[0])))
+		{
+			const int ballNumber{ std::atoi(word.c_str()) };
+
+			// cue ball can't be part of the sequence and balls can only be used once
+			if (ballNumber < 1 || ballNumber > 15
+				|| std::find(target.ballSequence.begin(), target.ballSequence.end(), ballNumber) != target.ballSequence.end())
+			{
+				return false;
+			}
+
+			target.ballSequence.push_back(ballNumber);
+		}
+		else if (word == "corner")
+		{
+			target.pockets = PocketGroup::corner;
+		}
+		else if (word == "side")
+		{
+			target.pockets = PocketGroup::side;
+		}
+		else if (word == "any")
+		{
+			target.pockets = PocketGroup::any;
+		}
+		else if (word.size() == 2 && word[0] == 'p' && word[1] >= '1' && word[1] <= '6')
+		{
+			target.pockets = PocketGroup::single;
+			target.pocketIndex = word[1] - '1';
+		}
+		// filler words like "into" and "pocket" are ignored
+	}
+
+	return target.isValid();
+}
+
+std::string TrickShotSolver::getTargetName(const Target& target)
+{
+	std::string name;
+	for (const int ballNumber : target.ballSequence)
+	{
+		name += std::to_string(ballNumber) + " into ";
+	}
+
+	switch (target.pockets)
+	{
+	case PocketGroup::corner:
+		return name + "corner pocket";
+	case PocketGroup::side:
+		return name + "side pocket";
+	case PocketGroup::single:
+		return name + "pocket " + std::to_string(target.pocketIndex + 1);
+	default:
+		return name + "any pocket";
+	}
+}
+
+std::uint64_t TrickShotSolver::getCacheKey(const Ball::balls_type& gameBalls, const Target& target)
+{
+	// FNV-1a over the exact table state and the target
+	std::uint64_t hash{ 14695981039346656037ull };
+	const auto addBytes{ [&hash](const void* data, const std::size_t size) {
+		const unsigned char* bytes{ static_cast<const unsigned char*>(data) };
+		for (std::size_t i{}; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	} };
+
+	for (const Ball& ball : gameBalls)
+	{
+		const double position[2]{ ball.getX(), ball.getY() };
+		const bool isVisible{ ball.isVisible() };
+		addBytes(position, sizeof(position));
+		addBytes(&isVisible, sizeof(isVisible));
+	}
+
+	for (const int ballNumber : target.ballSequence)
+		addBytes(&ballNumber, sizeof(ballNumber));
+
+	addBytes(&target.pockets, sizeof(target.pockets));
+	addBytes(&target.pocketIndex, sizeof(target.pocketIndex));
+
+	return hash;
+}
+
+std::vector<TrickShotSolver::BeamNode> TrickShotSolver::searchBeam(const Ball::balls_type& gameBalls, const Target& target) const
+{
+	const double contactDistance{ 2.0 * consts::defaultBallRadius };
+
+	// the chain of balls from the cue ball to the ball that gets pocketed
+	std::vector<int> chain{ 0 };
+	chain.insert(chain.end(), target.ballSequence.begin(), target.ballSequence.end());
+
+	const auto keepBest{ [](std::vector<BeamNode>& beam) {
+		std::sort(beam.begin(), beam.end(), [](const BeamNode& a, const BeamNode& b) { return a.difficulty < b.difficulty; });
+		if (static_cast<int>(beam.size()) > consts::trickShotBeamWidth)
+			beam.resize(consts::trickShotBeamWidth);
+	} };
+
+	// last ball into every allowed pocket, aiming across the pocket mouth
+	std::vector<BeamNode> beam;
+	const Ball& lastBall{ gameBalls[chain.back()] };
+
+	for (int pocketIndex{}; pocketIndex < static_cast<int>(consts::pocketCoordinates.size()); ++pocketIndex)
+	{
+		if (!isPocketAllowed(target, pocketIndex))
+			continue;
+
+		const Vector2 pocket(consts::pocketCoordinates[pocketIndex][0], consts::pocketCoordinates[pocketIndex][1]);
+		if (!simulation::isPathClear(gameBalls, lastBall.getPositionVector(), pocket, 1u << chain.back()))
+			continue;
+
+		const Vector2 toPocket{ pocket.copyAndSubtract(lastBall.getPositionVector()) };
+		const Vector2 across{ -toPocket.getNormalized().getY(), toPocket.getNormalized().getX() };
+
+		for (int offset{ -1 }; offset <= 1; ++offset)
+		{
+			const Vector2 aimPoint{ pocket.copyAndAdd(across.copyAndMultiply(offset * consts::trickShotPocketSpread)) };
+
+			BeamNode node{};
+			node.travelDirection = aimPoint.copyAndSubtract(lastBall.getPositionVector()).getNormalized();
+			node.pocketIndex = pocketIndex;
+			node.difficulty = toPocket.getLength() / consts::worldWidth + std::abs(offset) * 0.05;
+			beam.push_back(node);
+		}
+	}
+
+	// walk backwards, each ball has to be sent to the ghost ball of the next one
+	for (int level{ static_cast<int>(chain.size()) - 1 }; level > 0 && !beam.empty(); --level)
+	{
+		const Ball& nextBall{ gameBalls[chain[level]] };
+		const Ball& previousBall{ gameBalls[chain[level - 1]] };
+		const unsigned int ignoredMask{ (1u << chain[level]) | (1u << chain[level - 1]) };
+
+		std::vector<BeamNode> expanded;
+		for (const BeamNode& node : beam)
+		{
+			const Vector2 ghostBall{ nextBall.getPositionVector().copyAndSubtract(node.travelDirection.copyAndMultiply(contactDistance)) };
+			const Vector2 toGhost{ ghostBall.copyAndSubtract(previousBall.getPositionVector()) };
+			const Vector2 direction{ toGhost.getNormalized() };
+
+			const double cutAngle{ std::acos(std::clamp(direction.getDotProduct(node.travelDirection), -1.0, 1.0)) };
+			if (cutAngle > consts::trickShotMaxCutAngle)
+				continue;
+
+			if (!simulation::isPathClear(gameBalls, previousBall.getPositionVector(), ghostBall, ignoredMask))
+				continue;
+
+			// thin cuts over long distances are the hard part
+			const double difficulty{ node.difficulty + (toGhost.getLength() / consts::worldWidth) / std::cos(cutAngle) };
+
+			for (int offset{ -1 }; offset <= 1; ++offset)
+			{
+				BeamNode expandedNode{ node };
+				expandedNode.travelDirection = rotateVector(direction, offset * consts::trickShotAimSpread);
+				expandedNode.difficulty = difficulty + std::abs(offset) * 0.05;
+				expanded.push_back(expandedNode);
+			}
+		}
+
+		beam = std::move(expanded);
+		keepBest(beam);
+	}
+
+	return beam;
+}
+
+TrickShotSolver::Solution TrickShotSolver::refine(const Ball::balls_type& gameBalls, const Players& gamePlayers, const Target& target, const std::vector<BeamNode>& beam) const
+{
+	static constexpr int aimCount{ 2 * consts::trickShotAimSteps + 1 };
+	static constexpr int gridSize{ consts::trickShotPowerLevels * aimCount };
+
+	struct NodeResult
+	{
+		Solution solution{};
+		int bestNeighbours{ -1 };
+	};
+
+	// simulates the grid of powers and aim offsets around one beam aim
+	const auto refineNode{ [&](const BeamNode& node) {
+		const double baseAngle{ std::atan2(node.travelDirection.getY(), node.travelDirection.getX()) };
+		const int lastBall{ target.ballSequence.back() };
+
+		bool successes[consts::trickShotPowerLevels][aimCount]{};
+		int successCount{};
+		Ball::balls_type restingBalls;
+
+		for (int powerIndex{}; powerIndex < consts::trickShotPowerLevels; ++powerIndex)
+		{
+			for (int aimIndex{}; aimIndex < aimCount; ++aimIndex)
+			{
+				simulation::ShotParameters shot{};
+				shot.angle = baseAngle + (aimIndex - consts::trickShotAimSteps) * consts::trickShotAimStep;
+				shot.power = static_cast<double>(consts::cueStickMaxPower) * (powerIndex + 1) / consts::trickShotPowerLevels;
+
+				const simulation::ShotOutcome outcome{ simulation::simulateShot(gameBalls, gamePlayers, shot, restingBalls) };
+				const bool didSucceed{
+					outcome.firstHitBallNumber == target.ballSequence.front()
+					&& !outcome.cueBallPocketed
+					&& (outcome.pocketedMask & (1u << lastBall))
+					&& isPocketAllowed(target, simulation::getNearestPocketIndex(restingBalls[lastBall].getX(), restingBalls[lastBall].getY()))
+				};
+
+				successes[powerIndex][aimIndex] = didSucceed;
+				successCount += didSucceed;
+			}
+		}
+
+		// prefer the aim with the most successful neighbours, it is the most forgiving one
+		NodeResult result{};
+		for (int powerIndex{}; powerIndex < consts::trickShotPowerLevels; ++powerIndex)
+		{
+			for (int aimIndex{}; aimIndex < aimCount; ++aimIndex)
+			{
+				if (!successes[powerIndex][aimIndex])
+					continue;
+
+				int neighbours{};
+				for (int dp{ -1 }; dp <= 1; ++dp)
+				{
+					for (int da{ -1 }; da <= 1; ++da)
+					{
+						const int p{ powerIndex + dp };
+						const int a{ aimIndex + da };
+						if (p >= 0 && p < consts::trickShotPowerLevels && a >= 0 && a < aimCount)
+							neighbours += successes[p][a];
+					}
+				}
+
+				if (neighbours > result.bestNeighbours)
+				{
+					result.bestNeighbours = neighbours;
+					result.solution.isFound = true;
+					result.solution.shot.angle = baseAngle + (aimIndex - consts::trickShotAimSteps) * consts::trickShotAimStep;
+					result.solution.shot.power = static_cast<double>(consts::cueStickMaxPower) * (powerIndex + 1) / consts::trickShotPowerLevels;
+					result.solution.pocketIndex = node.pocketIndex;
+					result.solution.successRate = static_cast<double>(successCount) / gridSize;
+				}
+			}
+		}
+
+		return result;
+	} };
+
+	// split the beam between the available cores
+	const int taskCount{ std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, static_cast<int>(beam.size())) };
+	std::vector<std::future<std::vector<NodeResult>>> tasks;
+
+	for (int task{}; task < taskCount; ++task)
+	{
+		tasks.push_back(std::async(std::launch::async, [&, task]() {
+			std::vector<NodeResult> results;
+			for (int i{ task }; i < static_cast<int>(beam.size()); i += taskCount)
+			{
+				results.push_back(refineNode(beam[i]));
+			}
+			return results;
+		}));
+	}
+
+	// beam is sorted by difficulty, so only replace on a strictly better result
+	NodeResult best{};
+	double bestScore{ -1.0 };
+	for (std::future<std::vector<NodeResult>>& task : tasks)
+	{
+		for (const NodeResult& result : task.get())
+		{
+			const double score{ result.bestNeighbours + result.solution.successRate };
+			if (result.solution.isFound && score > bestScore)
+			{
+				bestScore = score;
+				best = result;
+			}
+		}
+	}
+
+	return best.solution;
+}
+
+TrickShotSolver::Solution TrickShotSolver::solve(const Ball::balls_type& gameBalls, const Players& gamePlayers, const Target& target)
+{
+	if (!target.isValid())
+		return {};
+
+	for (const int ballNumber : target.ballSequence)
+	{
+		if (ballNumber >= static_cast<int>(gameBalls.size()) || !gameBalls[ballNumber].isVisible())
+			return {};
+	}
+
+	const std::uint64_t key{ getCacheKey(gameBalls, target) };
+	{
+		std::lock_guard<std::mutex> lock{ m_cacheMutex };
+		const auto cached{ m_cache.find(key) };
+		if (cached != m_cache.end())
+		{
+			Solution solution{ cached->second };
+			solution.isFromCache = true;
+			return solution;
+		}
+	}
+
+	const std::vector<BeamNode> beam{ searchBeam(gameBalls, target) };
+	const Solution solution{ beam.empty() ? Solution{} : refine(gameBalls, gamePlayers, target, beam) };
+
+	{
+		std::lock_guard<std::mutex> lock{ m_cacheMutex };
+
+		// tables rarely repeat for long, so just start over when full
+		if (static_cast<int>(m_cache.size()) >= consts::trickShotCacheSize)
+			m_cache.clear();
+
+		m_cache[key] = solution;
+	}
+
+	return solution;
+}
+
+void TrickShotSolver::clearCache()
+{
+	std::lock_guard<std::mutex> lock{ m_cacheMutex };
+	m_cache.clear();
+}
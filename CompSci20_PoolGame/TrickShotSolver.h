@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Ball.h"
+#include "Players.h"
+#include "Vector2.h"
+#include "simulation.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// finds a cue direction and power for a combination shot like "3 into 6 into corner pocket"
+// 1. beam search backwards from the pockets using ghost ball geometry
+// 2. re-simulate the surviving aims (in parallel) over a small grid of powers and aim offsets
+// answers are cached per table and target, so asking again in practice mode is instant
+class TrickShotSolver
+{
+public:
+	enum class PocketGroup
+	{
+		any,
+		corner,
+		side,
+		single // only pocketIndex
+	};
+
+	struct Target
+	{
+		std::vector<int> ballSequence; // first ball is the one the cue ball hits
+		PocketGroup pockets{};
+		int pocketIndex{ -1 };
+
+		bool isValid() const;
+	};
+
+	struct Solution
+	{
+		bool isFound{};
+		simulation::ShotParameters shot{};
+		int pocketIndex{ -1 };
+		double successRate{}; // of the refinement grid around the chosen aim
+		bool isFromCache{};
+	};
+
+private:
+	// one partially solved chain, built from the pocket backwards
+	struct BeamNode
+	{
+		Vector2 travelDirection{}; // direction the current chain ball has to travel
+		int pocketIndex{ -1 };
+		double difficulty{};
+	};
+
+	std::unordered_map<std::uint64_t, Solution> m_cache;
+	std::mutex m_cacheMutex;
+
+	static std::uint64_t getCacheKey(const Ball::balls_type& gameBalls, const Target& target);
+
+	std::vector<BeamNode> searchBeam(const Ball::balls_type& gameBalls, const Target& target) const;
+	Solution refine(const Ball::balls_type& gameBalls, const Players& gamePlayers, const Target& target, const std::vector<BeamNode>& beam) const;
+
+public:
+	// accepts things like "3 6 corner", "3 into 6 into side pocket" or "12 p4"
+	static bool parseTarget(std::string_view text, Target& target);
+	static std::string getTargetName(const Target& target);
+
+	Solution solve(const Ball::balls_type& gameBalls, const Players& gamePlayers, const Target& target);
+	void clearCache();
+};
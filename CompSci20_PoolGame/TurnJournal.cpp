@@ -0,0 +1,294 @@
+#include "TurnJournal.h"
+
+#include "Ball.h"
+#include "constants.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif // _WIN32
+
+static std::uint64_t getChecksum(const void* data, const std::size_t size, std::uint64_t hash = 14695981039346656037ull)
+{
+	const unsigned char* bytes{ static_cast<const unsigned char*>(data) };
+	for (std::size_t i{}; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// the checksum is the last member, so it covers everything before it
+template <typename T>
+static std::uint64_t getRecordChecksum(const T& record)
+{
+	return getChecksum(&record, offsetof(T, checksum));
+}
+
+// fopen is deprecated on msvc, and /sdl makes that an error
+static std::FILE* openFile(const std::string& path, const char* mode)
+{
+#ifdef _WIN32
+	std::FILE* file{};
+	return (fopen_s(&file, path.c_str(), mode) == 0) ? file : nullptr;
+#else
+	return std::fopen(path.c_str(), mode);
+#endif // _WIN32
+}
+
+TurnJournal::~TurnJournal()
+{
+	close();
+}
+
+bool TurnJournal::sync(std::FILE* file)
+{
+	if (std::fflush(file) != 0)
+		return false;
+
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif // _WIN32
+}
+
+bool TurnJournal::truncateTurns(std::FILE* file, const int count)
+{
+	if (std::fflush(file) != 0 || std::fseek(file, 0, SEEK_END) != 0)
+		return false;
+
+	const long size{ std::ftell(file) };
+	if (size < 0)
+		return false;
+
+	const long newSize{ std::max(static_cast<long>(sizeof(Header)), size - count * static_cast<long>(sizeof(Turn))) };
+
+#ifdef _WIN32
+	const bool isCut{ _chsize_s(_fileno(file), newSize) == 0 };
+#else
+	const bool isCut{ ftruncate(fileno(file), newSize) == 0 };
+#endif // _WIN32
+
+	// a journal opened with "wb" writes at the position, not the end
+	return isCut && std::fseek(file, newSize, SEEK_SET) == 0 && sync(file);
+}
+
+void TurnJournal::startWriter()
+{
+	m_isStopping = false;
+	m_turnsToRemove = 0;
+	m_writer = std::thread{ &TurnJournal::writeTurns, this };
+}
+
+void TurnJournal::writeTurns()
+{
+	std::vector<Turn> batch;
+
+	std::unique_lock<std::mutex> lock{ m_mutex };
+	while (true)
+	{
+		m_wakeup.wait(lock, [this]() { return m_isStopping || !m_pending.empty() || m_turnsToRemove > 0; });
+
+		// give the rest of a burst a moment to arrive, it all goes out with one sync
+		if (!m_isStopping)
+		{
+			m_wakeup.wait_for(lock, std::chrono::duration<double>{ consts::journalBatchSeconds }, [this]() { return m_isStopping; });
+		}
+
+		batch.swap(m_pending);
+		const int turnsToRemove{ m_turnsToRemove };
+		m_turnsToRemove = 0;
+		const bool isStopping{ m_isStopping };
+
+		// the game keeps appending while this waits on the disk
+		lock.unlock();
+
+		// the removed turns are older than the batch, so they go first
+		if (turnsToRemove > 0 && !truncateTurns(m_file, turnsToRemove))
+			std::cout << "Could not take turns back out of turn journal " << m_path << '\n';
+
+		if (!batch.empty())
+		{
+			const std::size_t written{ std::fwrite(batch.data(), sizeof(Turn), batch.size(), m_file) };
+			if (written != batch.size() || !sync(m_file))
+				std::cout << "Could not write turn journal " << m_path << '\n';
+
+			batch.clear();
+		}
+
+		lock.lock();
+		if (isStopping && m_pending.empty() && m_turnsToRemove == 0)
+			return;
+	}
+}
+
+bool TurnJournal::create(const std::string& path, Header header)
+{
+	close();
+
+	m_file = openFile(path, "wb");
+	if (!m_file)
+		return false;
+
+	header.checksum = getRecordChecksum(header);
+	if (std::fwrite(&header, sizeof(header), 1, m_file) != 1 || !sync(m_file))
+	{
+		std::fclose(m_file);
+		m_file = nullptr;
+		return false;
+	}
+
+	m_path = path;
+	startWriter();
+	return true;
+}
+
+bool TurnJournal::resume(const std::string& path, const Contents& contents)
+{
+	close();
+
+	// a turn that was only partly written when the game went down
+	std::error_code error;
+	std::filesystem::resize_file(path, contents.validSize, error);
+	if (error)
+		return false;
+
+	m_file = openFile(path, "ab");
+	if (!m_file)
+		return false;
+
+	m_path = path;
+	startWriter();
+	return true;
+}
+
+bool TurnJournal::isOpen() const
+{
+	return m_file != nullptr;
+}
+
+void TurnJournal::append(Turn turn)
+{
+	if (!m_file)
+		return;
+
+	turn.checksum = getRecordChecksum(turn);
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_pending.push_back(turn);
+	}
+	m_wakeup.notify_one();
+}
+
+void TurnJournal::removeLastTurn()
+{
+	if (!m_file)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		// one that hasn't gone out yet never has to touch the disk
+		if (!m_pending.empty())
+		{
+			m_pending.pop_back();
+			return;
+		}
+
+		++m_turnsToRemove;
+	}
+	m_wakeup.notify_one();
+}
+
+void TurnJournal::close()
+{
+	if (m_writer.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_isStopping = true;
+		}
+
+		m_wakeup.notify_one();
+		m_writer.join();
+	}
+
+	if (m_file)
+	{
+		std::fclose(m_file);
+		m_file = nullptr;
+	}
+}
+
+void TurnJournal::discard()
+{
+	close();
+
+	if (!m_path.empty())
+	{
+		std::remove(m_path.c_str());
+		m_path.clear();
+	}
+}
+
+bool TurnJournal::load(const std::string& path, Contents& contents)
+{
+	std::FILE* const file{ openFile(path, "rb") };
+	if (!file)
+		return false;
+
+	contents = {};
+
+	const Header expected{};
+	if (std::fread(&contents.header, sizeof(Header), 1, file) != 1
+		|| std::memcmp(contents.header.magic, expected.magic, sizeof(expected.magic)) != 0
+		|| contents.header.version != expected.version
+		|| contents.header.checksum != getRecordChecksum(contents.header)
+		|| contents.header.ballCount > maxBalls)
+	{
+		std::fclose(file);
+		return false;
+	}
+
+	contents.validSize = sizeof(Header);
+
+	// stop at the first turn that didn't make it to the disk whole
+	Turn turn{};
+	while (std::fread(&turn, sizeof(Turn), 1, file) == 1 && turn.checksum == getRecordChecksum(turn))
+	{
+		contents.turns.push_back(turn);
+		contents.validSize += sizeof(Turn);
+	}
+
+	std::fclose(file);
+	return true;
+}
+
+std::uint64_t TurnJournal::getTableChecksum(const Ball::balls_type& gameBalls)
+{
+	std::uint64_t hash{ 14695981039346656037ull };
+	for (const Ball& ball : gameBalls)
+	{
+		const double position[2]{ ball.getX(), ball.getY() };
+		const bool isVisible{ ball.isVisible() };
+		hash = getChecksum(position, sizeof(position), hash);
+		hash = getChecksum(&isVisible, sizeof(isVisible), hash);
+	}
+	return hash;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Ball.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// every finished turn of the match being played, so a match survives the game
+// crashing or the power going out and can be resumed by replaying its shots
+// - the physics is deterministic, so the starting table and each shot's exact
+//   cue ball velocity are enough, the table checksum after each turn confirms it
+// - append only copies the turn into a queue, a writer thread gathers what's
+//   queued for journalBatchSeconds and writes it with a single fsync
+// - removeLastTurn is queued the same way, the file is only ever cut on the writer thread
+// - every record carries its own checksum, a record torn by a crash is dropped
+// file layout:
+//   Header
+//   Turn x however many were written
+class TurnJournal
+{
+public:
+	static constexpr int maxBalls{ 16 };
+
+	struct Header
+	{
+		char magic[8]{ 'P', 'O', 'O', 'L', 'J', 'R', 'N', 'L' };
+		std::uint32_t version{ 1 };
+		std::uint8_t gameMode{};
+		std::uint8_t breaker{}; // index of the player who breaks
+		std::uint16_t ballCount{};
+		char playerNames[2][32]{};
+		char trickShotTarget[32]{}; // as typed in the menu, practice only
+		std::array<double, maxBalls> ballX{}; // the racked table
+		std::array<double, maxBalls> ballY{};
+		std::uint64_t checksum{}; // of everything above
+	};
+
+	struct Turn
+	{
+		std::uint32_t turnNumber{};
+		std::uint8_t player{};
+		std::uint8_t isBallInHand{};
+		std::uint16_t reserved{};
+		double cueX{}; // where the cue ball was hit from
+		double cueY{};
+		double velocityX{}; // exactly what the cue ball was given
+		double velocityY{};
+		std::uint64_t tableChecksum{}; // of the balls once they stopped
+		std::uint64_t checksum{}; // of everything above
+	};
+
+	struct Contents
+	{
+		Header header{};
+		std::vector<Turn> turns;
+		std::uintmax_t validSize{}; // bytes up to the end of the last whole turn
+	};
+
+private:
+	std::string m_path;
+	std::FILE* m_file{};
+
+	std::thread m_writer;
+	std::mutex m_mutex;
+	std::condition_variable m_wakeup;
+	std::vector<Turn> m_pending;
+	int m_turnsToRemove{}; // already written, always older than anything pending
+	bool m_isStopping{};
+
+	void startWriter();
+	void writeTurns();
+
+	static bool sync(std::FILE* file);
+	static bool truncateTurns(std::FILE* file, const int count);
+
+public:
+	TurnJournal() = default;
+	~TurnJournal();
+
+	TurnJournal(const TurnJournal&) = delete;
+	TurnJournal& operator=(const TurnJournal&) = delete;
+
+	// starts a new journal, the header is written and synced before this returns
+	bool create(const std::string& path, Header header);
+	// carries on after the contents load() found, anything torn after them is cut off
+	bool resume(const std::string& path, const Contents& contents);
+	bool isOpen() const;
+
+	void append(Turn turn);
+	// takes back the newest turn, for undo, the writer thread cuts it off the file
+	void removeLastTurn();
+	// writes everything queued and stops the writer
+	void close();
+	// the match is over, there is nothing left to resume
+	void discard();
+
+	// false if there is no journal at path or its header is damaged
+	static bool load(const std::string& path, Contents& contents);
+	// FNV-1a over every ball's exact position and whether it's on the table
+	static std::uint64_t getTableChecksum(const Ball::balls_type& gameBalls);
+};
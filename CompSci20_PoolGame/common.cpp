@@ -10,10 +10,17 @@
 
 #include <Windows.h>
 
+#include <bitset>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
+#include <string>
 #include <string_view>
 #include <cstdlib>
 #include <limits>
+#include <random>
+#include <utility>
 
 int getRandomInteger(const int min, const int max)
 {
@@ -63,6 +70,32 @@ void intArrayFisherYatesShuffle(std::vector<int>& intArray)
 	}
 }
 
+void intArrayFisherYatesShuffle(std::vector<int>& intArray, std::mt19937& randomEngine)
+{
+	for (int i{ static_cast<int>(intArray.size()) - 1 }; i > 0; --i)
+	{
+		// modulo like getRandomInteger rather than a distribution, so a seed racks the same with any standard library
+		const int randIndex{ static_cast<int>(randomEngine() % static_cast<std::uint32_t>(i + 1)) };
+		std::swap(intArray[i], intArray[randIndex]);
+	}
+}
+
+void lowerCurrentThreadPriority()
+{
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+}
+
+bool replaceFile(const std::string& temporaryPath, const std::string& path)
+{
+#ifdef _WIN32
+	return MoveFileExW(std::filesystem::path{ temporaryPath }.c_str(), std::filesystem::path{ path }.c_str(),
+		MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	// rename replaces the target on posix
+	return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+#endif
+}
+
 std::string_view getBallTypeName(Ball::BallSuitType type)
 {
 	switch (type)
@@ -81,3 +114,19 @@ std::string_view getBallTypeName(Ball::BallSuitType type)
 		return "???";
 	}
 }
+
+int ballMask::getCount(const ballMask_type mask)
+{
+	return static_cast<int>(std::bitset<16>{ mask }.count());
+}
+
+ballMask_type ballMask::getOnTable(const Ball::balls_type& gameBalls)
+{
+	ballMask_type mask{};
+	for (const Ball& ball : gameBalls)
+	{
+		if (ball.isVisible())
+			mask |= getBall(ball.getBallNumber());
+	}
+	return mask;
+}
@@ -4,6 +4,9 @@
 
 #include <string_view>
 #include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
 #include <vector>
 
 // calculates the length of hypotenuse using pythagorean formula
@@ -19,8 +22,59 @@ void pauseProgram(const std::string_view message);
 void clearConsole(const char fillCharacter = ' ');
 void resetCin();
 void intArrayFisherYatesShuffle(std::vector<int>& intArray);
+// same shuffle from an engine, for racks that have to follow a seed
+void intArrayFisherYatesShuffle(std::vector<int>& intArray, std::mt19937& randomEngine);
+// used by background workers so they never compete with the game loop
+void lowerCurrentThreadPriority();
+// moves a finished temporary file over path in one step, a reader sees the old file or the new one, never neither
+bool replaceFile(const std::string& temporaryPath, const std::string& path);
 std::string_view getBallTypeName(Ball::BallSuitType type);
 
+// a set of balls as bits, bit n = ball number n (which is also its index in the ball vector)
+using ballMask_type = std::uint16_t;
+
+namespace ballMask
+{
+	inline constexpr ballMask_type cue{ 1u << 0 };
+	inline constexpr ballMask_type eight{ 1u << 8 };
+	inline constexpr ballMask_type solids{ 0b0000'0000'1111'1110 };
+	inline constexpr ballMask_type stripes{ 0b1111'1110'0000'0000 };
+
+	constexpr ballMask_type getBall(const int ballNumber)
+	{
+		return static_cast<ballMask_type>(1u << ballNumber);
+	}
+
+	// unknown is no balls at all
+	constexpr ballMask_type getSuit(const Ball::BallSuitType type)
+	{
+		switch (type)
+		{
+		case Ball::BallSuitType::cue:
+			return cue;
+		case Ball::BallSuitType::eight:
+			return eight;
+		case Ball::BallSuitType::solid:
+			return solids;
+		case Ball::BallSuitType::striped:
+			return stripes;
+		default:
+			return 0;
+		}
+	}
+
+	// the balls still on the table once a turn has pocketed some,
+	// the cue ball always comes back, respotted or in hand
+	constexpr ballMask_type getAfterTurn(const ballMask_type onTable, const ballMask_type pocketed)
+	{
+		return static_cast<ballMask_type>((onTable & ~pocketed) | cue);
+	}
+
+	int getCount(const ballMask_type mask);
+	// scans the balls, for setting up a table, after that keep the mask up to date with getAfterTurn
+	ballMask_type getOnTable(const Ball::balls_type& gameBalls);
+}
+
 // way to index audio samples from the
 // resource vector
 enum class AudioSamples
@@ -30,10 +84,17 @@ enum class AudioSamples
 	total_samples
 };
 
+enum class GameMode
+{
+	eightBall,
+	practice
+};
+
 struct TurnInformation
 {
+	ballMask_type pocketedBalls{};
 	Ball::BallSuitType firstHitBallType{};
-	Ball::ballsPointer_type pocketedBalls;
+	std::int8_t firstHitBallNumber{ -1 };
 	bool startWithBallInHand{};
 	// nice and descriptive
 	bool targetBallsSelectedThisTurn{};
@@ -12,9 +12,15 @@ namespace consts
 	using std::array;
 	using std::string_view;
 
-	// window size settings
-	inline constexpr int screenWidth{ 1000 };
-	inline constexpr int screenHeight{ 500 };
+	// world size, everything in the game (physics, table, balls, drawing) is in world units,
+	// the view scales them to however many pixels the window has (see view)
+	inline constexpr int worldWidth{ 1000 };
+	inline constexpr int worldHeight{ 500 };
+
+	// window settings
+	inline constexpr double windowMonitorShare{ 0.8 }; // the first window fills this much of the monitor
+	inline constexpr double viewScaleStep{ 0.125 }; // sprites are rasterized at multiples of this (see SpriteCache)
+	inline constexpr int spriteCacheLevels{ 2 }; // scales kept rasterized, windowed and fullscreen
 
 	// pool table size settings
 	inline constexpr int playSurfaceX{ 40 };
@@ -23,12 +29,21 @@ namespace consts
 	inline constexpr Rectangle playSurface{
 		consts::playSurfaceX,
 		consts::playSurfaceY,
-		consts::screenWidth - consts::playSurfaceX,
-		consts::screenHeight - consts::playSurfaceY
+		consts::worldWidth - consts::playSurfaceX,
+		consts::worldHeight - consts::playSurfaceY
 	};
 
 	// update deltas
 	inline constexpr double frameTime{ 1.0 / 60.0 };
+	// slower frames are counted as missed (see FrameTimings), a frame is one timer interval,
+	// the tolerance is only for the timer's own jitter, anything more is a missed vsync
+	inline constexpr double frameDeadline{ frameTime + 0.0005 };
+
+	// render quality selection (see RenderQuality)
+	inline constexpr double qualityWarmupSeconds{ 0.5 };
+	inline constexpr double qualityBenchmarkSeconds{ 2.5 };
+	inline constexpr double qualityPercentile{ 0.9 };
+	inline constexpr double qualityFrameSlack{ 1.2 }; // the timer's own jitter shouldn't count as a missed frame
 	inline constexpr double physicsUpdateDelta{ 1.0 / 60.0 };
 
 	// default ball settings
@@ -85,6 +100,7 @@ namespace consts
 
 	// pocket settings
 	inline constexpr double pocketRadius{ 23 };
+	inline constexpr double pocketSensitivity{ 10 }; // higher = less sensitive
 
 	inline constexpr array<array<int, 2>, 6> pocketCoordinates
 	{ {
@@ -96,6 +112,80 @@ namespace consts
 		{955, 465}
 	} };
 
+	// headless simulation settings
+	inline constexpr int maxSimulationTicks{ 60 * 60 }; // give up on a shot after a minute of game time
+
+	// coarse shot evaluation settings (see ShotEvaluator)
+	inline constexpr int coarseTicksPerStep{ 4 };
+	inline constexpr float coarseSubstepScale{ 1.5f }; // substep length in ball radii
+	inline constexpr int defaultRefineCount{ 32 };
+
+	// shot success prediction settings (see ShotPredictor)
+	inline constexpr int predictorMaxSamples{ 300 };
+	inline constexpr int predictorMinSamples{ 30 }; // below this the difficulty table estimate is shown
+	inline constexpr int predictorMaxThreads{ 4 };
+	inline constexpr double predictorAimNoise{ 0.01 }; // radians, standard deviation
+	inline constexpr double predictorPowerNoise{ 0.04 }; // fraction of power, standard deviation
+	inline constexpr double predictorAimTolerance{ 0.002 }; // radians the aim can drift before restarting
+
+	// post shot coach settings (see ShotCoach)
+	inline constexpr int coachAngles{ 180 };
+	inline constexpr int coachPowerLevels{ 4 };
+	inline constexpr double coachCpuShare{ 0.5 }; // of one core, the worker sleeps off the rest
+	inline constexpr double coachMinScoreDifference{ 0.5 }; // smaller misses aren't worth pointing out
+
+	// practice mode rewind settings (see RewindBuffer), about 300 KB
+	inline constexpr int rewindTurns{ 64 };
+	inline constexpr int rewindKeyframes{ 1024 };
+	inline constexpr int rewindBallStates{ 6144 };
+	inline constexpr int rewindKeyframeTicks{ 15 };
+	inline constexpr int rewindScrubTicks{ 2 }; // per frame an arrow key is held
+
+	// trick shot solver settings (see TrickShotSolver)
+	inline constexpr int trickShotBeamWidth{ 48 };
+	inline constexpr double trickShotMaxCutAngle{ 1.3 }; // radians, about 75 degrees
+	inline constexpr double trickShotPocketSpread{ 6.0 }; // pixels to either side of the pocket centre
+	inline constexpr double trickShotAimSpread{ 0.01 }; // radians to either side of the ghost ball
+	inline constexpr int trickShotPowerLevels{ 6 };
+	inline constexpr int trickShotAimSteps{ 2 }; // refinement steps to either side of the beam aim
+	inline constexpr double trickShotAimStep{ 0.004 }; // radians
+	inline constexpr int trickShotCacheSize{ 256 };
+
+	// table distance field (see TableDistanceField), ball in hand uses the same cells
+	inline constexpr int distanceFieldCellSize{ 2 }; // pixels
+	inline constexpr double distanceFieldMinStep{ 0.5 }; // pixels, closer than this counts as touching
+	inline constexpr int distanceFieldMaxSteps{ 64 }; // steps along a path before checking it exactly
+	inline constexpr int placementShadingAlpha{ 90 }; // how dark the illegal areas are drawn
+	inline constexpr int aimGuideLength{ 600 }; // pixels
+
+	// shot planner
+	inline constexpr double plannerMaxCutAngle{ 1.3 }; // radians, thinner cuts are not considered pottable
+
+	// bots and tournaments
+	inline constexpr double botPlacementDistance{ 120.0 }; // ball in hand, pixels behind the ghost ball
+	inline constexpr int botPlacementAttempts{ 50 };
+	inline constexpr int tournamentMaxTurns{ 200 }; // the match is a draw after this many turns
+	inline constexpr double eloStartRating{ 1500.0 };
+	inline constexpr double eloKFactor{ 16.0 };
+
+	// similar position search (see PositionIndex)
+	inline constexpr int positionIndexMaxChecks{ 8192 }; // positions compared before an approximate search stops
+
+	// shot difficulty table settings (see ShotDifficultyTable)
+	// axes: cut angle, object ball to pocket distance, cue ball to ghost ball distance
+	inline constexpr array<int, 3> difficultyTableBins{ 15, 12, 12 };
+	inline constexpr array<float, 3> difficultyTableMinimums{ 0.0f, 30.0f, 20.0f };
+	inline constexpr array<float, 3> difficultyTableMaximums{ 1.4f, 900.0f, 900.0f };
+	inline constexpr int difficultyTableSamples{ 200 }; // simulated shots per table entry
+	inline constexpr string_view difficultyTablePath{ "resources/shot_difficulty.bin" };
+	inline constexpr string_view frameReportPath{ "frame_times.txt" }; // appended to after every match
+	inline constexpr string_view turnJournalPath{ "match_journal.bin" }; // the unfinished match, removed when it ends (see TurnJournal)
+	inline constexpr double journalBatchSeconds{ 0.25 }; // turns queued within this are written with one sync
+	inline constexpr int traceBufferEvents{ 1 << 16 }; // per thread, older events are overwritten (see trace)
+	inline constexpr double metricsIntervalSeconds{ 15.0 }; // how often the metrics file is rewritten (see metrics)
+	inline constexpr int physicsLogRecords{ 1 << 16 }; // per thread, 2 MB each (see physicsLog)
+	inline constexpr int physicsLogMaxThreads{ 256 }; // buffers past this are left out of dumps, finished threads' buffers are reused
+
 	// paths to game resources
 	inline constexpr array<string_view, 2> audioFilePaths
 	{
@@ -0,0 +1,833 @@
+#include "headless.h"
+
+#include "Ball.h"
+#include "Bot.h"
+#include "Players.h"
+#include "PositionIndex.h"
+#include "common.h"
+#include "constants.h"
+#include "HardwareCounters.h"
+#include "metrics.h"
+#include "physics.h"
+#include "physicsLog.h"
+#include "referee.h"
+#include "RenderQuality.h"
+#include "ReplayAnalyzer.h"
+#include "ShotDifficultyTable.h"
+#include "ShotEvaluator.h"
+#include "ShotDataset.h"
+#include "ShotPlannerCache.h"
+#include "simulation.h"
+#include "Tournament.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace headless
+{
+	static int getIntArgument(int argc, char* argv[], const int index, const int defaultValue)
+	{
+		if (index >= argc)
+			return defaultValue;
+
+		const int value{ std::atoi(argv[index]) };
+		return (value > 0) ? value : defaultValue;
+	}
+
+	// racks the balls and plays a random break so the tools
+	// get a realistic mid-game table instead of a tight rack
+	static void setupBrokenTable(Ball::balls_type& gameBalls, Players& gamePlayers)
+	{
+		simulation::createBalls(gameBalls, 16, consts::defaultBallRadius, consts::defaultBallMass);
+		simulation::setupRack(gameBalls);
+
+		// aim somewhere into the rack
+		const double deltaX{ consts::rackBallPositions[8][0] - gameBalls[0].getX() };
+		const double deltaY{ consts::rackBallPositions[8][1] - gameBalls[0].getY() + getRandomInteger(-40, 40) };
+		const simulation::ShotParameters breakShot{ std::atan2(deltaY, deltaX), static_cast<double>(consts::cueStickMaxPower) };
+
+		TurnInformation breakTurn{};
+		simulation::applyShot(gameBalls, breakShot);
+		simulation::runUntilRest(gameBalls, gamePlayers, breakTurn);
+
+		// the tools always want a cue ball to shoot with
+		if (!gameBalls[0].isVisible())
+		{
+			gameBalls[0].setVisible(true);
+			gameBalls[0].setPosition(consts::rackBallPositions[0][0], consts::rackBallPositions[0][1]);
+		}
+	}
+
+	static int runShotEvaluation(int argc, char* argv[])
+	{
+		const int angleCount{ getIntArgument(argc, argv, 2, 720) };
+		const int powerLevels{ getIntArgument(argc, argv, 3, 4) };
+		const int refineCount{ getIntArgument(argc, argv, 4, consts::defaultRefineCount) };
+
+		Ball::balls_type gameBalls;
+		Players gamePlayers{ 2 };
+		setupBrokenTable(gameBalls, gamePlayers);
+
+		const ShotEvaluator evaluator{ refineCount };
+		const ShotEvaluator::Report report{
+			evaluator.evaluate(gameBalls, gamePlayers, simulation::generateCandidateShots(angleCount, powerLevels))
+		};
+
+		ShotEvaluator::printReport(report);
+		return EXIT_SUCCESS;
+	}
+
+	static int runDifficultyTableGeneration(int argc, char* argv[])
+	{
+		const int samplesPerEntry{ getIntArgument(argc, argv, 2, consts::difficultyTableSamples) };
+		const std::string path{ (argc > 3) ? argv[3] : std::string{ consts::difficultyTablePath } };
+
+		std::cout << "[Generating Difficulty Table] " << samplesPerEntry << " shots per entry\n";
+
+		if (!ShotDifficultyTable::generate(path, samplesPerEntry))
+		{
+			std::cout << "Could not write " << path << '\n';
+			return EXIT_FAILURE;
+		}
+
+		// read it back through the same path the game uses
+		ShotDifficultyTable table;
+		if (!table.load(path))
+		{
+			std::cout << "Could not load " << path << '\n';
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "Wrote " << path << '\n';
+		std::cout << "Straight, 200px from pocket, 200px from cue: " << table.estimate(0.0, 200.0, 200.0) << '\n';
+		std::cout << "45 degree cut, 200px from pocket, 200px from cue: " << table.estimate(0.785, 200.0, 200.0) << "\n\n";
+		return EXIT_SUCCESS;
+	}
+
+	// picks the straightest pottable shot the cache knows about,
+	// or a random hit if there is none, so the table changes like a real game
+	static simulation::ShotParameters choosePlannedShot(const Ball::balls_type& gameBalls, const ShotPlannerCache& cache)
+	{
+		const ShotPlannerCache::Entry* bestEntry{};
+		for (int ballIndex{ 1 }; ballIndex < static_cast<int>(gameBalls.size()); ++ballIndex)
+		{
+			for (int pocketIndex{}; pocketIndex < ShotPlannerCache::pocketCount; ++pocketIndex)
+			{
+				const ShotPlannerCache::Entry& entry{ cache.getEntry(ballIndex, pocketIndex) };
+				if (entry.isPottable() && (!bestEntry || entry.cutAngle < bestEntry->cutAngle))
+					bestEntry = &entry;
+			}
+		}
+
+		const double power{ consts::cueStickMaxPower * getRandomInteger(30, 80) / 100.0 };
+		if (!bestEntry)
+			return { getRandomInteger(0, 628) / 100.0, power };
+
+		const Vector2 toGhost{ bestEntry->ghostBall.copyAndSubtract(gameBalls[0].getPositionVector()) };
+		return { std::atan2(toGhost.getY(), toGhost.getX()), power };
+	}
+
+	static int runPlannerCacheCheck(int argc, char* argv[])
+	{
+		using clock = std::chrono::steady_clock;
+
+		const int shotCount{ getIntArgument(argc, argv, 2, 200) };
+
+		Ball::balls_type gameBalls;
+		Players gamePlayers{ 2 };
+		setupBrokenTable(gameBalls, gamePlayers);
+
+		ShotPlannerCache cache;
+		cache.rebuild(gameBalls);
+
+		const int fullLegCount{ 2 * (static_cast<int>(gameBalls.size()) - 1) * ShotPlannerCache::pocketCount };
+		long long recomputedLegs{};
+		int movedBalls{};
+		int mismatches{};
+		double incrementalSeconds{};
+		double rebuildSeconds{};
+
+		for (int shot{}; shot < shotCount; ++shot)
+		{
+			const Ball::balls_type startBalls{ gameBalls };
+
+			TurnInformation turn{};
+			simulation::applyShot(gameBalls, choosePlannedShot(gameBalls, cache));
+			simulation::runUntilRest(gameBalls, gamePlayers, turn);
+
+			for (int i{}; i < static_cast<int>(gameBalls.size()); ++i)
+			{
+				movedBalls += gameBalls[i].isVisible() != startBalls[i].isVisible()
+					|| gameBalls[i].getX() != startBalls[i].getX() || gameBalls[i].getY() != startBalls[i].getY();
+			}
+
+			// keep the table playable
+			if (!gameBalls[0].isVisible())
+			{
+				gameBalls[0].setVisible(true);
+				gameBalls[0].setPosition(consts::rackBallPositions[0][0], consts::rackBallPositions[0][1]);
+			}
+			if (!gameBalls[8].isVisible())
+				setupBrokenTable(gameBalls, gamePlayers);
+
+			// the reference also warms the caches, so both timings below start warm
+			ShotPlannerCache reference;
+			reference.rebuild(gameBalls);
+
+			const clock::time_point incrementalStart{ clock::now() };
+			recomputedLegs += cache.update(gameBalls);
+			const clock::time_point rebuildStart{ clock::now() };
+			ShotPlannerCache rebuilt;
+			rebuilt.rebuild(gameBalls);
+			const clock::time_point rebuildEnd{ clock::now() };
+
+			incrementalSeconds += std::chrono::duration<double>(rebuildStart - incrementalStart).count();
+			rebuildSeconds += std::chrono::duration<double>(rebuildEnd - rebuildStart).count();
+
+			// the incremental table has to match a full rebuild exactly
+			for (int ballIndex{ 1 }; ballIndex < static_cast<int>(gameBalls.size()); ++ballIndex)
+			{
+				for (int pocketIndex{}; pocketIndex < ShotPlannerCache::pocketCount; ++pocketIndex)
+				{
+					const ShotPlannerCache::Entry& a{ cache.getEntry(ballIndex, pocketIndex) };
+					const ShotPlannerCache::Entry& b{ reference.getEntry(ballIndex, pocketIndex) };
+					if (a.isAvailable != b.isAvailable
+						|| (a.isAvailable && (a.isPocketPathClear != b.isPocketPathClear || a.isCuePathClear != b.isCuePathClear || a.cutAngle != b.cutAngle)))
+					{
+						++mismatches;
+					}
+				}
+			}
+		}
+
+		std::cout << "[Planner Cache]\n";
+		std::cout << "Shots: " << shotCount << '\n';
+		std::cout << "Balls Moved Per Shot: " << static_cast<double>(movedBalls) / shotCount << '\n';
+		const ShotPlannerCache::Statistics& statistics{ cache.getStatistics() };
+		std::cout << "Legs Recomputed Per Shot: " << static_cast<double>(recomputedLegs) / shotCount << " of " << fullLegCount << '\n';
+		std::cout << "  Pocket Legs: " << static_cast<double>(statistics.pocketLegsRecomputed - fullLegCount / 2) / statistics.updates << '\n';
+		std::cout << "  Cue Legs: " << static_cast<double>(statistics.cueLegsRecomputed - fullLegCount / 2) / statistics.updates << '\n';
+		std::cout << "Incremental Update: " << incrementalSeconds * 1e6 / shotCount << " us\n";
+		std::cout << "Full Rebuild: " << rebuildSeconds * 1e6 / shotCount << " us\n";
+		std::cout << "Mismatches: " << mismatches << "\n\n";
+		return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	struct BenchmarkScenario
+	{
+		const char* name{};
+		Ball::balls_type startBalls;
+		std::vector<simulation::ShotParameters> shots;
+	};
+
+	// the same shots from the same tables every run, so runs before and after
+	// a change to the physics can be compared
+	static std::vector<BenchmarkScenario> getBenchmarkScenarios()
+	{
+		Ball::balls_type rackedBalls;
+		simulation::createBalls(rackedBalls, 16, consts::defaultBallRadius, consts::defaultBallMass);
+
+		// setupRack shuffles with rand
+		std::srand(1);
+		simulation::setupRack(rackedBalls);
+
+		const double apexAngle{ std::atan2(consts::rackBallPositions[8][1] - rackedBalls[0].getY(), consts::rackBallPositions[8][0] - rackedBalls[0].getX()) };
+		const simulation::ShotParameters breakShot{ apexAngle, static_cast<double>(consts::cueStickMaxPower) };
+
+		Ball::balls_type brokenBalls;
+		simulation::simulateShot(rackedBalls, Players{ 2 }, breakShot, brokenBalls);
+		if (!brokenBalls[0].isVisible())
+		{
+			brokenBalls[0].setVisible(true);
+			brokenBalls[0].setPosition(consts::rackBallPositions[0][0], consts::rackBallPositions[0][1]);
+		}
+
+		// 36 directions around the cue ball at a given fraction of full power
+		static constexpr double pi{ 3.14159265358979323846 };
+		const auto getSpread{ [](const double powerFraction) {
+			std::vector<simulation::ShotParameters> shots;
+			for (int angleIndex{}; angleIndex < 36; ++angleIndex)
+				shots.push_back({ angleIndex * 2.0 * pi / 36.0, consts::cueStickMaxPower * powerFraction });
+			return shots;
+		} };
+
+		return {
+			{ "break", rackedBalls, { breakShot } }, // dense, every ball awake
+			{ "open table", brokenBalls, getSpread(0.6) },
+			{ "soft shots", brokenBalls, getSpread(0.15) } // mostly asleep, short shots
+		};
+	}
+
+	static int runPhysicsBenchmark(int argc, char* argv[])
+	{
+		using clock = std::chrono::steady_clock;
+		using Event = HardwareCounters::Event;
+
+		const int repetitions{ getIntArgument(argc, argv, 2, 20) };
+
+		HardwareCounters hardwareCounters;
+		if (!hardwareCounters.open())
+			std::cout << "Hardware counters unavailable, " << hardwareCounters.getError() << "\n\n";
+
+		std::cout << "[Physics Benchmark] " << repetitions << " repetitions per scenario\n";
+
+		for (const BenchmarkScenario& scenario : getBenchmarkScenarios())
+		{
+			const Players startPlayers{ 2 };
+			const physics::StepCounters startCounters{ physics::getStepCounters() };
+
+			// the shots themselves are all that's measured, not copying the tables
+			double seconds{};
+			HardwareCounters::Sample total{};
+			for (int repetition{}; repetition < repetitions; ++repetition)
+			{
+				for (const simulation::ShotParameters& shot : scenario.shots)
+				{
+					Ball::balls_type gameBalls{ scenario.startBalls };
+					Players gamePlayers{ startPlayers };
+					TurnInformation turn{};
+					simulation::applyShot(gameBalls, shot);
+
+					const clock::time_point start{ clock::now() };
+					hardwareCounters.start();
+					simulation::runUntilRest(gameBalls, gamePlayers, turn);
+					const HardwareCounters::Sample sample{ hardwareCounters.stop() };
+					seconds += std::chrono::duration<double>(clock::now() - start).count();
+
+					for (int eventIndex{}; eventIndex < HardwareCounters::eventCount; ++eventIndex)
+					{
+						total.values[eventIndex] += sample.values[eventIndex];
+						total.isCounted[eventIndex] = total.isCounted[eventIndex] || sample.isCounted[eventIndex];
+					}
+				}
+			}
+
+			const physics::StepCounters counters{ physics::getStepCounters().getDifference(startCounters) };
+			const double pairTests{ static_cast<double>(std::max<std::uint64_t>(counters.pairTests, 1)) };
+
+			std::cout << std::fixed << '\n' << scenario.name << ": " << std::setprecision(1) << seconds * 1000.0 << " ms, "
+				<< std::setprecision(0) << seconds * 1e9 / std::max<std::uint64_t>(counters.ticks, 1) << " ns per tick\n";
+			physics::printStepCounters(counters);
+
+			if (!hardwareCounters.isOpen())
+				continue;
+
+			std::cout << std::fixed;
+			for (int eventIndex{}; eventIndex < HardwareCounters::eventCount; ++eventIndex)
+			{
+				const Event event{ static_cast<Event>(eventIndex) };
+				std::cout << std::left << std::setw(14) << HardwareCounters::getEventName(event) << std::right;
+				if (!total.has(event))
+				{
+					std::cout << "n/a\n";
+					continue;
+				}
+
+				std::cout << std::setw(14) << total.get(event)
+					<< std::setprecision(2) << std::setw(10) << total.get(event) / pairTests << " per pair test\n";
+			}
+			if (total.has(Event::cycles) && total.has(Event::instructions))
+				std::cout << "IPC           " << std::setprecision(2) << total.getInstructionsPerCycle() << '\n';
+		}
+
+		std::cout << std::defaultfloat << std::setprecision(6) << '\n';
+		return EXIT_SUCCESS;
+	}
+
+	static int runEnergyCheck(int argc, char* argv[])
+	{
+		const int shotCount{ getIntArgument(argc, argv, 2, 200) };
+
+		Ball::balls_type gameBalls;
+		Players gamePlayers{ 2 };
+		setupBrokenTable(gameBalls, gamePlayers);
+
+		// the break isn't part of it, every shot starts from the same broken table
+		physics::setEnergyMonitoring(true);
+		physics::resetEnergyLedger();
+
+		for (int shot{}; shot < shotCount; ++shot)
+		{
+			const simulation::ShotParameters parameters{
+				getRandomInteger(0, 628) / 100.0, consts::cueStickMaxPower * getRandomInteger(10, 100) / 100.0
+			};
+			simulation::simulateShot(gameBalls, gamePlayers, parameters);
+		}
+
+		physics::setEnergyMonitoring(false);
+
+		std::cout << "[Energy Check] " << shotCount << " shots\n";
+		const physics::EnergyLedger& ledger{ physics::getEnergyLedger() };
+		physics::printEnergyLedger(ledger);
+		std::cout << '\n';
+
+		return (ledger.energyGainTicks > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	static int runPhysicsLogDecode(int argc, char* argv[])
+	{
+		if (argc < 3)
+		{
+			std::cout << "--decode-physics-log needs the log's path\n";
+			return EXIT_FAILURE;
+		}
+
+		if (!physicsLog::decode(argv[2], std::cout))
+		{
+			std::cout << "Could not read physics log " << argv[2] << '\n';
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	static int runTournament(int argc, char* argv[])
+	{
+		Tournament::Settings settings{};
+		if (argc < 3 || !Tournament::parseFormat(argv[2], settings.format))
+		{
+			std::cout << "Tournament format must be round-robin or swiss\n";
+			return EXIT_FAILURE;
+		}
+
+		settings.rounds = getIntArgument(argc, argv, 3, 1);
+		settings.gamesPerPairing = getIntArgument(argc, argv, 4, 2);
+		settings.checkpointPath = (argc > 5) ? argv[5] : "tournament.txt";
+		settings.threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+		if (argc > 7)
+			settings.replayDirectory = argv[7];
+		if (argc > 8)
+			settings.countersPath = argv[8];
+
+		// comma separated preset names, all of them by default
+		std::vector<Bot::Config> configs;
+		if (argc > 6)
+		{
+			std::istringstream names{ argv[6] };
+			std::string name;
+			while (std::getline(names, name, ','))
+			{
+				Bot::Config config{};
+				if (!Bot::findPreset(name, config))
+				{
+					std::cout << "Unknown bot " << name << '\n';
+					return EXIT_FAILURE;
+				}
+				configs.push_back(config);
+			}
+		}
+		else
+		{
+			configs = Bot::getPresets();
+		}
+
+		if (configs.size() < 2)
+		{
+			std::cout << "A tournament needs at least two bots\n";
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "[Tournament] " << Tournament::getFormatName(settings.format) << ", " << settings.rounds << " rounds, "
+			<< settings.gamesPerPairing << " games per pairing, " << settings.threadCount << " threads\n";
+		if (!settings.replayDirectory.empty())
+			std::cout << "Replays: " << settings.replayDirectory << '\n';
+		if (!settings.countersPath.empty())
+			std::cout << "Physics Counters: " << settings.countersPath << '\n';
+		std::cout << '\n';
+
+		Tournament tournament{ settings, configs };
+		tournament.run();
+		tournament.printStandings();
+		return EXIT_SUCCESS;
+	}
+
+	static int runDatasetInfo(int argc, char* argv[])
+	{
+		using clock = std::chrono::steady_clock;
+
+		ShotDatasetReader reader;
+		if (argc < 3 || !reader.load(argv[2]))
+		{
+			std::cout << "Could not load dataset " << ((argc < 3) ? "" : argv[2]) << '\n';
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "[Shot Dataset] " << argv[2] << '\n';
+		std::cout << "Rows: " << reader.getRowCount() << " in " << reader.getBlockCount() << " blocks\n";
+		if (!reader.getPlayerName(0).empty())
+			std::cout << "Players: " << reader.getPlayerName(0) << ", " << reader.getPlayerName(1) << '\n';
+
+		std::cout << "\n[Columns]\n";
+		for (int i{}; i < reader.getColumnCount(); ++i)
+		{
+			const shotDataset::ColumnHeader& column{ reader.getColumn(i) };
+			std::cout << std::string{ column.name } << " x" << column.elementCount << " (" << static_cast<int>(column.elementSize) << " bytes)\n";
+		}
+
+		const int pocketedColumn{ reader.findColumn("pocketed") };
+		const int foulColumn{ reader.findColumn("fouls") };
+		if (pocketedColumn < 0 || foulColumn < 0)
+			return EXIT_SUCCESS;
+
+		// straight off the mapping, only the two columns it needs are ever touched
+		const clock::time_point scanStart{ clock::now() };
+		long long pottingShots{};
+		std::array<long long, referee::foulTypeCount> foulCounts{};
+
+		for (int block{}; block < reader.getBlockCount(); ++block)
+		{
+			const std::uint16_t* pocketed{ reader.getColumnValues<std::uint16_t>(block, pocketedColumn) };
+			const std::uint8_t* fouls{ reader.getColumnValues<std::uint8_t>(block, foulColumn) };
+
+			for (int row{}; row < reader.getBlockRowCount(block); ++row)
+			{
+				pottingShots += (pocketed[row] & ~1u) != 0;
+				for (int foul{}; foul < referee::foulTypeCount; ++foul)
+					foulCounts[foul] += (fouls[row] >> foul) & 1u;
+			}
+		}
+
+		const double scanSeconds{ std::chrono::duration<double>(clock::now() - scanStart).count() };
+		const double rowCount{ static_cast<double>(std::max(1LL, reader.getRowCount())) };
+
+		std::cout << "\n[Summary]\n";
+		std::cout << "Shots Potting A Ball: " << pottingShots / rowCount * 100.0 << "%\n";
+		for (int foul{}; foul < referee::foulTypeCount; ++foul)
+			std::cout << referee::getFoulName(1u << foul) << ": " << foulCounts[foul] / rowCount * 100.0 << "%\n";
+		std::cout << "Scan: " << scanSeconds * 1000.0 << " ms (" << reader.getRowCount() / std::max(scanSeconds, 1e-9) / 1e6 << "M rows/s)\n\n";
+		return EXIT_SUCCESS;
+	}
+
+	static int runReplayAnalysis(int argc, char* argv[])
+	{
+		using clock = std::chrono::steady_clock;
+
+		std::vector<std::string> paths;
+		if (argc < 3 || !ReplayAnalyzer::findReplays(argv[2], paths))
+		{
+			std::cout << "Could not read replay directory " << ((argc < 3) ? "" : argv[2]) << '\n';
+			return EXIT_FAILURE;
+		}
+
+		const ReplayAnalyzer analyzer{ static_cast<int>(std::thread::hardware_concurrency()) };
+
+		const clock::time_point start{ clock::now() };
+		const ReplayAnalyzer::Statistics statistics{ analyzer.analyze(paths) };
+		const double seconds{ std::chrono::duration<double>(clock::now() - start).count() };
+
+		ReplayAnalyzer::printStatistics(statistics);
+		std::cout << std::fixed << std::setprecision(1) << "Analysis: " << seconds * 1000.0 << " ms (" << statistics.files / std::max(seconds, 1e-9) << " files/s, "
+			<< std::max(1u, std::thread::hardware_concurrency()) << " threads)\n\n" << std::defaultfloat;
+
+		if (argc > 3 && !ReplayAnalyzer::writeHeatmap(statistics, argv[3]))
+		{
+			std::cout << "Could not write heatmap " << argv[3] << '\n';
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	static int runPositionSearch(int argc, char* argv[])
+	{
+		using clock = std::chrono::steady_clock;
+
+		if (argc < 3)
+		{
+			std::cout << "Position search needs a shot dataset or a directory of them\n";
+			return EXIT_FAILURE;
+		}
+
+		// a single dataset or a directory of replays
+		std::vector<std::string> paths;
+		if (!ReplayAnalyzer::findReplays(argv[2], paths))
+			paths.push_back(argv[2]);
+
+		// getIntArgument would quietly swap a bad count for the default
+		if ((argc > 3 && std::atoi(argv[3]) < 1) || (argc > 4 && std::atoi(argv[4]) < 1))
+		{
+			std::cout << "Position search needs at least one neighbour and one query\n";
+			return EXIT_FAILURE;
+		}
+
+		const int neighbourCount{ getIntArgument(argc, argv, 3, 5) };
+		const int queryCount{ getIntArgument(argc, argv, 4, 1000) };
+
+		const clock::time_point loadStart{ clock::now() };
+		PositionIndex index;
+		int loadedFiles{};
+		for (const std::string& path : paths)
+			loadedFiles += index.addDataset(path);
+
+		const clock::time_point buildStart{ clock::now() };
+		index.build();
+		const clock::time_point buildEnd{ clock::now() };
+
+		if (!index.isBuilt())
+		{
+			std::cout << "No played shots in " << argv[2] << '\n';
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "[Position Index]\n";
+		std::cout << "Positions: " << index.getEntryCount() << " from " << loadedFiles << " files\n";
+		std::cout << "Load: " << std::chrono::duration<double>(buildStart - loadStart).count() * 1000.0 << " ms\n";
+		std::cout << "Build: " << std::chrono::duration<double>(buildEnd - buildStart).count() * 1000.0 << " ms\n\n";
+
+		// archived positions jittered a little, so the query itself isn't always the answer
+		std::mt19937 randomEngine{ std::random_device{}() };
+		std::uniform_int_distribution<std::size_t> entryDistribution{ 0, index.getEntryCount() - 1 };
+		std::normal_distribution<float> jitter{ 0.0f, 0.01f };
+
+		std::vector<PositionIndex::features_type> queries(queryCount);
+		for (PositionIndex::features_type& query : queries)
+		{
+			query = index.getEntry(entryDistribution(randomEngine)).features;
+			for (float& feature : query)
+				feature += jitter(randomEngine);
+		}
+
+		double exactSeconds{};
+		double approximateSeconds{};
+		long long matchingNeighbours{};
+		long long totalNeighbours{};
+		std::vector<PositionIndex::Neighbour> firstResult;
+
+		for (const PositionIndex::features_type& query : queries)
+		{
+			const clock::time_point exactStart{ clock::now() };
+			const std::vector<PositionIndex::Neighbour> exact{ index.findNearest(query, neighbourCount) };
+			const clock::time_point approximateStart{ clock::now() };
+			const std::vector<PositionIndex::Neighbour> approximate{ index.findNearest(query, neighbourCount, consts::positionIndexMaxChecks) };
+			const clock::time_point approximateEnd{ clock::now() };
+
+			exactSeconds += std::chrono::duration<double>(approximateStart - exactStart).count();
+			approximateSeconds += std::chrono::duration<double>(approximateEnd - approximateStart).count();
+
+			// nothing to measure recall against
+			if (exact.empty())
+				continue;
+
+			// recall, anything as close as the exact kth neighbour counts as found
+			for (const PositionIndex::Neighbour& neighbour : approximate)
+				matchingNeighbours += neighbour.distanceSquared <= exact.back().distanceSquared;
+			totalNeighbours += static_cast<long long>(exact.size());
+
+			if (firstResult.empty())
+				firstResult = exact;
+		}
+
+		std::cout << "[Queries] " << queryCount << " x " << neighbourCount << " nearest\n";
+		std::cout << "Exact: " << exactSeconds * 1000.0 / queryCount << " ms\n";
+		std::cout << "Approximate: " << approximateSeconds * 1000.0 / queryCount << " ms ("
+			<< static_cast<double>(matchingNeighbours) / std::max(1LL, totalNeighbours) * 100.0 << "% recall)\n\n";
+
+		// what was played from the positions closest to the first query
+		std::cout << "[Closest Positions]\n";
+		for (const PositionIndex::Neighbour& neighbour : firstResult)
+		{
+			ShotDatasetReader reader;
+			if (!reader.load(index.getFilePath(neighbour.entry->file)))
+				continue;
+
+			// blocks can be short where the file was closed and appended to later
+			const int row{ static_cast<int>(neighbour.entry->row) };
+			int block{};
+			int blockRow{ row };
+			while (blockRow >= reader.getBlockRowCount(block))
+				blockRow -= reader.getBlockRowCount(block++);
+
+			const float angle{ reader.getColumnValues<float>(block, reader.findColumn("angle"))[blockRow] };
+			const float power{ reader.getColumnValues<float>(block, reader.findColumn("power"))[blockRow] };
+			const std::uint16_t pocketed{ reader.getColumnValues<std::uint16_t>(block, reader.findColumn("pocketed"))[blockRow] };
+			const std::uint8_t fouls{ reader.getColumnValues<std::uint8_t>(block, reader.findColumn("fouls"))[blockRow] };
+
+			std::cout << index.getFilePath(neighbour.entry->file) << " row " << row
+				<< ": distance " << std::sqrt(neighbour.distanceSquared)
+				<< ", angle " << angle << ", power " << power
+				<< ((pocketed & ~1u) ? ", potted" : "") << (fouls ? ", fouled" : "") << '\n';
+		}
+		std::cout << '\n';
+		return EXIT_SUCCESS;
+	}
+
+	static void printUsage()
+	{
+		std::cout << "[Headless Commands]\n";
+		std::cout << "--evaluate-shots [angles] [power levels] [refine count]\n";
+		std::cout << "--generate-difficulty-table [shots per entry] [output path]\n";
+		std::cout << "--check-planner-cache [shots]\n";
+		std::cout << "--dataset-info <path>\n";
+		std::cout << "--analyze-replays <directory> [heatmap csv path]\n";
+		std::cout << "--similar-positions <dataset or directory> [neighbours] [queries]\n";
+		std::cout << "--record-shots <path> [played|simulated|all] (in front of any other command)\n";
+		std::cout << "--check-energy [shots]\n";
+		std::cout << "--decode-physics-log <path>\n";
+		std::cout << "--metrics <path> [interval seconds] (in front of any other command, or --record-shots)\n";
+		std::cout << "--physics-log <path> (in front of any other command, or --record-shots, crash dumps are best effort)\n";
+		std::cout << "--physics-counters <path> (in front of the game, or --record-shots)\n";
+		std::cout << "--trace <path> (in front of any other command, or --record-shots)\n";
+		std::cout << "--benchmark-physics [repetitions]\n";
+		std::cout << "--tournament <round-robin|swiss> [rounds] [games per pairing] [checkpoint path] [bot,bot,...] [replay directory] [physics counters path]\n";
+	}
+
+	bool startShotRecording(int& argc, char**& argv, ShotDatasetWriter& recorder)
+	{
+		if (argc < 3 || std::string_view{ argv[1] } != "--record-shots")
+			return true;
+
+		const std::string path{ argv[2] };
+		int consumedArguments{ 2 };
+
+		// everything by default
+		bool recordsPlayed{ true };
+		bool recordsSimulated{ true };
+		if (argc > 3)
+		{
+			const std::string_view sources{ argv[3] };
+			if (sources == "played" || sources == "simulated" || sources == "all")
+			{
+				recordsPlayed = sources != "simulated";
+				recordsSimulated = sources != "played";
+				++consumedArguments;
+			}
+		}
+
+		if (!recorder.open(path, recordsPlayed, recordsSimulated))
+		{
+			std::cout << "Could not open shot dataset " << path << '\n';
+			return false;
+		}
+
+		simulation::setShotRecorder(&recorder);
+		std::cout << "[Recording Shots] " << path << "\n\n";
+
+		// keep the program name in front
+		argv[consumedArguments] = argv[0];
+		argv += consumedArguments;
+		argc -= consumedArguments;
+		return true;
+	}
+
+	void startTracing(int& argc, char**& argv)
+	{
+		if (argc < 3 || std::string_view{ argv[1] } != "--trace")
+			return;
+
+		trace::start(argv[2]);
+		std::cout << "[Tracing] " << argv[2] << "\n\n";
+
+		argv[2] = argv[0];
+		argv += 2;
+		argc -= 2;
+	}
+
+	void startPhysicsLog(int& argc, char**& argv)
+	{
+		if (argc < 3 || std::string_view{ argv[1] } != "--physics-log")
+			return;
+
+		physicsLog::enable(argv[2], true);
+		std::cout << "[Physics Log] " << argv[2] << "\n\n";
+
+		argv[2] = argv[0];
+		argv += 2;
+		argc -= 2;
+	}
+
+	void startPhysicsCounters(int& argc, char**& argv)
+	{
+		if (argc < 3 || std::string_view{ argv[1] } != "--physics-counters")
+			return;
+
+		physics::setCountersPath(argv[2]);
+		std::cout << "[Physics Counters] " << argv[2] << "\n\n";
+
+		argv[2] = argv[0];
+		argv += 2;
+		argc -= 2;
+	}
+
+	void startMetrics(int& argc, char**& argv)
+	{
+		if (argc < 3 || std::string_view{ argv[1] } != "--metrics")
+			return;
+
+		const std::string path{ argv[2] };
+		int consumedArguments{ 2 };
+
+		double interval{ consts::metricsIntervalSeconds };
+		if (argc > 3 && std::atof(argv[3]) > 0.0)
+		{
+			interval = std::atof(argv[3]);
+			++consumedArguments;
+		}
+
+		metrics::start(path, interval);
+		std::cout << "[Metrics] " << path << " every " << interval << "s\n\n";
+
+		argv[consumedArguments] = argv[0];
+		argv += consumedArguments;
+		argc -= consumedArguments;
+	}
+
+	int startRenderQuality(int& argc, char**& argv)
+	{
+		if (argc < 3 || std::string_view{ argv[1] } != "--quality")
+			return -1;
+
+		int tier{ -1 };
+		if (!RenderQuality::findTier(argv[2], tier))
+			std::cout << "Unknown render quality " << argv[2] << ", it will be picked from the frame times\n\n";
+
+		argv[2] = argv[0];
+		argv += 2;
+		argc -= 2;
+		return tier;
+	}
+
+	bool isHeadlessCommand(int argc, char* argv[])
+	{
+		return argc > 1 && std::string_view{ argv[1] }.substr(0, 2) == "--";
+	}
+
+	int runCommand(int argc, char* argv[])
+	{
+		const std::string_view command{ argv[1] };
+
+		if (command == "--evaluate-shots")
+			return runShotEvaluation(argc, argv);
+		if (command == "--generate-difficulty-table")
+			return runDifficultyTableGeneration(argc, argv);
+		if (command == "--check-planner-cache")
+			return runPlannerCacheCheck(argc, argv);
+		if (command == "--dataset-info")
+			return runDatasetInfo(argc, argv);
+		if (command == "--analyze-replays")
+			return runReplayAnalysis(argc, argv);
+		if (command == "--similar-positions")
+			return runPositionSearch(argc, argv);
+		if (command == "--benchmark-physics")
+			return runPhysicsBenchmark(argc, argv);
+		if (command == "--check-energy")
+			return runEnergyCheck(argc, argv);
+		if (command == "--decode-physics-log")
+			return runPhysicsLogDecode(argc, argv);
+		if (command == "--tournament")
+			return runTournament(argc, argv);
+
+		printUsage();
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+class ShotDatasetWriter;
+
+// command line tools that run the simulation without a display,
+// e.g. "CompSci20_PoolGame.exe --evaluate-shots 720 4 32"
+namespace headless
+{
+	// "--record-shots <path> [played|simulated|all]" in front of anything else (a tool or the game)
+	// opens the dataset and removes the option from argc and argv, false if it could not be opened
+	bool startShotRecording(int& argc, char**& argv, ShotDatasetWriter& recorder);
+
+	// "--trace <path>" in front of anything else turns the tracer on, each match
+	// (or the tool's run) is written next to path as a chrome trace
+	void startTracing(int& argc, char**& argv);
+
+	// "--physics-log <path>" in front of anything else records stepPhysics events,
+	// written to path when a tool finishes, on F4 in the game, or on a crash
+	void startPhysicsLog(int& argc, char**& argv);
+
+	// "--physics-counters <path>" in front of anything else makes the game append
+	// the physics counters of every shot and match to path, one json object per line
+	void startPhysicsCounters(int& argc, char**& argv);
+
+	// "--metrics <path> [interval seconds]" in front of anything else rewrites
+	// path with prometheus metrics every interval until metrics::stop()
+	void startMetrics(int& argc, char**& argv);
+
+	// "--quality <high|medium|low|minimal>" in front of anything else fixes the game's
+	// render quality instead of picking it from the frame times, returns the tier or -1
+	int startRenderQuality(int& argc, char**& argv);
+
+	bool isHeadlessCommand(int argc, char* argv[]);
+
+	// returns the exit code for the program
+	int runCommand(int argc, char* argv[]);
+}
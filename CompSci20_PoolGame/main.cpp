@@ -3,7 +3,13 @@
 #include "Input.h"
 #include "AllegroHandler.h"
 #include "GameLogic.h"
+#include "headless.h"
 #include "menu.h"
+#include "metrics.h"
+#include "physicsLog.h"
+#include "ShotDataset.h"
+#include "trace.h"
+#include "TurnJournal.h"
 
 #include <allegro5/allegro5.h>
 
@@ -11,19 +17,49 @@
 #include <string>
 #include <ctime>
 
-int main()
+int main(int argc, char* argv[])
 {
 	{ // initialize random number gen
 		std::srand(std::time(nullptr));
 		const int temp{ std::rand() };
 	}
 
+	// optional, for the game as well as the tools
+	headless::startTracing(argc, argv);
+	headless::startPhysicsLog(argc, argv);
+	headless::startPhysicsCounters(argc, argv);
+	headless::startMetrics(argc, argv);
+	const int renderQualityTier{ headless::startRenderQuality(argc, argv) };
+
+	ShotDatasetWriter shotRecorder;
+	if (!headless::startShotRecording(argc, argv, shotRecorder))
+	{
+		metrics::stop();
+		return EXIT_FAILURE;
+	}
+
+	// tools that run without the game window or allegro
+	if (headless::isHeadlessCommand(argc, argv))
+	{
+		const int exitCode{ headless::runCommand(argc, argv) };
+		trace::endSession();
+		if (physicsLog::isEnabled())
+			physicsLog::dump();
+		metrics::stop();
+		return exitCode;
+	}
+
 	// application lifetime variables
 	AllegroHandler allegro{};
 	Input& input{ Input::getInstance() };
 
+	if (renderQualityTier >= 0)
+		allegro.getRenderQuality().setOverride(renderQualityTier);
+
 	std::string playerName1{ "1" };
 	std::string playerName2{ "2" };
+	std::string trickShotTarget;
+	GameMode gameMode{};
 
 	bool gameRunning;
 	ALLEGRO_EVENT_TYPE eventType;
@@ -37,40 +73,58 @@ int main()
 	// application loop
 	while (true)
 	{
-		// display main menu
-		if (menu::initMenu(playerName1, playerName2))
+		// display main menu, a journal left behind is a match that never finished
+		TurnJournal::Contents unfinishedMatch;
+		const bool canResume{ TurnJournal::load(std::string{ consts::turnJournalPath }, unfinishedMatch) };
+		bool isResuming{};
+
+		if (menu::initMenu(playerName1, playerName2, gameMode, trickShotTarget, canResume, isResuming))
 		{
+			metrics::stop();
 			pauseProgram("Thank you for playing. Press [ENTER] to exit...");
 			return EXIT_SUCCESS;
 		}
 
 		// setup game window
 		allegro.createDisplay();
-		al_set_window_title(allegro.getDisplay(), "Totally Accurate Eight-Ball Simulator");
 
 		// setup game logic
-		GameLogic gameLogic{ allegro, playerName1, playerName2 };
+		GameLogic gameLogic{ allegro, playerName1, playerName2, gameMode, trickShotTarget, isResuming };
 		gameRunning = true;
 
 		input.clearAllStates();
 		allegro.startTimer();
 
+		bool wasFullscreenKeyDown{};
+
 		// game loop
 		while (gameRunning)
 		{
+			trace::begin("event wait");
 			al_wait_for_event(allegro.getEventQueue(), &allegro.getEvent());
+			trace::end("event wait");
 			eventType = allegro.getEvent().type;
 
 			if (eventType == ALLEGRO_EVENT_TIMER)
 			{
 				input.updateAllStates();
 
-				if (gameLogic.frameUpdate())
+				trace::begin("frameUpdate");
+				const bool hasGameEnded{ gameLogic.frameUpdate() };
+				trace::end("frameUpdate");
+
+				if (hasGameEnded)
 					break; // exit game
 
 				if (input.isKeyDown(ALLEGRO_KEY_ESCAPE))
 					break; // exit game
 
+				// F11 switches between the window and fullscreen
+				const bool isFullscreenKeyDown{ input.isKeyDown(ALLEGRO_KEY_F11) };
+				if (isFullscreenKeyDown && !wasFullscreenKeyDown)
+					allegro.toggleFullscreen();
+				wasFullscreenKeyDown = isFullscreenKeyDown;
+
 #ifdef DISPLAY_FPS
 				frames++;
 				currentFrameTime = al_get_time();
@@ -90,12 +144,19 @@ int main()
 			{
 				input.keyUpHook(allegro.getEvent().keyboard.keycode);
 			}
+			else if (eventType == ALLEGRO_EVENT_DISPLAY_RESIZE)
+			{
+				allegro.handleResize();
+			}
 			else if (eventType == ALLEGRO_EVENT_DISPLAY_CLOSE)
 			{
 				break; // exit game
 			}
 	}
 
+		gameLogic.endMatch();
+		trace::endSession();
+
 		allegro.stopTimer();
 		allegro.destroyFont();
 		allegro.destroyDisplay();
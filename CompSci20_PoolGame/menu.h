@@ -94,13 +94,30 @@ namespace menu
 		std::cout << "[Striking the Cue Ball]\n";
 		std::cout << "To strike the ball, click on your left mouse button.\n\n";
 
+		std::cout << "[Practice Mode]\n";
+		std::cout << "You play every shot yourself. Enter a trick shot like \"3 into 6 into corner pocket\" when starting,\n";
+		std::cout << "then press the \"h\" key at any time to be shown the aim and power that makes it.\n\n";
+
 		pauseProgram("Press [ENTER] to go back to main menu...");
 	}
 
-	bool initMenu(std::string& playerName1, std::string& playerName2)
+	void setTrickShotTarget(std::string& trickShotTarget)
+	{
+		std::cout << "=================\n";
+		std::cout << "= Practice Mode =\n";
+		std::cout << "=================\n\n";
+
+		std::cout << "Balls are numbered 1 to 15, pockets can be \"corner\", \"side\", \"any\" or p1 to p6.\n";
+		std::cout << "Enter a trick shot (e.g. 3 into 6 into corner pocket) or leave empty: ";
+		std::getline(std::cin, trickShotTarget);
+	}
+
+	// canResume offers the unfinished match from the turn journal, isResuming is set if it's picked
+	bool initMenu(std::string& playerName1, std::string& playerName2, GameMode& gameMode, std::string& trickShotTarget, const bool canResume, bool& isResuming)
 	{
 		bool menuActive{ true };
 		int userSelection;
+		isResuming = false;
 
 		while (menuActive)
 		{
@@ -110,10 +127,14 @@ namespace menu
 
 			std::cout << "===Please select one of the options below===\n";
 			std::cout << "[1] Play Eight-Ball\n";
-			std::cout << "[2] Setup Player Names\n";
-			std::cout << "[3] How to Play\n";
-			std::cout << "[4] Credits\n";
-			std::cout << "[5] Exit\n\n";
+			std::cout << "[2] Practice Mode\n";
+			std::cout << "[3] Setup Player Names\n";
+			std::cout << "[4] How to Play\n";
+			std::cout << "[5] Credits\n";
+			std::cout << "[6] Exit\n";
+			if (canResume)
+				std::cout << "[7] Resume Unfinished Match\n";
+			std::cout << '\n';
 
 			std::cout << "Select Option: ";
 			std::cin >> userSelection;
@@ -126,19 +147,32 @@ namespace menu
 				switch (userSelection)
 				{
 				case 1:
+					gameMode = GameMode::eightBall;
 					menuActive = false;
 					break;
 				case 2:
-					setPlayerNames(playerName1, playerName2);
+					setTrickShotTarget(trickShotTarget);
+					gameMode = GameMode::practice;
+					menuActive = false;
 					break;
 				case 3:
-					displayHelp();
+					setPlayerNames(playerName1, playerName2);
 					break;
 				case 4:
-					displayCredits();
+					displayHelp();
 					break;
 				case 5:
+					displayCredits();
+					break;
+				case 6:
 					return true;
+				case 7:
+					if (canResume)
+					{
+						isResuming = true;
+						menuActive = false;
+					}
+					break;
 				}
 			}
 
@@ -0,0 +1,281 @@
+#include "metrics.h"
+
+#include "common.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace metrics
+{
+	// log scale buckets like FrameTimings, 8 per doubling from 10 nanoseconds,
+	// atomic so any thread can record into them
+	static constexpr int bucketsPerDoubling{ 8 };
+	static constexpr int bucketCount{ 24 * bucketsPerDoubling }; // up to about 160 milliseconds
+	static constexpr double minimumSeconds{ 1e-8 };
+
+	static std::atomic<std::uint64_t> s_shots{};
+	static std::atomic<std::uint64_t> s_ticks{};
+	static std::atomic<std::uint64_t> s_plannerLegs{};
+	static std::atomic<std::uint64_t> s_plannerRecomputed{};
+	static std::atomic<int> s_queueDepth{};
+	static std::atomic<int> s_workers{};
+	// busy time at any moment is finished + busyCount * now - busyStartSum
+	static std::atomic<std::int64_t> s_finishedWorkNanoseconds{};
+	static std::atomic<std::int64_t> s_busyCount{};
+	static std::atomic<std::int64_t> s_busyStartSum{};
+	static const std::chrono::steady_clock::time_point s_epoch{ std::chrono::steady_clock::now() };
+
+	// the mean tick time of every shot, one observation per shot
+	static std::array<std::atomic<std::uint64_t>, bucketCount> s_meanTickBuckets{};
+	static std::atomic<std::uint64_t> s_meanTickPicoseconds{}; // summed over the shots
+	// every tick of every shot
+	static std::atomic<std::uint64_t> s_tickNanoseconds{};
+
+	// only the exporter thread and start/stop use these
+	static std::mutex s_exporterMutex;
+	static std::condition_variable s_exporterWakeup;
+	static std::thread s_exporter;
+	static bool s_isStopping{};
+
+	// rates are worked out between two writes
+	struct RateState
+	{
+		std::chrono::steady_clock::time_point time{};
+		std::uint64_t ticks{};
+		std::int64_t busyNanoseconds{};
+	};
+
+	static RateState s_lastWrite{ std::chrono::steady_clock::now() };
+
+	static int getBucket(const double seconds)
+	{
+		if (seconds <= minimumSeconds)
+			return 0;
+
+		const int bucket{ static_cast<int>(std::log2(seconds / minimumSeconds) * bucketsPerDoubling) + 1 };
+		return (bucket < bucketCount) ? bucket : bucketCount - 1;
+	}
+
+	static double getBucketEnd(const int bucket)
+	{
+		return minimumSeconds * std::exp2(static_cast<double>(bucket) / bucketsPerDoubling);
+	}
+
+	void recordShot(const int ticks, const double seconds)
+	{
+		if (ticks <= 0)
+			return;
+
+		s_shots.fetch_add(1, std::memory_order_relaxed);
+		s_ticks.fetch_add(static_cast<std::uint64_t>(ticks), std::memory_order_relaxed);
+		s_tickNanoseconds.fetch_add(static_cast<std::uint64_t>(seconds * 1e9), std::memory_order_relaxed);
+		s_meanTickPicoseconds.fetch_add(static_cast<std::uint64_t>(seconds / ticks * 1e12), std::memory_order_relaxed);
+		s_meanTickBuckets[getBucket(seconds / ticks)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void recordPlannerCacheUpdate(const int legs, const int recomputed)
+	{
+		s_plannerLegs.fetch_add(static_cast<std::uint64_t>(legs), std::memory_order_relaxed);
+		s_plannerRecomputed.fetch_add(static_cast<std::uint64_t>(recomputed), std::memory_order_relaxed);
+	}
+
+	void setQueueDepth(const int depth)
+	{
+		s_queueDepth.store(depth, std::memory_order_relaxed);
+	}
+
+	void setWorkerCount(const int workers)
+	{
+		s_workers.store(workers, std::memory_order_relaxed);
+	}
+
+	static std::int64_t getNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+	}
+
+	std::int64_t beginWork()
+	{
+		const std::int64_t start{ getNanoseconds() };
+		s_busyStartSum.fetch_add(start, std::memory_order_relaxed);
+		s_busyCount.fetch_add(1, std::memory_order_relaxed);
+		return start;
+	}
+
+	void endWork(const std::int64_t start)
+	{
+		s_finishedWorkNanoseconds.fetch_add(getNanoseconds() - start, std::memory_order_relaxed);
+		s_busyCount.fetch_sub(1, std::memory_order_relaxed);
+		s_busyStartSum.fetch_sub(start, std::memory_order_relaxed);
+	}
+
+	// interpolated inside the bucket, so within about 9% of the real value
+	static double getTickPercentile(const std::array<std::uint64_t, bucketCount>& buckets, const std::uint64_t count, const double fraction)
+	{
+		if (count == 0)
+			return 0.0;
+
+		const double target{ fraction * count };
+		double seen{};
+		for (int bucket{}; bucket < bucketCount; ++bucket)
+		{
+			if (buckets[bucket] == 0)
+				continue;
+
+			if (seen + buckets[bucket] >= target)
+			{
+				const double start{ (bucket == 0) ? 0.0 : getBucketEnd(bucket - 1) };
+				return start + (getBucketEnd(bucket) - start) * (target - seen) / buckets[bucket];
+			}
+			seen += buckets[bucket];
+		}
+		return getBucketEnd(bucketCount - 1);
+	}
+
+	void writePrometheusText(std::ostream& out)
+	{
+		// every value is read once, they keep moving while this runs
+		const std::uint64_t shots{ s_shots.load(std::memory_order_relaxed) };
+		const std::uint64_t ticks{ s_ticks.load(std::memory_order_relaxed) };
+		const std::uint64_t tickNanoseconds{ s_tickNanoseconds.load(std::memory_order_relaxed) };
+		const std::uint64_t meanTickPicoseconds{ s_meanTickPicoseconds.load(std::memory_order_relaxed) };
+		const std::uint64_t plannerLegs{ s_plannerLegs.load(std::memory_order_relaxed) };
+		const std::uint64_t plannerRecomputed{ s_plannerRecomputed.load(std::memory_order_relaxed) };
+		const int workers{ s_workers.load(std::memory_order_relaxed) };
+		// the three can be a work item apart, which utilization is clamped for
+		const std::int64_t nowNanoseconds{ getNanoseconds() };
+		const std::int64_t busyNanoseconds{
+			s_finishedWorkNanoseconds.load(std::memory_order_relaxed)
+			+ s_busyCount.load(std::memory_order_relaxed) * nowNanoseconds
+			- s_busyStartSum.load(std::memory_order_relaxed)
+		};
+
+		// count is summed from the buckets, so it is exactly the shots the quantiles are over
+		std::array<std::uint64_t, bucketCount> meanTickBuckets{};
+		std::uint64_t meanTickShots{};
+		for (int bucket{}; bucket < bucketCount; ++bucket)
+		{
+			meanTickBuckets[bucket] = s_meanTickBuckets[bucket].load(std::memory_order_relaxed);
+			meanTickShots += meanTickBuckets[bucket];
+		}
+
+		const std::chrono::steady_clock::time_point now{ std::chrono::steady_clock::now() };
+		const double elapsed{ std::chrono::duration<double>(now - s_lastWrite.time).count() };
+		const double ticksPerSecond{ (elapsed > 0.0) ? (ticks - s_lastWrite.ticks) / elapsed : 0.0 };
+		const double utilization{
+			(elapsed > 0.0 && workers > 0) ? std::clamp((busyNanoseconds - s_lastWrite.busyNanoseconds) / (elapsed * 1e9 * workers), 0.0, 1.0) : 0.0
+		};
+		s_lastWrite = { now, ticks, busyNanoseconds };
+
+		out << "# HELP pool_shots_simulated_total Shots simulated until the balls stopped.\n";
+		out << "# TYPE pool_shots_simulated_total counter\n";
+		out << "pool_shots_simulated_total " << shots << '\n';
+
+		out << "# HELP pool_ticks_simulated_total Physics ticks of simulated shots.\n";
+		out << "# TYPE pool_ticks_simulated_total counter\n";
+		out << "pool_ticks_simulated_total " << ticks << '\n';
+
+		out << "# HELP pool_ticks_per_second Simulated ticks per second since the last write.\n";
+		out << "# TYPE pool_ticks_per_second gauge\n";
+		out << "pool_ticks_per_second " << ticksPerSecond << '\n';
+
+		out << "# HELP pool_tick_seconds_total Time spent simulating ticks, divided by pool_ticks_simulated_total it is the mean tick time.\n";
+		out << "# TYPE pool_tick_seconds_total counter\n";
+		out << "pool_tick_seconds_total " << tickNanoseconds / 1e9 << '\n';
+
+		out << "# HELP pool_shot_mean_tick_seconds Mean tick time of each simulated shot, one observation per shot.\n";
+		out << "# TYPE pool_shot_mean_tick_seconds summary\n";
+		for (const double quantile : { 0.5, 0.9, 0.99 })
+			out << "pool_shot_mean_tick_seconds{quantile=\"" << quantile << "\"} " << getTickPercentile(meanTickBuckets, meanTickShots, quantile) << '\n';
+		out << "pool_shot_mean_tick_seconds_sum " << meanTickPicoseconds / 1e12 << '\n';
+		out << "pool_shot_mean_tick_seconds_count " << meanTickShots << '\n';
+
+		out << "# HELP pool_queue_depth Work items waiting for a worker.\n";
+		out << "# TYPE pool_queue_depth gauge\n";
+		out << "pool_queue_depth " << s_queueDepth.load(std::memory_order_relaxed) << '\n';
+
+		out << "# HELP pool_workers Worker threads running.\n";
+		out << "# TYPE pool_workers gauge\n";
+		out << "pool_workers " << workers << '\n';
+
+		out << "# HELP pool_worker_utilization Fraction of worker time spent on work since the last write.\n";
+		out << "# TYPE pool_worker_utilization gauge\n";
+		out << "pool_worker_utilization " << utilization << '\n';
+
+		out << "# HELP pool_planner_cache_legs_total Shot planner cache legs looked at by updates.\n";
+		out << "# TYPE pool_planner_cache_legs_total counter\n";
+		out << "pool_planner_cache_legs_total " << plannerLegs << '\n';
+
+		out << "# HELP pool_planner_cache_recomputed_total Shot planner cache legs that had to be recomputed.\n";
+		out << "# TYPE pool_planner_cache_recomputed_total counter\n";
+		out << "pool_planner_cache_recomputed_total " << plannerRecomputed << '\n';
+
+		out << "# HELP pool_planner_cache_hit_ratio Fraction of planner cache legs reused.\n";
+		out << "# TYPE pool_planner_cache_hit_ratio gauge\n";
+		out << "pool_planner_cache_hit_ratio " << ((plannerLegs > 0) ? 1.0 - static_cast<double>(plannerRecomputed) / plannerLegs : 0.0) << '\n';
+	}
+
+	static bool writeFile(const std::string& path)
+	{
+		const std::string temporaryPath{ path + ".tmp" };
+		{
+			std::ofstream file{ temporaryPath, std::ios::trunc };
+			if (!file)
+				return false;
+
+			writePrometheusText(file);
+			if (!file)
+				return false;
+		}
+
+		// a scrape in between still finds the last file
+		return replaceFile(temporaryPath, path);
+	}
+
+	bool start(const std::string& path, const double intervalSeconds)
+	{
+		std::lock_guard<std::mutex> lock{ s_exporterMutex };
+		if (s_exporter.joinable())
+			return false;
+
+		s_isStopping = false;
+		s_exporter = std::thread{ [path, intervalSeconds]() {
+			const std::chrono::duration<double> interval{ intervalSeconds };
+
+			std::unique_lock<std::mutex> lock{ s_exporterMutex };
+			bool isStopping{};
+			while (!isStopping)
+			{
+				isStopping = s_exporterWakeup.wait_for(lock, interval, []() { return s_isStopping; });
+
+				if (!writeFile(path))
+					std::cout << "Could not write metrics " << path << '\n';
+			}
+		} };
+
+		return true;
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ s_exporterMutex };
+			if (!s_exporter.joinable())
+				return;
+
+			s_isStopping = true;
+		}
+
+		s_exporterWakeup.notify_all();
+		s_exporter.join();
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// process wide numbers for long running tools (tournaments, table generation),
+// written in the prometheus text format to a file a node exporter textfile
+// collector (or anything else) can pick up
+// - recording is a few relaxed atomic adds, simulation threads never wait on the exporter
+// - the exporter thread rewrites the file every interval, through a temporary
+//   file and replaceFile so a reader never sees half of it, or no file at all
+namespace metrics
+{
+	// a whole shot run to rest, ticks is how many it took
+	void recordShot(const int ticks, const double seconds);
+	// legs is how many the cache holds, recomputed how many of them an update had to redo
+	void recordPlannerCacheUpdate(const int legs, const int recomputed);
+
+	// work queues and the workers taking from them, e.g. a tournament round
+	void setQueueDepth(const int depth);
+	void setWorkerCount(const int workers);
+	// around each work item, work still in progress counts towards utilization too
+	std::int64_t beginWork();
+	void endWork(const std::int64_t start);
+
+	// starts the exporter thread, false if it is already running
+	bool start(const std::string& path, const double intervalSeconds);
+	// writes one last time and joins the exporter, fine to call if it never started
+	void stop();
+
+	void writePrometheusText(std::ostream& out);
+}
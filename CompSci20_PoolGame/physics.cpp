@@ -5,11 +5,20 @@
 #include "constants.h"
 #include "Vector2.h"
 #include "Players.h"
+#include "physicsLog.h"
+#include "trace.h"
 
 #include <allegro5/allegro_audio.h>
 
+#include <atomic>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
 #include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
 
 /*
 	--IMPORTANT REMINDER FOR COLLISION TESTING--
@@ -26,6 +35,174 @@
 
 namespace physics
 {
+	static thread_local StepCounters s_stepCounters{};
+	static thread_local StepCounters s_lastTickCounters{};
+	static std::string s_countersPath;
+
+	static std::atomic<bool> s_isMonitoringEnergy{};
+	static thread_local EnergyLedger s_energyLedger{};
+
+	void StepCounters::merge(const StepCounters& other)
+	{
+		ticks += other.ticks;
+		substeps += other.substeps;
+		pairTests += other.pairTests;
+		overlapsResolved += other.overlapsResolved;
+		boundaryHits += other.boundaryHits;
+		pocketChecks += other.pocketChecks;
+		ballsAwake += other.ballsAwake;
+	}
+
+	StepCounters StepCounters::getDifference(const StepCounters& earlier) const
+	{
+		return {
+			ticks - earlier.ticks,
+			substeps - earlier.substeps,
+			pairTests - earlier.pairTests,
+			overlapsResolved - earlier.overlapsResolved,
+			boundaryHits - earlier.boundaryHits,
+			pocketChecks - earlier.pocketChecks,
+			ballsAwake - earlier.ballsAwake
+		};
+	}
+
+	const StepCounters& getStepCounters()
+	{
+		return s_stepCounters;
+	}
+
+	const StepCounters& getLastTickCounters()
+	{
+		return s_lastTickCounters;
+	}
+
+	// names are typed in by the players, so they can hold anything
+	static void writeJsonString(std::ostream& out, std::string_view text)
+	{
+		out << '"';
+		for (const char character : text)
+		{
+			if (character == '"' || character == '\\')
+				out << '\\' << character;
+			else if (static_cast<unsigned char>(character) < 0x20)
+				out << "\\u00" << "0123456789abcdef"[character >> 4] << "0123456789abcdef"[character & 0xf];
+			else
+				out << character;
+		}
+		out << '"';
+	}
+
+	void writeStepCounters(std::ostream& out, std::string_view scope, std::string_view name, const StepCounters& counters)
+	{
+		out << "{\"scope\":";
+		writeJsonString(out, scope);
+		if (!name.empty())
+		{
+			out << ",\"name\":";
+			writeJsonString(out, name);
+		}
+
+		out
+			<< ",\"ticks\":" << counters.ticks
+			<< ",\"substeps\":" << counters.substeps
+			<< ",\"pair_tests\":" << counters.pairTests
+			<< ",\"overlaps_resolved\":" << counters.overlapsResolved
+			<< ",\"boundary_hits\":" << counters.boundaryHits
+			<< ",\"pocket_checks\":" << counters.pocketChecks
+			<< ",\"balls_awake\":" << counters.ballsAwake
+			<< "}\n";
+	}
+
+	void printStepCounters(const StepCounters& counters)
+	{
+		const double ticks{ static_cast<double>((counters.ticks > 0) ? counters.ticks : 1) };
+
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << "Ticks: " << counters.ticks << '\n';
+		std::cout << "Substeps: " << counters.substeps << " (" << counters.substeps / ticks << " per tick)\n";
+		std::cout << "Pair Tests: " << counters.pairTests << " (" << counters.pairTests / ticks << " per tick)\n";
+		std::cout << "Overlaps Resolved: " << counters.overlapsResolved << '\n';
+		std::cout << "Boundary Hits: " << counters.boundaryHits << '\n';
+		std::cout << "Pocket Checks: " << counters.pocketChecks << '\n';
+		std::cout << "Balls Awake: " << counters.ballsAwake / ticks << " per tick\n";
+		std::cout << std::defaultfloat;
+	}
+
+	void setCountersPath(std::string_view path)
+	{
+		s_countersPath = path;
+	}
+
+	const std::string& getCountersPath()
+	{
+		return s_countersPath;
+	}
+
+	void setEnergyMonitoring(const bool isMonitoring)
+	{
+		s_isMonitoringEnergy.store(isMonitoring, std::memory_order_relaxed);
+	}
+
+	bool isMonitoringEnergy()
+	{
+		return s_isMonitoringEnergy.load(std::memory_order_relaxed);
+	}
+
+	const EnergyLedger& getEnergyLedger()
+	{
+		return s_energyLedger;
+	}
+
+	void resetEnergyLedger()
+	{
+		s_energyLedger = {};
+	}
+
+	void printEnergyLedger(const EnergyLedger& ledger)
+	{
+		// changes as a percentage of the energy the shots put in
+		const double addedEnergy{ (ledger.addedEnergy > 0.0) ? ledger.addedEnergy : 1.0 };
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "Ticks: " << ledger.ticks << '\n';
+		std::cout << "Energy Added: " << ledger.addedEnergy << ", left: " << ledger.endEnergy << '\n';
+		std::cout << "Rolling Friction: " << ledger.rollingFriction << " (" << ledger.rollingFriction * 100.0 / addedEnergy << "%)\n";
+		std::cout << "Ball Collisions: " << ledger.ballCollisions << " (" << ledger.ballCollisions * 100.0 / addedEnergy << "%)\n";
+		std::cout << "Cushions: " << ledger.cushions << " (" << ledger.cushions * 100.0 / addedEnergy << "%)\n";
+		std::cout << "Pocketed: " << ledger.pocketed << " (" << ledger.pocketed * 100.0 / addedEnergy << "%)\n";
+		std::cout << "Unexplained: " << ledger.unexplained << '\n';
+		std::cout << "Position Correction: " << ledger.correctionDistance << " px\n";
+		std::cout << "Collision Momentum Change: " << ledger.collisionMomentumChange << '\n';
+		std::cout << "Energy Gained: " << ledger.energyGainTicks << " ticks, " << ledger.energyGainCollisions << " collisions";
+		if (ledger.energyGainTicks > 0)
+			std::cout << ", largest " << ledger.largestGain << " on tick " << ledger.largestGainTick;
+		std::cout << '\n' << std::defaultfloat;
+	}
+
+	static double getKineticEnergy(const Ball& ball)
+	{
+		const double vx{ ball.getVX() };
+		const double vy{ ball.getVY() };
+		return 0.5 * ball.getMass() * (vx * vx + vy * vy);
+	}
+
+	static double getKineticEnergy(const Ball::balls_type& gameBalls)
+	{
+		double energy{};
+		for (const Ball& ball : gameBalls)
+		{
+			if (ball.isVisible())
+				energy += getKineticEnergy(ball);
+		}
+		return energy;
+	}
+
+	// small enough to only catch real gains, not rounding
+	static bool isEnergyGain(const double before, const double after)
+	{
+		return after - before > 1e-9 * (before + 1.0);
+	}
+
 	bool isCircleCollidingWithBoundaryTop(const Ball& ball, const Rectangle& boundary)
 	{
 		return (ball.getY() - ball.getRadius()) < boundary.yPos1;
@@ -58,7 +235,30 @@ namespace physics
 		return false;
 	}
 
-	static void resolveCircleCollisionPosition(Ball& ball1, Ball& ball2)
+	bool isValidPlacePosition(const Ball& cueBall, const Ball::balls_type& gameBalls)
+	{
+		bool isOverlappingBall{};
+		bool isOverlappingBoundary{};
+
+		for (const Ball& ball : gameBalls)
+		{
+			if (cueBall.isOverlappingBall(ball))
+			{
+				isOverlappingBall = true;
+				break;
+			}
+		}
+
+		isOverlappingBoundary = isCircleCollidingWithBoundaryTop(cueBall, consts::playSurface)
+			|| isCircleCollidingWithBoundaryBottom(cueBall, consts::playSurface)
+			|| isCircleCollidingWithBoundaryLeft(cueBall, consts::playSurface)
+			|| isCircleCollidingWithBoundaryRight(cueBall, consts::playSurface);
+
+		return !isOverlappingBall && !isOverlappingBoundary;
+	}
+
+	// returns how far the balls overlapped
+	static double resolveCircleCollisionPosition(Ball& ball1, Ball& ball2)
 	{
 		const Vector2 deltaPosition{ ball1.getPositionVector().copyAndSubtract(ball2.getPositionVector()) };
 
@@ -68,23 +268,10 @@ namespace physics
 		// change the distance into a vector by making it based on the normal
 		const Vector2 moveVector{ deltaPosition.getNormalized().copyAndMultiply(ballOverlap) };
 
-#ifdef DEBUG
-		std::cout << "[POSITION RESOLUTION]\n";
-		std::cout << "[distance] " << deltaPosition.getLength() << '\n';
-		std::cout << "[overlap] " << ballOverlap << '\n';
-		std::cout << "[moveDistanceX] " << moveVector.getX() << '\n';
-		std::cout << "[moveDistanceY] " << moveVector.getY() << '\n';
-		std::cout << "[start ball1] " << ball1.getX() << ", " << ball1.getY() << '\n';
-		std::cout << "[start ball2] " << ball2.getX() << ", " << ball2.getY() << '\n';
-#endif // DEBUG
-
 		ball1.subPosition(moveVector);
 		ball2.addPosition(moveVector);
 
-#ifdef DEBUG
-		std::cout << "[end ball1] " << ball1.getX() << ", " << ball1.getY() << '\n';
-		std::cout << "[end ball2] " << ball2.getX() << ", " << ball2.getY() << "\n\n";
-#endif // DEBUG
+		return -2.0 * ballOverlap;
 	}
 
 	static void resolveCircleCollisionVelocity(Ball& ball1, Ball& ball2)
@@ -98,23 +285,19 @@ namespace physics
 		const double momentum{ 2.0 * normalVector.getDotProduct(deltaVelocity) / (ball1.getMass() + ball2.getMass()) };
 		const Vector2 newVelocityVector{ normalVector.copyAndMultiply(momentum * consts::collisionFriction) };
 
-#ifdef DEBUG
-		std::cout << "[VELOCITY RESOLUTION]\n";
-		std::cout << "[distance] " << deltaPosition.getLength() << '\n';
-		std::cout << "[normal] " << normalVector.getX() << ", " << normalVector.getY() << '\n';
-		std::cout << "[deltaVelocity] " << deltaVelocity.getX() << ", " << deltaVelocity.getY() << '\n';
-		std::cout << "[newVelocity] " << newVelocityVector.getX() << ", " << newVelocityVector.getY() << '\n';
-		std::cout << "[start ball1] " << ball1.getVX() << ", " << ball1.getVY() << '\n';
-		std::cout << "[start ball2] " << ball2.getVX() << ", " << ball2.getVY() << '\n';
-#endif // DEBUG
-
 		ball1.subVelocity(newVelocityVector.copyAndMultiply(ball2.getMass()));
 		ball2.addVelocity(newVelocityVector.copyAndMultiply(ball1.getMass()));
+	}
 
-#ifdef DEBUG
-		std::cout << "[end ball1] " << ball1.getVX() << ", " << ball1.getVY() << '\n';
-		std::cout << "[end ball2] " << ball2.getVX() << ", " << ball2.getVY() << "\n\n";
-#endif // DEBUG
+	static void logBall(const physicsLog::RecordType type, const std::uint64_t tick, const Ball& ball, const int otherBall, const double value)
+	{
+		physicsLog::add({
+			static_cast<std::uint32_t>(tick), type,
+			static_cast<std::int8_t>(ball.getBallNumber()), static_cast<std::int8_t>(otherBall), 0,
+			static_cast<float>(ball.getX()), static_cast<float>(ball.getY()),
+			static_cast<float>(ball.getVX()), static_cast<float>(ball.getVY()),
+			static_cast<float>(value)
+		});
 	}
 
 	static bool resolveCircleBoundaryCollision(Ball& ball, const Rectangle& boundary)
@@ -160,8 +343,12 @@ namespace physics
 		return didCollide;
 	}
 
-	static void playBallCollisionSound(const AllegroHandler& allegro, const Ball& ball1, const Ball& ball2)
+	static void playBallCollisionSound(const AllegroHandler* allegro, const Ball& ball1, const Ball& ball2)
 	{
+		// headless simulations have no audio
+		if (!allegro)
+			return;
+
 		double volume{ (ball1.getVelocityVector().getLength() + ball2.getVelocityVector().getLength()) / 50 };
 
 		// sound is too quiet to play
@@ -172,12 +359,8 @@ namespace physics
 		if (volume > 1.0)
 			volume = 1.0;
 
-#ifdef DEBUG
-		std::cout << "[SOUND LOUDNESS]: " << collisionLoudness << '\n';
-#endif // DEBUG
-
 		al_play_sample(
-			allegro.getAudioSample(AudioSamples::ball_clack), // sound sample
+			allegro->getAudioSample(AudioSamples::ball_clack), // sound sample
 			0.75 * volume, // volume
 			0, // balance
 			1, // playback speed
@@ -193,9 +376,9 @@ namespace physics
 			: Ball::BallSuitType::solid;
 	}
 
-	static void handlePocketing(Ball& ball, Players& gamePlayers, TurnInformation& currentTurn, const AllegroHandler& allegro)
+	static void handlePocketing(Ball& ball, const bool isInPocket, Players& gamePlayers, TurnInformation& currentTurn, const AllegroHandler* allegro)
 	{
-		if (!ball.isInPocket())
+		if (!isInPocket)
 			return;
 
 		// stop ball and mark it as inactive
@@ -203,7 +386,7 @@ namespace physics
 		ball.setVisible(false);
 
 		// update turn informations
-		currentTurn.pocketedBalls.push_back(&ball);
+		currentTurn.pocketedBalls |= ballMask::getBall(ball.getBallNumber());
 		currentTurn.didNoRailFoul = false;
 
 		// check if this is the first pocketed ball
@@ -219,14 +402,17 @@ namespace physics
 		}
 
 		// play pocketing sound
-		al_play_sample(
-			allegro.getAudioSample(AudioSamples::ball_pocket), // sound sample
-			0.5, // volume
-			0, // balance
-			1, // playback speed
-			ALLEGRO_PLAYMODE_ONCE,
-			nullptr
-		);
+		if (allegro)
+		{
+			al_play_sample(
+				allegro->getAudioSample(AudioSamples::ball_pocket), // sound sample
+				0.5, // volume
+				0, // balance
+				1, // playback speed
+				ALLEGRO_PLAYMODE_ONCE,
+				nullptr
+			);
+		}
 	}
 
 	// in this function we calculate:
@@ -234,8 +420,23 @@ namespace physics
 	// - ball friction
 	// - ball to ball collisions
 	// - ball to boundary collisions
-	void stepPhysics(Ball::balls_type& gameBalls, Players& gamePlayers, TurnInformation& currentTurn, const AllegroHandler& allegro)
+	// allegro is nullptr when running headless (no sounds are played)
+	static void stepPhysicsImpl(Ball::balls_type& gameBalls, Players& gamePlayers, TurnInformation& currentTurn, const AllegroHandler* allegro)
 	{
+		const trace::Scope traceScope{ "stepPhysics" };
+
+		// counted locally and handed over once, the loops below stay as they were
+		StepCounters tick{};
+		tick.ticks = 1;
+
+		// checked once, the log is off for nearly every tick ever simulated
+		const bool isLogging{ physicsLog::isEnabled() };
+		const std::uint64_t tickNumber{ s_stepCounters.ticks };
+
+		const bool isMonitoringEnergy{ s_isMonitoringEnergy.load(std::memory_order_relaxed) };
+		EnergyLedger energy{};
+		const double startEnergy{ isMonitoringEnergy ? getKineticEnergy(gameBalls) : 0.0 };
+
 		for (Ball& ball : gameBalls)
 		{
 			// skip inactive balls
@@ -247,34 +448,72 @@ namespace physics
 
 			if (stepsNeeded > 0.0)
 			{
+				++tick.ballsAwake;
 				bool hasCollided{};
 				const double stepSizeX{ ball.getVX() / stepsNeeded };
 				const double stepSizeY{ ball.getVY() / stepsNeeded };
 
-#ifdef DEBUG
-				std::cout << "[BALL STEP MOVE " << &ball << "] "
-					<< stepSizeX << ", " << stepSizeY << ", " << stepsNeeded << ", "
-					<< ball.getX() << ", " << ball.getY() << '\n';
-#endif // DEBUG
+				if (isLogging)
+					logBall(physicsLog::RecordType::step, tickNumber, ball, -1, stepsNeeded);
 
 				while (stepsNeeded > 0.0 && !hasCollided)
 				{
 					ball.addPosition(stepSizeX, stepSizeY);
+					++tick.substeps;
 
 					// check circle to circle collision
 					for (Ball& checkTarget : gameBalls)
 					{
+						// never against itself or a pocketed ball, like isOverlappingBall
+						if (&checkTarget == &ball || !checkTarget.isVisible())
+							continue;
+
+						++tick.pairTests;
 						if (ball.isOverlappingBall(checkTarget))
 						{
+							++tick.overlapsResolved;
 							playBallCollisionSound(allegro, ball, checkTarget);
 
-							resolveCircleCollisionPosition(ball, checkTarget);
-							resolveCircleCollisionVelocity(ball, checkTarget);
+							if (isLogging)
+							{
+								const double depth{ ball.getRadius() + checkTarget.getRadius() - calculateHypotenuse(ball.getX() - checkTarget.getX(), ball.getY() - checkTarget.getY()) };
+								logBall(physicsLog::RecordType::contact, tickNumber, ball, checkTarget.getBallNumber(), depth);
+							}
+
+							const double overlap{ resolveCircleCollisionPosition(ball, checkTarget) };
+
+							if (isMonitoringEnergy)
+							{
+								const double energyBefore{ getKineticEnergy(ball) + getKineticEnergy(checkTarget) };
+								const Vector2 momentumBefore{ ball.getVelocityVector().copyAndMultiply(ball.getMass()).copyAndAdd(checkTarget.getVelocityVector().copyAndMultiply(checkTarget.getMass())) };
+
+								resolveCircleCollisionVelocity(ball, checkTarget);
+
+								const double energyAfter{ getKineticEnergy(ball) + getKineticEnergy(checkTarget) };
+								const Vector2 momentumAfter{ ball.getVelocityVector().copyAndMultiply(ball.getMass()).copyAndAdd(checkTarget.getVelocityVector().copyAndMultiply(checkTarget.getMass())) };
+
+								energy.ballCollisions += energyAfter - energyBefore;
+								energy.correctionDistance += overlap;
+								energy.collisionMomentumChange += momentumAfter.copyAndSubtract(momentumBefore).getLength();
+								if (isEnergyGain(energyBefore, energyAfter))
+									++energy.energyGainCollisions;
+							}
+							else
+							{
+								resolveCircleCollisionVelocity(ball, checkTarget);
+							}
+
+							if (isLogging)
+							{
+								logBall(physicsLog::RecordType::resolved, tickNumber, ball, checkTarget.getBallNumber(), overlap);
+								logBall(physicsLog::RecordType::resolved, tickNumber, checkTarget, ball.getBallNumber(), overlap);
+							}
 
 							if (currentTurn.firstHitBallType == Ball::BallSuitType::unknown)
 							{
 								// assume the first collision always is cue ball + random ball
 								currentTurn.firstHitBallType = (ball.getBallNumber() == 0) ? checkTarget.getBallType() : ball.getBallType();
+								currentTurn.firstHitBallNumber = static_cast<std::int8_t>((ball.getBallNumber() == 0) ? checkTarget.getBallNumber() : ball.getBallNumber());
 								currentTurn.didNoRailFoul = true;
 							}
 
@@ -286,15 +525,89 @@ namespace physics
 					--stepsNeeded;
 				}
 
-				handlePocketing(ball, gamePlayers, currentTurn, allegro);
+				// every pocket up to the one the ball drops into
+				const int pocketIndex{ ball.getPocketIndex() };
+				const bool isInPocket{ pocketIndex >= 0 };
+				tick.pocketChecks += isInPocket ? static_cast<std::uint64_t>(pocketIndex) + 1 : consts::pocketCoordinates.size();
+				if (isLogging && isInPocket)
+					logBall(physicsLog::RecordType::pocketed, tickNumber, ball, -1, ball.getVelocityVector().getLength());
 
-				ball.applyFriction(consts::rollingFriction, consts::stoppingVelocity);
+				if (isMonitoringEnergy)
+				{
+					// each ball's own changes, measured around the calls that make them
+					double energyBefore{ getKineticEnergy(ball) };
+					handlePocketing(ball, isInPocket, gamePlayers, currentTurn, allegro);
+					double energyAfter{ ball.isVisible() ? getKineticEnergy(ball) : 0.0 };
+					energy.pocketed += energyAfter - energyBefore;
+
+					energyBefore = energyAfter;
+					ball.applyFriction(consts::rollingFriction, consts::stoppingVelocity);
+					energyAfter = ball.isVisible() ? getKineticEnergy(ball) : 0.0;
+					energy.rollingFriction += energyAfter - energyBefore;
+				}
+				else
+				{
+					handlePocketing(ball, isInPocket, gamePlayers, currentTurn, allegro);
+					ball.applyFriction(consts::rollingFriction, consts::stoppingVelocity);
+				}
 
+				const double energyBeforeCushion{ isMonitoringEnergy ? getKineticEnergy(ball) : 0.0 };
 				if (resolveCircleBoundaryCollision(ball, consts::playSurface))
 				{
+					if (isMonitoringEnergy)
+						energy.cushions += getKineticEnergy(ball) - energyBeforeCushion;
+
+					if (isLogging)
+						logBall(physicsLog::RecordType::cushion, tickNumber, ball, -1, 0.0);
+
+					++tick.boundaryHits;
 					currentTurn.didNoRailFoul = false;
 				}
 			}
 		}
+
+		s_stepCounters.merge(tick);
+		s_lastTickCounters = tick;
+
+		if (isMonitoringEnergy)
+		{
+			const double endEnergy{ getKineticEnergy(gameBalls) };
+			const double attributed{ energy.rollingFriction + energy.ballCollisions + energy.cushions + energy.pocketed };
+
+			EnergyLedger& ledger{ s_energyLedger };
+			if (startEnergy > ledger.endEnergy)
+				ledger.addedEnergy += startEnergy - ledger.endEnergy;
+
+			++ledger.ticks;
+			ledger.endEnergy = endEnergy;
+			ledger.rollingFriction += energy.rollingFriction;
+			ledger.ballCollisions += energy.ballCollisions;
+			ledger.cushions += energy.cushions;
+			ledger.pocketed += energy.pocketed;
+			ledger.unexplained += (endEnergy - startEnergy) - attributed;
+			ledger.correctionDistance += energy.correctionDistance;
+			ledger.collisionMomentumChange += energy.collisionMomentumChange;
+			ledger.energyGainCollisions += energy.energyGainCollisions;
+
+			if (isEnergyGain(startEnergy, endEnergy))
+			{
+				++ledger.energyGainTicks;
+				if (endEnergy - startEnergy > ledger.largestGain)
+				{
+					ledger.largestGain = endEnergy - startEnergy;
+					ledger.largestGainTick = tickNumber;
+				}
+			}
+		}
+	}
+
+	void stepPhysics(Ball::balls_type& gameBalls, Players& gamePlayers, TurnInformation& currentTurn, const AllegroHandler& allegro)
+	{
+		stepPhysicsImpl(gameBalls, gamePlayers, currentTurn, &allegro);
+	}
+
+	void stepPhysics(Ball::balls_type& gameBalls, Players& gamePlayers, TurnInformation& currentTurn)
+	{
+		stepPhysicsImpl(gameBalls, gamePlayers, currentTurn, nullptr);
 	}
 } // namespace physics
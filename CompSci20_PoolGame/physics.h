@@ -5,9 +5,83 @@
 #include "Players.h"
 #include "common.h"
 
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
 namespace physics
 {
+	// where stepPhysics spends its time, always counted
+	// every thread keeps its own totals, so nothing is shared between simulations
+	struct StepCounters
+	{
+		std::uint64_t ticks{}; // stepPhysics calls
+		std::uint64_t substeps{};
+		std::uint64_t pairTests{};
+		std::uint64_t overlapsResolved{};
+		std::uint64_t boundaryHits{};
+		std::uint64_t pocketChecks{};
+		std::uint64_t ballsAwake{}; // moving balls at the start of each tick, summed
+
+		void merge(const StepCounters& other);
+		// the counts since earlier was taken from the same thread
+		StepCounters getDifference(const StepCounters& earlier) const;
+	};
+
+	// this thread's totals since it started
+	const StepCounters& getStepCounters();
+	// this thread's last stepPhysics call
+	const StepCounters& getLastTickCounters();
+
+	// one json object per line, e.g. {"scope":"shot","ticks":412,...}, name is left out if empty
+	void writeStepCounters(std::ostream& out, std::string_view scope, std::string_view name, const StepCounters& counters);
+	void printStepCounters(const StepCounters& counters);
+
+	// the game appends every shot and match here, empty (the default) writes nothing
+	// set once at startup by "--physics-counters <path>"
+	void setCountersPath(std::string_view path);
+	const std::string& getCountersPath();
+
+	// where the kinetic energy (m * v^2 / 2) of the table goes, only kept while monitoring
+	// every change is put down to what caused it, unexplained is whatever is left over
+	struct EnergyLedger
+	{
+		std::uint64_t ticks{};
+		double addedEnergy{}; // given to the balls between ticks, by shots
+		double endEnergy{}; // at the end of the last tick
+
+		// changes, negative = lost
+		double rollingFriction{}; // including balls snapped to a stop
+		double ballCollisions{};
+		double cushions{};
+		double pocketed{};
+		double unexplained{};
+
+		// position correction moves balls apart without changing their speed,
+		// so it shows up as distance instead of energy
+		double correctionDistance{};
+		// ball collisions should conserve momentum, collisionFriction only takes energy
+		double collisionMomentumChange{};
+
+		// a tick should never end with more energy than it started with
+		std::uint64_t energyGainTicks{};
+		std::uint64_t energyGainCollisions{};
+		double largestGain{};
+		std::uint64_t largestGainTick{}; // this thread's stepPhysics calls so far
+	};
+
+	// for every thread, checked once per tick
+	void setEnergyMonitoring(const bool isMonitoring);
+	bool isMonitoringEnergy();
+	// this thread's ledger since its last reset
+	const EnergyLedger& getEnergyLedger();
+	void resetEnergyLedger();
+	void printEnergyLedger(const EnergyLedger& ledger);
+
 	void stepPhysics(Ball::balls_type& gameBalls, Players& gamePlayers, TurnInformation& turn, const AllegroHandler& allegro);
+	// same simulation without any audio, used for headless shot simulations
+	void stepPhysics(Ball::balls_type& gameBalls, Players& gamePlayers, TurnInformation& turn);
 
 	// boundary checks
 	bool isCircleCollidingWithBoundaryTop(const Ball& ball, const Rectangle& boundary);
@@ -17,4 +91,6 @@ namespace physics
 
 	// misc function
 	bool areBallsMoving(const Ball::balls_type& gameBalls);
+	// ball in hand, the cue ball can't overlap a ball or a boundary
+	bool isValidPlacePosition(const Ball& cueBall, const Ball::balls_type& gameBalls);
 }
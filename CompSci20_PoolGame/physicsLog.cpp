@@ -0,0 +1,318 @@
+#include "physicsLog.h"
+
+#include "constants.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace physicsLog
+{
+	// only its own thread writes, written counts up forever and the
+	// record it points to is overwritten once the buffer is full
+	struct ThreadBuffer
+	{
+		std::vector<Record> records;
+		std::atomic<std::uint64_t> written{};
+		std::atomic<std::uint32_t> threadId{}; // changes when the buffer is reused, while a crash dump may read it
+		bool isOwned{};
+	};
+
+	static std::atomic<bool> s_isEnabled{};
+	static std::string s_path;
+	// opened by enable, a signal handler can't open files or use streams
+	static int s_crashFile{ -1 };
+
+	// buffers of finished threads are handed to new ones
+	static std::mutex s_buffersMutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+	static std::uint32_t s_nextThreadId{ 1 };
+
+	// the same buffers for the dumps, a whole buffer is in place before the count
+	// takes it in, so the crash handler reads them without s_buffersMutex, which
+	// the crashed thread might be holding
+	static std::array<std::atomic<ThreadBuffer*>, consts::physicsLogMaxThreads> s_publishedBuffers{};
+	static std::atomic<std::uint32_t> s_publishedCount{};
+
+	struct BufferHandle
+	{
+		ThreadBuffer* buffer{};
+
+		~BufferHandle()
+		{
+			if (!buffer)
+				return;
+
+			std::lock_guard<std::mutex> lock{ s_buffersMutex };
+			buffer->isOwned = false;
+		}
+	};
+
+	static thread_local BufferHandle s_threadBuffer{};
+
+	static ThreadBuffer& getThreadBuffer()
+	{
+		if (s_threadBuffer.buffer)
+			return *s_threadBuffer.buffer;
+
+		std::lock_guard<std::mutex> lock{ s_buffersMutex };
+
+		ThreadBuffer* buffer{};
+		for (const std::unique_ptr<ThreadBuffer>& existing : s_buffers)
+		{
+			if (!existing->isOwned)
+			{
+				buffer = existing.get();
+				break;
+			}
+		}
+
+		if (!buffer)
+		{
+			s_buffers.push_back(std::make_unique<ThreadBuffer>());
+			buffer = s_buffers.back().get();
+			buffer->records.resize(consts::physicsLogRecords);
+
+			const std::uint32_t published{ s_publishedCount.load(std::memory_order_relaxed) };
+			if (published < s_publishedBuffers.size())
+			{
+				s_publishedBuffers[published].store(buffer, std::memory_order_release);
+				s_publishedCount.store(published + 1, std::memory_order_release);
+			}
+		}
+
+		// a reused buffer starts empty, its old records belonged to another thread
+		buffer->written.store(0, std::memory_order_relaxed);
+		buffer->isOwned = true;
+		buffer->threadId.store(s_nextThreadId++, std::memory_order_relaxed);
+		s_threadBuffer.buffer = buffer;
+		return *buffer;
+	}
+
+	// the file layout, written with write(data, size) which returns false on failure
+	// only reads the published buffers and atomics, so the crash handler can use it too
+	template <typename Write>
+	static bool writeBuffers(Write&& write)
+	{
+		const std::uint32_t bufferCount{ s_publishedCount.load(std::memory_order_acquire) };
+
+		FileHeader header{};
+		header.threadCount = bufferCount;
+		if (!write(&header, sizeof(header)))
+			return false;
+
+		for (std::uint32_t bufferIndex{}; bufferIndex < bufferCount; ++bufferIndex)
+		{
+			const ThreadBuffer* const buffer{ s_publishedBuffers[bufferIndex].load(std::memory_order_acquire) };
+
+			// threads that are still running may overwrite the oldest few while
+			// this copies, the rest of the records are whole
+			const std::uint64_t written{ buffer->written.load(std::memory_order_acquire) };
+			const std::uint64_t capacity{ buffer->records.size() };
+			const std::uint64_t first{ (written > capacity) ? written - capacity : 0 };
+
+			const ThreadHeader threadHeader{ buffer->threadId.load(std::memory_order_relaxed), static_cast<std::uint32_t>(written - first) };
+			if (!write(&threadHeader, sizeof(threadHeader)))
+				return false;
+
+			// at most two runs, the end of the buffer and then its start
+			for (std::uint64_t index{ first }; index < written;)
+			{
+				const std::uint64_t offset{ index % capacity };
+				const std::uint64_t runLength{ std::min(written - index, capacity - offset) };
+
+				if (!write(&buffer->records[offset], static_cast<std::size_t>(runLength * sizeof(Record))))
+					return false;
+				index += runLength;
+			}
+		}
+
+		return true;
+	}
+
+	// only calls that are safe in a signal handler from here on
+	static bool writeCrashFile(const void* data, std::size_t size)
+	{
+		const char* bytes{ static_cast<const char*>(data) };
+		while (size > 0)
+		{
+#ifdef _WIN32
+			const int written{ _write(s_crashFile, bytes, static_cast<unsigned int>(std::min<std::size_t>(size, 1u << 30))) };
+#else
+			const ssize_t written{ ::write(s_crashFile, bytes, size) };
+#endif // _WIN32
+			if (written <= 0)
+				return false;
+
+			bytes += written;
+			size -= static_cast<std::size_t>(written);
+		}
+		return true;
+	}
+
+	static void handleCrash(const int signal)
+	{
+		std::signal(signal, SIG_DFL);
+
+		// best effort, the process is going down either way
+		// no locks, a buffer being registered is either all there or not counted yet
+		if (s_crashFile >= 0)
+		{
+			// a dump from F4 may already be in the file
+#ifdef _WIN32
+			const bool isEmpty{ _chsize_s(s_crashFile, 0) == 0 && _lseek(s_crashFile, 0, SEEK_SET) == 0 };
+#else
+			const bool isEmpty{ ftruncate(s_crashFile, 0) == 0 && lseek(s_crashFile, 0, SEEK_SET) == 0 };
+#endif // _WIN32
+			if (isEmpty)
+				writeBuffers(writeCrashFile);
+		}
+
+		std::raise(signal);
+	}
+
+	void enable(const std::string& path, const bool crashDumps)
+	{
+		s_path = path;
+		s_isEnabled.store(true, std::memory_order_relaxed);
+
+		if (crashDumps && s_crashFile < 0)
+		{
+			// opened now but only written on a crash, the file stays as it was until then
+#ifdef _WIN32
+			if (_sopen_s(&s_crashFile, path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0)
+				s_crashFile = -1;
+#else
+			s_crashFile = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+#endif // _WIN32
+			if (s_crashFile < 0)
+			{
+				std::cout << "Could not open " << path << " for physics log crash dumps\n";
+				return;
+			}
+
+			std::signal(SIGSEGV, handleCrash);
+			std::signal(SIGABRT, handleCrash);
+			std::signal(SIGFPE, handleCrash);
+		}
+	}
+
+	void disable()
+	{
+		s_isEnabled.store(false, std::memory_order_relaxed);
+	}
+
+	bool isEnabled()
+	{
+		return s_isEnabled.load(std::memory_order_relaxed);
+	}
+
+	void add(const Record& record)
+	{
+		ThreadBuffer& buffer{ getThreadBuffer() };
+		const std::uint64_t index{ buffer.written.load(std::memory_order_relaxed) };
+
+		buffer.records[index % buffer.records.size()] = record;
+		buffer.written.store(index + 1, std::memory_order_release);
+	}
+
+	bool dump()
+	{
+		return !s_path.empty() && dump(s_path);
+	}
+
+	bool dump(const std::string& path)
+	{
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		if (!file)
+			return false;
+
+		return writeBuffers([&file](const void* data, const std::size_t size) {
+			file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			return static_cast<bool>(file);
+		});
+	}
+
+	bool decode(const std::string& path, std::ostream& out)
+	{
+		std::ifstream file{ path, std::ios::binary };
+
+		FileHeader header{};
+		const FileHeader expected{};
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+			|| std::memcmp(header.magic, expected.magic, sizeof(expected.magic)) != 0
+			|| header.version != expected.version || header.recordSize != expected.recordSize)
+		{
+			return false;
+		}
+
+		out << std::fixed << std::setprecision(2);
+
+		for (std::uint32_t threadIndex{}; threadIndex < header.threadCount; ++threadIndex)
+		{
+			ThreadHeader threadHeader{};
+			if (!file.read(reinterpret_cast<char*>(&threadHeader), sizeof(threadHeader)))
+				return false;
+
+			out << "[Thread " << threadHeader.threadId << "] " << threadHeader.recordCount << " records\n";
+
+			Record record{};
+			for (std::uint32_t recordIndex{}; recordIndex < threadHeader.recordCount; ++recordIndex)
+			{
+				if (!file.read(reinterpret_cast<char*>(&record), sizeof(record)))
+					return false;
+
+				out << record.tick << ' ' << std::left << std::setw(9) << getRecordTypeName(record.type) << std::right
+					<< " ball " << static_cast<int>(record.ballA);
+				if (record.ballB >= 0)
+					out << " with " << static_cast<int>(record.ballB);
+
+				out << " pos " << record.x << ", " << record.y
+					<< " vel " << record.vx << ", " << record.vy
+					<< " value " << record.value << '\n';
+			}
+		}
+
+		out << std::defaultfloat << std::setprecision(6);
+		return true;
+	}
+
+	const char* getRecordTypeName(const RecordType type)
+	{
+		switch (type)
+		{
+		case RecordType::step:
+			return "step";
+		case RecordType::contact:
+			return "contact";
+		case RecordType::resolved:
+			return "resolved";
+		case RecordType::cushion:
+			return "cushion";
+		case RecordType::pocketed:
+			return "pocketed";
+		default:
+			return "unknown";
+		}
+	}
+}
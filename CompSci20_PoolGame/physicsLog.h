@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// what stepPhysics did, one fixed size binary record per event, for debugging
+// collisions without printing from inside the physics
+// - off unless enable() is called, a disabled log is one atomic load per event
+// - every thread records into its own preallocated ring buffer, so only the
+//   most recent physicsLogRecords events of each thread are kept
+// file layout:
+//   FileHeader
+//   per thread: ThreadHeader followed by its records, oldest first
+namespace physicsLog
+{
+	enum class RecordType : std::uint8_t
+	{
+		step, // a moving ball at the start of its tick, value = substeps
+		contact, // ballA overlaps ballB, value = how far
+		resolved, // ballA after a ball collision with ballB was resolved
+		cushion, // ballA after bouncing off the cushions
+		pocketed // ballA went in, value = its speed
+	};
+
+	struct Record
+	{
+		std::uint32_t tick{}; // this thread's stepPhysics calls so far
+		RecordType type{};
+		std::int8_t ballA{ -1 }; // ball numbers, -1 if there isn't one
+		std::int8_t ballB{ -1 };
+		std::uint8_t reserved{};
+		float x{};
+		float y{};
+		float vx{};
+		float vy{};
+		float value{};
+		float reserved2{};
+	};
+
+	static_assert(sizeof(Record) == 32, "physics log records are written to disk as they are");
+
+	struct FileHeader
+	{
+		char magic[8]{ 'P', 'H', 'Y', 'S', 'L', 'O', 'G', '1' };
+		std::uint32_t version{ 1 };
+		std::uint32_t recordSize{ sizeof(Record) };
+		std::uint32_t threadCount{};
+		std::uint32_t reserved{};
+	};
+
+	struct ThreadHeader
+	{
+		std::uint32_t threadId{};
+		std::uint32_t recordCount{};
+	};
+
+	// path is where dumps go, with crashDumps a crash writes there too
+	// crash dumps are best effort, path is opened here and the crash handler only uses write,
+	// it takes no locks, so records other threads are still writing can come out torn
+	void enable(const std::string& path, const bool crashDumps);
+	void disable();
+	bool isEnabled();
+
+	void add(const Record& record);
+
+	// every thread's buffer to the path given to enable, false if it could not be written
+	bool dump();
+	bool dump(const std::string& path);
+	// readable text, one line per record, false if path isn't a physics log
+	bool decode(const std::string& path, std::ostream& out);
+
+	const char* getRecordTypeName(const RecordType type);
+}
@@ -8,7 +8,7 @@
 namespace referee
 {
 	// check if the ball first hit by the cue is valid
-	bool isValidFirstHit(Players::PlayerType& currentPlayer, Ball::BallSuitType hitBallType)
+	bool isValidFirstHit(const Players::PlayerType& currentPlayer, Ball::BallSuitType hitBallType)
 	{
 		// did not hit a ball at all
 		if (hitBallType == Ball::BallSuitType::unknown)
@@ -31,27 +31,21 @@ namespace referee
 		return true;
 	}
 
-	bool isPocketedBallsValid(Players::PlayerType& currentPlayer, Ball::ballsPointer_type pocketedBalls)
+	bool isPocketedBallsValid(Players::PlayerType& currentPlayer, const ballMask_type pocketedBalls)
 	{
 		// can't get a foul if player did not pocket anything
-		if (pocketedBalls.empty())
+		if (!pocketedBalls)
 			return true;
 
-		for (Ball* ball : pocketedBalls)
-		{
-			const Ball::BallSuitType& type{ ball->getBallType() };
-
-			// can't pocket cue ball or pocket the eight ball while not finished
-			if ((type == Ball::BallSuitType::cue) || (currentPlayer.score != 7 && type == Ball::BallSuitType::eight))
-			{
-				return false;
-			}
-		}
+		// can't pocket cue ball
+		if (pocketedBalls & ballMask::cue)
+			return false;
 
+		// once finished only the eight ball on its own, before that never the eight ball
 		if (currentPlayer.score == 7)
-			return pocketedBalls.size() == 1 && pocketedBalls[0]->getBallType() == Ball::BallSuitType::eight;
+			return pocketedBalls == ballMask::eight;
 
-		return true;
+		return !(pocketedBalls & ballMask::eight);
 	}
 
 	bool isTurnValid(Players::PlayerType& turnPlayer, const TurnInformation& turn)
@@ -59,8 +53,71 @@ namespace referee
 		return isValidFirstHit(turnPlayer, turn.firstHitBallType) && isPocketedBallsValid(turnPlayer, turn.pocketedBalls) && !turn.didNoRailFoul;
 	}
 
-	bool isGameFinished(const Ball::balls_type& gameBalls)
+	unsigned int getFouls(const Players::PlayerType& turnPlayer, const TurnInformation& turn)
 	{
-		return !gameBalls[8].isVisible();
+		unsigned int fouls{};
+
+		if (turn.firstHitBallType == Ball::BallSuitType::unknown)
+			fouls |= foulNoBallHit;
+		else if (!isValidFirstHit(turnPlayer, turn.firstHitBallType))
+			fouls |= foulWrongFirstHit;
+
+		// same checks as isPocketedBallsValid, split up by what went wrong
+		if (turn.pocketedBalls & ballMask::cue)
+			fouls |= foulCueBallPocketed;
+
+		// with all suit balls down, anything but the eight on its own is a foul
+		if (turnPlayer.score == 7)
+		{
+			if (turn.pocketedBalls && turn.pocketedBalls != ballMask::eight)
+				fouls |= foulIllegalPocket;
+		}
+		else if (turn.pocketedBalls & ballMask::eight)
+		{
+			fouls |= foulIllegalPocket;
+		}
+
+		if (turn.didNoRailFoul)
+			fouls |= foulNoRail;
+
+		return fouls;
+	}
+
+	std::string_view getFoulName(const unsigned int foul)
+	{
+		switch (foul)
+		{
+		case foulNoBallHit:
+			return "No Ball Hit";
+		case foulWrongFirstHit:
+			return "Wrong First Hit";
+		case foulCueBallPocketed:
+			return "Cue Ball Pocketed";
+		case foulIllegalPocket:
+			return "Illegal Pocket";
+		case foulNoRail:
+			return "No Rail";
+		default:
+			return "Unknown";
+		}
+	}
+
+	bool isGameFinished(const ballMask_type onTable)
+	{
+		return (onTable & ballMask::eight) == 0;
+	}
+
+	int getRemainingBallCount(const ballMask_type onTable, const Ball::BallSuitType type)
+	{
+		return ballMask::getCount(onTable & ballMask::getSuit(type));
+	}
+
+	void addTurnScores(Players& gamePlayers, const TurnInformation& turn)
+	{
+		if (!turn.pocketedBalls || gamePlayers.getCurrentPlayer().targetBallType == Ball::BallSuitType::unknown)
+			return;
+
+		for (Players::PlayerType& player : gamePlayers.getPlayerVector())
+			player.score += ballMask::getCount(turn.pocketedBalls & ballMask::getSuit(player.targetBallType));
 	}
 } // namespace referee
@@ -3,9 +3,27 @@
 #include "common.h"
 #include "Players.h"
 
+#include <string_view>
+
 // namespace for foul detection functions
 namespace referee
 {
+	// bits of getFouls, a turn can break more than one rule
+	inline constexpr unsigned int foulNoBallHit{ 1u << 0 };
+	inline constexpr unsigned int foulWrongFirstHit{ 1u << 1 };
+	inline constexpr unsigned int foulCueBallPocketed{ 1u << 2 };
+	inline constexpr unsigned int foulIllegalPocket{ 1u << 3 }; // the eight too early, or anything but the eight once on it
+	inline constexpr unsigned int foulNoRail{ 1u << 4 };
+	inline constexpr int foulTypeCount{ 5 };
+
+	bool isValidFirstHit(const Players::PlayerType& currentPlayer, Ball::BallSuitType hitBallType);
 	bool isTurnValid(Players::PlayerType& turnPlayer, const TurnInformation& turn);
-	bool isGameFinished(const Ball::balls_type& gameBalls);
+	// which rules the turn broke, 0 if and only if isTurnValid
+	unsigned int getFouls(const Players::PlayerType& turnPlayer, const TurnInformation& turn);
+	std::string_view getFoulName(const unsigned int foul);
+	// onTable is the mask the game keeps with ballMask::getAfterTurn
+	bool isGameFinished(const ballMask_type onTable);
+	int getRemainingBallCount(const ballMask_type onTable, const Ball::BallSuitType type);
+	// every pocketed suit ball counts for the player it belongs to
+	void addTurnScores(Players& gamePlayers, const TurnInformation& turn);
 }
@@ -3,6 +3,13 @@
 #include "constants.h"
 #include "common.h"
 #include "CueStick.h"
+#include "physics.h"
+#include "PlacementMap.h"
+#include "ShotCoach.h"
+#include "ShotPredictor.h"
+#include "SpriteCache.h"
+#include "TrickShotSolver.h"
+#include "trace.h"
 
 #include <allegro5/allegro_primitives.h>
 #include <allegro5/allegro_font.h>
@@ -10,59 +17,111 @@
 #include <iostream>
 #include <string>
 #include <array>
+#include <cmath>
 
 namespace render
 {
-	void drawBalls(const Ball::balls_type& gameBalls, ALLEGRO_FONT* const& gameFont)
+	static ALLEGRO_COLOR getCushionColor()
 	{
-		for (const Ball& ball : gameBalls)
+		return al_map_rgb(181, 101, 29);
+	}
+
+	void drawBall(const int ballNumber, const double x, const double y, const double radius, ALLEGRO_FONT* const& gameFont)
+	{
+		if (ballNumber == 0)
 		{
-			// skip rendering the cue ball and non visible balls
-			if (ball.getBallNumber() == 0 || !ball.isVisible())
-				continue;
+			al_draw_filled_circle(x, y, radius, al_map_rgb(255, 255, 255));
+			al_draw_circle(x, y, radius, al_map_rgb(0, 0, 0), consts::ballBorderThickness);
+			return;
+		}
 
-			const int ballNumber{ ball.getBallNumber() };
-			const Ball::BallSuitType type{ ball.getBallType() };
-			const std::string& ballNumberString{ std::to_string(ballNumber) };
+		const std::string& ballNumberString{ std::to_string(ballNumber) };
 
-			// draw striped balls
-			if (type == Ball::BallSuitType::striped)
-			{
-				// draw the white circle background
-				al_draw_filled_circle(ball.getX(), ball.getY(), ball.getRadius(), al_map_rgb(255, 255, 255));
+		// draw striped balls
+		if (ballNumber > 8)
+		{
+			// draw the white circle background
+			al_draw_filled_circle(x, y, radius, al_map_rgb(255, 255, 255));
 
-				const auto& [red, green, blue] { consts::ballColorMap[ballNumber - 9] };
-				al_draw_filled_circle(ball.getX(), ball.getY(), 11, al_map_rgb(red, green, blue));
-			}
-			else // draw solid balls including eight ball
-			{
-				const auto& [red, green, blue] { consts::ballColorMap[ballNumber - 1] };
-				al_draw_filled_circle(ball.getX(), ball.getY(), ball.getRadius(), al_map_rgb(red, green, blue));
-			}
+			const auto& [red, green, blue] { consts::ballColorMap[ballNumber - 9] };
+			al_draw_filled_circle(x, y, 11, al_map_rgb(red, green, blue));
+		}
+		else // draw solid balls including eight ball
+		{
+			const auto& [red, green, blue] { consts::ballColorMap[ballNumber - 1] };
+			al_draw_filled_circle(x, y, radius, al_map_rgb(red, green, blue));
+		}
 
-			// draw ball border
-			al_draw_circle(ball.getX(), ball.getY(), ball.getRadius(), al_map_rgb(0, 0, 0), consts::ballBorderThickness);
+		// draw ball border
+		al_draw_circle(x, y, radius, al_map_rgb(0, 0, 0), consts::ballBorderThickness);
 
-			// draw single digit numbers
-			if (ballNumber < 10)
-			{
-				al_draw_filled_circle(ball.getX(), ball.getY(), 5, al_map_rgb(255, 255, 255));
-				al_draw_text(gameFont, al_map_rgb(0, 0, 0), ball.getX() - 3, ball.getY() - 4, ALLEGRO_ALIGN_LEFT, ballNumberString.data());
-			}
-			else // draw double digit numbers
-			{
-				al_draw_text(gameFont, al_map_rgb(255, 255, 255), ball.getX() - 7, ball.getY() - 4, ALLEGRO_ALIGN_LEFT, ballNumberString.data());
-			}
+		// draw single digit numbers
+		if (ballNumber < 10)
+		{
+			al_draw_filled_circle(x, y, 5, al_map_rgb(255, 255, 255));
+			al_draw_text(gameFont, al_map_rgb(0, 0, 0), x - 3, y - 4, ALLEGRO_ALIGN_LEFT, ballNumberString.data());
+		}
+		else // draw double digit numbers
+		{
+			al_draw_text(gameFont, al_map_rgb(255, 255, 255), x - 7, y - 4, ALLEGRO_ALIGN_LEFT, ballNumberString.data());
+		}
+	}
+
+	// the cached sprite when there is one for the ball's size, primitives otherwise
+	static void drawBallSprite(const Ball& ball, const SpriteCache::Level* const sprites, ALLEGRO_FONT* const& gameFont)
+	{
+		if (!sprites || !sprites->balls[ball.getBallNumber()] || ball.getRadius() != consts::defaultBallRadius)
+		{
+			drawBall(ball.getBallNumber(), ball.getX(), ball.getY(), ball.getRadius(), gameFont);
+			return;
+		}
+
+		ALLEGRO_BITMAP* const sprite{ sprites->balls[ball.getBallNumber()] };
+		const double halfSize{ SpriteCache::getBallSpriteHalfSize() };
+		const double pixelSize{ static_cast<double>(al_get_bitmap_width(sprite)) };
+
+		al_draw_scaled_bitmap(
+			sprite, 0, 0, pixelSize, pixelSize,
+			ball.getX() - halfSize, ball.getY() - halfSize, pixelSize / sprites->scale, pixelSize / sprites->scale, 0
+		);
+	}
+
+	void drawBalls(const Ball::balls_type& gameBalls, ALLEGRO_FONT* const& gameFont, const SpriteCache& sprites)
+	{
+		const SpriteCache::Level* const level{ sprites.getLevel() };
+
+		for (const Ball& ball : gameBalls)
+		{
+			// skip rendering the cue ball and non visible balls
+			if (ball.getBallNumber() == 0 || !ball.isVisible())
+				continue;
+
+			drawBallSprite(ball, level, gameFont);
 		}
 
 		// handled here to give cue ball a higher z index,
 		// so it appears over the other balls when it is ball in hand
 		const Ball& cueBall{ gameBalls[0] };
 		if (cueBall.isVisible())
+			drawBallSprite(cueBall, level, gameFont);
+	}
+
+	void drawTable(const SpriteCache& sprites)
+	{
+		const SpriteCache::Level* const level{ sprites.getLevel() };
+		if (!level)
 		{
-			al_draw_filled_circle(cueBall.getX(), cueBall.getY(), cueBall.getRadius(), al_map_rgb(255, 255, 255));
-			al_draw_circle(cueBall.getX(), cueBall.getY(), cueBall.getRadius(), al_map_rgb(0, 0, 0), consts::ballBorderThickness);
+			drawPlaysurface();
+			drawPockets();
+			return;
 		}
+
+		// the clear also fills in the letterboxing around the world
+		al_clear_to_color(getCushionColor());
+
+		const double pixelWidth{ static_cast<double>(al_get_bitmap_width(level->table)) };
+		const double pixelHeight{ static_cast<double>(al_get_bitmap_height(level->table)) };
+		al_draw_scaled_bitmap(level->table, 0, 0, pixelWidth, pixelHeight, 0, 0, pixelWidth / level->scale, pixelHeight / level->scale, 0);
 	}
 
 	void drawPockets()
@@ -99,7 +158,7 @@ namespace render
 
 	void drawPlaysurface()
 	{
-		al_clear_to_color(al_map_rgb(181, 101, 29));
+		al_clear_to_color(getCushionColor());
 
 		al_draw_filled_rectangle(
 			consts::playSurface.xPos1,
@@ -110,10 +169,196 @@ namespace render
 		);
 	}
 
+	void drawPlacementMap(const PlacementMap& placementMap)
+	{
+		for (const Rectangle& area : placementMap.getBlockedAreas())
+		{
+			al_draw_filled_rectangle(area.xPos1, area.yPos1, area.xPos2, area.yPos2, al_map_rgba(0, 0, 0, consts::placementShadingAlpha));
+		}
+	}
+
+	void drawAimGuide(const Ball& cueBall, const double angle, const double distance)
+	{
+		const double endX{ cueBall.getX() + std::cos(angle) * distance };
+		const double endY{ cueBall.getY() + std::sin(angle) * distance };
+
+		al_draw_line(cueBall.getX(), cueBall.getY(), endX, endY, al_map_rgba(255, 255, 255, 90), 1);
+		al_draw_circle(endX, endY, cueBall.getRadius(), al_map_rgba(255, 255, 255, 120), 1);
+	}
+
+	void drawTrickShotHint(const TrickShotSolver::Solution& solution, const Ball& cueBall, ALLEGRO_FONT* const& gameFont)
+	{
+		static constexpr double guideLength{ 250.0 };
+
+		const double endX{ cueBall.getX() + std::cos(solution.shot.angle) * guideLength };
+		const double endY{ cueBall.getY() + std::sin(solution.shot.angle) * guideLength };
+
+		al_draw_line(cueBall.getX(), cueBall.getY(), endX, endY, al_map_rgba(255, 255, 0, 160), 1);
+
+		const std::string text{ "Power " + std::to_string(static_cast<int>(solution.shot.power + 0.5)) };
+		al_draw_text(gameFont, al_map_rgb(255, 255, 0), endX, endY - 10, ALLEGRO_ALIGN_CENTRE, text.c_str());
+	}
+
+	void drawShotPrediction(const ShotPredictor::Estimate& estimate, const Ball::balls_type& gameBalls, ALLEGRO_FONT* const& gameFont)
+	{
+		if (estimate.intendedBall < 0)
+			return;
+
+		// highlight the ball that the estimate is for
+		const Ball& target{ gameBalls[estimate.intendedBall] };
+		al_draw_circle(target.getX(), target.getY(), target.getRadius() + 3, al_map_rgb(255, 255, 255), 1);
+
+		// the estimate keeps refining while the mouse rests,
+		// until there are enough samples the difficulty table is shown instead
+		std::string percentageText{ "..." };
+		if (estimate.samples >= consts::predictorMinSamples || (estimate.samples > 0 && estimate.tableEstimate < 0.0f))
+			percentageText = std::to_string(static_cast<int>(estimate.getProbability() * 100.0 + 0.5)) + "%";
+		else if (estimate.tableEstimate >= 0.0f)
+			percentageText = "~" + std::to_string(static_cast<int>(estimate.tableEstimate * 100.0f + 0.5f)) + "%";
+
+		const std::string text{
+			"Pot " + std::to_string(estimate.intendedBall) + ": " + percentageText
+			+ " (" + std::to_string(estimate.samples) + ")"
+		};
+
+		const Ball& cueBall{ gameBalls[0] };
+		al_draw_text(gameFont, al_map_rgb(255, 255, 255), cueBall.getX(), cueBall.getY() + cueBall.getRadius() + 6, ALLEGRO_ALIGN_CENTRE, text.c_str());
+	}
+
+	void drawCoachAdvice(const ShotCoach::Advice& advice, ALLEGRO_FONT* const& gameFont)
+	{
+		static constexpr double guideLength{ 150.0 };
+
+		// the cue ball has rolled on since, so where both shots were taken from is marked
+		const Vector2& start{ advice.cueBallPosition };
+		al_draw_circle(start.getX(), start.getY(), consts::defaultBallRadius, al_map_rgba(160, 160, 160, 120), 1);
+		al_draw_line(
+			start.getX(), start.getY(),
+			start.getX() + std::cos(advice.playedShot.angle) * guideLength, start.getY() + std::sin(advice.playedShot.angle) * guideLength,
+			al_map_rgba(160, 160, 160, 120), 1
+		);
+		al_draw_line(
+			start.getX(), start.getY(),
+			start.getX() + std::cos(advice.bestShot.angle) * guideLength, start.getY() + std::sin(advice.bestShot.angle) * guideLength,
+			al_map_rgba(0, 255, 255, 160), 1
+		);
+
+		const auto describe{ [](const simulation::ShotOutcome& outcome) {
+			return std::string{ outcome.didFoul ? "foul, " : "" } + "potted " + std::to_string(outcome.ownBallsPocketed);
+		} };
+
+		const std::string text{
+			"Coach: you " + describe(advice.playedOutcome) + ", best was " + describe(advice.bestOutcome)
+			+ " at power " + std::to_string(static_cast<int>(advice.bestShot.power + 0.5))
+			+ " (" + std::to_string(advice.candidatesTried) + " shots tried)"
+		};
+
+		al_draw_text(gameFont, al_map_rgb(0, 255, 255), consts::worldWidth / 2, consts::playSurface.yPos2 + 14, ALLEGRO_ALIGN_CENTRE, text.c_str());
+	}
+
+	void drawRewindStatus(const int tick, const int shotTicks, ALLEGRO_FONT* const& gameFont)
+	{
+		const double barY{ consts::playSurface.yPos2 + 10.0 };
+		const double barLength{ static_cast<double>(consts::playSurface.xPos2 - consts::playSurface.xPos1) };
+		const double progress{ (shotTicks > 0) ? static_cast<double>(tick) / shotTicks : 1.0 };
+
+		al_draw_line(consts::playSurface.xPos1, barY, consts::playSurface.xPos2, barY, al_map_rgba(255, 255, 255, 80), 2);
+		al_draw_line(consts::playSurface.xPos1, barY, consts::playSurface.xPos1 + barLength * progress, barY, al_map_rgb(255, 255, 255), 2);
+
+		const std::string text{
+			"Review: tick " + std::to_string(tick) + " / " + std::to_string(shotTicks) + " (left/right to scrub, R to return)"
+		};
+
+		al_draw_text(gameFont, al_map_rgb(255, 255, 255), consts::worldWidth / 2, barY + 6, ALLEGRO_ALIGN_CENTRE, text.c_str());
+	}
+
+	void drawPhysicsCounters(const physics::StepCounters& tick, const physics::StepCounters& shot, ALLEGRO_FONT* const& gameFont)
+	{
+		const std::string tickText{
+			"Tick: " + std::to_string(tick.substeps) + " substeps, " + std::to_string(tick.pairTests) + " pair tests, "
+			+ std::to_string(tick.overlapsResolved) + " overlaps, " + std::to_string(tick.boundaryHits) + " cushions, "
+			+ std::to_string(tick.pocketChecks) + " pocket checks, " + std::to_string(tick.ballsAwake) + " awake"
+		};
+		const std::string shotText{
+			"Shot: " + std::to_string(shot.ticks) + " ticks, " + std::to_string(shot.substeps) + " substeps, "
+			+ std::to_string(shot.pairTests) + " pair tests, " + std::to_string(shot.overlapsResolved) + " overlaps, "
+			+ std::to_string(shot.boundaryHits) + " cushions"
+		};
+
+		al_draw_text(gameFont, al_map_rgb(255, 255, 255), consts::playSurface.xPos1 + 30, 4, ALLEGRO_ALIGN_LEFT, tickText.c_str());
+		al_draw_text(gameFont, al_map_rgb(255, 255, 255), consts::playSurface.xPos1 + 30, 20, ALLEGRO_ALIGN_LEFT, shotText.c_str());
+	}
+
+	void drawPhysicsOverlay(const Ball::balls_type& gameBalls, ALLEGRO_FONT* const& gameFont)
+	{
+		static constexpr double velocityScale{ 4.0 }; // pixels drawn per pixel per tick
+		static constexpr double contactSlop{ 0.5 }; // resolved balls end up just touching
+
+		// a ball whose centre gets inside one of these drops
+		for (const auto& [xCoord, yCoord] : consts::pocketCoordinates)
+		{
+			al_draw_circle(xCoord, yCoord, consts::pocketRadius - consts::pocketSensitivity + consts::defaultBallRadius, al_map_rgba(255, 140, 0, 160), 1);
+		}
+
+		const std::size_t ballCount{ gameBalls.size() };
+		for (std::size_t index{}; index < ballCount; ++index)
+		{
+			const Ball& ball{ gameBalls[index] };
+			if (!ball.isVisible())
+				continue;
+
+			const double x{ ball.getX() };
+			const double y{ ball.getY() };
+			const double vx{ ball.getVX() };
+			const double vy{ ball.getVY() };
+			const double radius{ ball.getRadius() };
+			const double speed{ calculateHypotenuse(vx, vy) };
+
+			for (std::size_t otherIndex{ index + 1 }; otherIndex < ballCount; ++otherIndex)
+			{
+				const Ball& otherBall{ gameBalls[otherIndex] };
+				if (!otherBall.isVisible())
+					continue;
+
+				const double deltaX{ otherBall.getX() - x };
+				const double deltaY{ otherBall.getY() - y };
+				const double distance{ calculateHypotenuse(deltaX, deltaY) };
+				const double touchDistance{ radius + otherBall.getRadius() };
+
+				// close enough that one of them could reach the other this tick
+				const double reach{ touchDistance + speed + otherBall.getVelocityVector().getLength() };
+				if (distance > reach || distance <= 0.0)
+					continue;
+
+				al_draw_line(x, y, otherBall.getX(), otherBall.getY(), al_map_rgba(255, 255, 255, 50), 1);
+
+				if (distance <= touchDistance + contactSlop)
+				{
+					// from the contact point along the line between the centres
+					const double normalX{ deltaX / distance };
+					const double normalY{ deltaY / distance };
+					const double contactX{ x + normalX * radius };
+					const double contactY{ y + normalY * radius };
+
+					al_draw_line(contactX - normalX * 12, contactY - normalY * 12, contactX + normalX * 12, contactY + normalY * 12, al_map_rgb(255, 60, 60), 2);
+				}
+			}
+
+			// stepPhysics moves a ball in steps no longer than its radius
+			const int substeps{ static_cast<int>(std::ceil((std::abs(vx) + std::abs(vy)) / radius)) };
+			if (substeps == 0)
+				continue;
+
+			al_draw_line(x, y, x + vx * velocityScale, y + vy * velocityScale, al_map_rgb(0, 220, 255), 2);
+			al_draw_text(gameFont, al_map_rgb(0, 220, 255), x, y - radius - 14, ALLEGRO_ALIGN_CENTRE, std::to_string(substeps).c_str());
+		}
+	}
+
 	// lol...it just makes the code more informative
 	// much more sense to say renderDrawings than flip_display
 	void renderDrawings()
 	{
+		const trace::Scope traceScope{ "al_flip_display" };
 		al_flip_display();
 	}
 }
@@ -2,14 +2,41 @@
 
 #include "Ball.h"
 #include "CueStick.h"
+#include "physics.h"
+#include "PlacementMap.h"
+#include "ShotCoach.h"
+#include "ShotPredictor.h"
+#include "SpriteCache.h"
+#include "TrickShotSolver.h"
 
 #include <allegro5/allegro_font.h>
 
 namespace render
 {
-	void drawBalls(const Ball::balls_type& gameBalls, ALLEGRO_FONT* const& gameFont);
+	// one ball with primitives, centred on x, y, this is also what the sprites are made from
+	void drawBall(const int ballNumber, const double x, const double y, const double radius, ALLEGRO_FONT* const& gameFont);
+	void drawBalls(const Ball::balls_type& gameBalls, ALLEGRO_FONT* const& gameFont, const SpriteCache& sprites);
+	// the cached table layer, or the play surface and pockets if there isn't one
+	void drawTable(const SpriteCache& sprites);
 	void drawPockets();
 	void drawCueStick(CueStick stick);
 	void drawPlaysurface();
+	// darkens everywhere the cue ball can't be placed
+	void drawPlacementMap(const PlacementMap& placementMap);
+	// a line from the cue ball to a ghost ball where it would first touch something
+	void drawAimGuide(const Ball& cueBall, const double angle, const double distance);
+	void drawTrickShotHint(const TrickShotSolver::Solution& solution, const Ball& cueBall, ALLEGRO_FONT* const& gameFont);
+	void drawShotPrediction(const ShotPredictor::Estimate& estimate, const Ball::balls_type& gameBalls, ALLEGRO_FONT* const& gameFont);
+	// the last shot and the best one the coach found, both from where the cue ball was
+	void drawCoachAdvice(const ShotCoach::Advice& advice, ALLEGRO_FONT* const& gameFont);
+	// where the shot review is, along the bottom cushion
+	void drawRewindStatus(const int tick, const int shotTicks, ALLEGRO_FONT* const& gameFont);
+	// last tick and current shot, along the top cushion
+	void drawPhysicsCounters(const physics::StepCounters& tick, const physics::StepCounters& shot, ALLEGRO_FONT* const& gameFont);
+	// what the next stepPhysics tick will work with, worked out from the balls
+	// so the physics itself records nothing for it:
+	// velocities, substeps per ball, pairs that can touch this tick,
+	// contact normals of touching balls and where ball centres drop into pockets
+	void drawPhysicsOverlay(const Ball::balls_type& gameBalls, ALLEGRO_FONT* const& gameFont);
 	void renderDrawings();
 }
@@ -0,0 +1,356 @@
+#include "simulation.h"
+
+#include "Ball.h"
+#include "Players.h"
+#include "common.h"
+#include "constants.h"
+#include "metrics.h"
+#include "physics.h"
+#include "referee.h"
+#include "ShotDataset.h"
+#include "Vector2.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace simulation
+{
+	// read by every simulating thread, set once by whoever starts recording
+	static std::atomic<ShotDatasetWriter*> shotRecorder{};
+
+	void setShotRecorder(ShotDatasetWriter* recorder)
+	{
+		shotRecorder = recorder;
+	}
+
+	ShotDatasetWriter* getShotRecorder()
+	{
+		return shotRecorder;
+	}
+
+	void createBalls(Ball::balls_type& gameBalls, const int ballCount, const double ballRadius, const double ballMass)
+	{
+		gameBalls.resize(ballCount);
+		for (int i{}; i < ballCount; ++i)
+		{
+			Ball& ball{ gameBalls[i] };
+			ball.setRadius(ballRadius);
+			ball.setMass(ballMass);
+			ball.setBallNumber(i);
+			ball.setVisible(true);
+		}
+	}
+
+	// the shuffled balls go in rack order, skipping the spots every rack has the same
+	static void placeRack(Ball::balls_type& gameBalls, const std::vector<int>& ballIndexes)
+	{
+		int ballIndex{};
+
+		for (int rackIndex{ 1 }; rackIndex < consts::rackBallPositions.size(); ++rackIndex)
+		{
+			if (rackIndex == 8 || rackIndex == 11 || rackIndex == 5)
+			{
+				++rackIndex;
+			}
+			gameBalls[ballIndexes[ballIndex]].setPosition(consts::rackBallPositions[rackIndex][0], consts::rackBallPositions[rackIndex][1]);
+			++ballIndex;
+		}
+
+		// cue and eight ball have constant rack position
+		gameBalls[0].setPosition(consts::rackBallPositions[0][0], consts::rackBallPositions[0][1]);
+		gameBalls[8].setPosition(consts::rackBallPositions[8][0], consts::rackBallPositions[8][1]);
+
+		// back corners of rack should be of balls from different suits
+		gameBalls[5].setPosition(consts::rackBallPositions[5][0], consts::rackBallPositions[5][1]);
+		gameBalls[11].setPosition(consts::rackBallPositions[11][0], consts::rackBallPositions[11][1]);
+	}
+
+	void setupRack(Ball::balls_type& gameBalls)
+	{
+		// not static, tournaments rack tables on several threads at once
+		std::vector<int> ballIndexes{ 1, 2, 3, 4, 6, 7, 9, 10, 12, 13, 14, 15 };
+
+		intArrayFisherYatesShuffle(ballIndexes);
+		placeRack(gameBalls, ballIndexes);
+	}
+
+	void setupRack(Ball::balls_type& gameBalls, std::mt19937& randomEngine)
+	{
+		std::vector<int> ballIndexes{ 1, 2, 3, 4, 6, 7, 9, 10, 12, 13, 14, 15 };
+
+		intArrayFisherYatesShuffle(ballIndexes, randomEngine);
+		placeRack(gameBalls, ballIndexes);
+	}
+
+	void applyShot(Ball::balls_type& gameBalls, const ShotParameters& shot)
+	{
+		gameBalls[0].setVelocity(std::cos(shot.angle) * shot.power, std::sin(shot.angle) * shot.power);
+	}
+
+	int runUntilRest(Ball::balls_type& gameBalls, Players& gamePlayers, TurnInformation& turn)
+	{
+		const std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+
+		int ticks{};
+		while (ticks < consts::maxSimulationTicks)
+		{
+			physics::stepPhysics(gameBalls, gamePlayers, turn);
+			++ticks;
+
+			if (!physics::areBallsMoving(gameBalls))
+				break;
+		}
+
+		metrics::recordShot(ticks, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		return ticks;
+	}
+
+	double getNearestPocketDistance(const double xPos, const double yPos)
+	{
+		double nearest{ std::numeric_limits<double>::max() };
+		for (const auto& [pocketX, pocketY] : consts::pocketCoordinates)
+		{
+			const double distance{ calculateHypotenuse(xPos - pocketX, yPos - pocketY) };
+			if (distance < nearest)
+				nearest = distance;
+		}
+		return nearest;
+	}
+
+	int getNearestPocketIndex(const double xPos, const double yPos)
+	{
+		int nearestIndex{};
+		double nearest{ std::numeric_limits<double>::max() };
+		for (int i{}; i < static_cast<int>(consts::pocketCoordinates.size()); ++i)
+		{
+			const auto& [pocketX, pocketY] { consts::pocketCoordinates[i] };
+			const double distance{ calculateHypotenuse(xPos - pocketX, yPos - pocketY) };
+			if (distance < nearest)
+			{
+				nearest = distance;
+				nearestIndex = i;
+			}
+		}
+		return nearestIndex;
+	}
+
+	bool isTargetBall(const Ball::BallSuitType ballType, const Ball::BallSuitType targetType)
+	{
+		// before the suits are assigned, every suit ball is a target
+		if (targetType == Ball::BallSuitType::unknown)
+			return ballType == Ball::BallSuitType::solid || ballType == Ball::BallSuitType::striped;
+
+		return ballType == targetType;
+	}
+
+	ballMask_type getTargetMask(const Ball::BallSuitType targetType)
+	{
+		// same as isTargetBall, for every ball at once
+		if (targetType == Ball::BallSuitType::unknown)
+			return ballMask::solids | ballMask::stripes;
+
+		return ballMask::getSuit(targetType);
+	}
+
+	double scoreOutcome(const ShotOutcome& outcome)
+	{
+		// the game is decided, nothing else matters
+		if (outcome.eightBallPocketed)
+			return outcome.didFoul ? -100.0 : 100.0;
+
+		double score{ outcome.didFoul ? -5.0 : 0.0 };
+		score += 2.0 * outcome.ownBallsPocketed - outcome.opponentBallsPocketed;
+
+		// tie breaker, prefer leaving our balls close to the pockets
+		score -= outcome.averagePocketDistance / consts::worldWidth;
+
+		return score;
+	}
+
+	ShotOutcome simulateShot(const Ball::balls_type& gameBalls, const Players& gamePlayers, const ShotParameters& shot)
+	{
+		Ball::balls_type restingBalls;
+		return simulateShot(gameBalls, gamePlayers, shot, restingBalls);
+	}
+
+	ShotOutcome simulateShot(const Ball::balls_type& gameBalls, const Players& gamePlayers, const ShotParameters& shot, Ball::balls_type& restingBalls)
+	{
+		Ball::balls_type& balls{ restingBalls };
+		balls = gameBalls;
+		Players players{ gamePlayers };
+		TurnInformation turn{};
+
+		applyShot(balls, shot);
+
+		ShotOutcome outcome{};
+		outcome.ticks = runUntilRest(balls, players, turn);
+		outcome.firstHitBallType = turn.firstHitBallType;
+		outcome.firstHitBallNumber = turn.firstHitBallNumber;
+		outcome.didFoul = !referee::isTurnValid(players.getCurrentPlayer(), turn);
+
+		// the shot may have assigned the suits, so read the target afterwards
+		const Ball::BallSuitType targetType{ players.getCurrentPlayer().targetBallType };
+
+		const ballMask_type targetMask{ getTargetMask(targetType) };
+		outcome.pocketedMask = turn.pocketedBalls;
+		outcome.cueBallPocketed = (turn.pocketedBalls & ballMask::cue) != 0;
+		outcome.eightBallPocketed = (turn.pocketedBalls & ballMask::eight) != 0;
+		outcome.ownBallsPocketed = ballMask::getCount(turn.pocketedBalls & targetMask);
+		outcome.opponentBallsPocketed = ballMask::getCount(turn.pocketedBalls & (ballMask::solids | ballMask::stripes) & ~targetMask);
+
+		int remainingTargets{};
+		for (const Ball& ball : balls)
+		{
+			if (ball.isVisible() && isTargetBall(ball.getBallType(), targetType))
+			{
+				outcome.averagePocketDistance += getNearestPocketDistance(ball.getX(), ball.getY());
+				++remainingTargets;
+			}
+		}
+
+		if (remainingTargets > 0)
+			outcome.averagePocketDistance /= remainingTargets;
+
+		outcome.score = scoreOutcome(outcome);
+
+		ShotDatasetWriter* const recorder{ shotRecorder };
+		if (recorder && recorder->isRecording(shotDataset::Source::simulated))
+		{
+			shotDataset::Row row{ shotDataset::makeRow(gameBalls, balls, players.getCurrentPlayer(), shot, turn, outcome.ticks) };
+			row.source = shotDataset::Source::simulated;
+			recorder->append(row);
+		}
+
+		return outcome;
+	}
+
+	int findFirstBallOnPath(const Ball::balls_type& gameBalls, const double angle)
+	{
+		double distance;
+		return findFirstBallOnPath(gameBalls, angle, distance);
+	}
+
+	int findFirstBallOnPath(const Ball::balls_type& gameBalls, const double angle, double& travelDistance)
+	{
+		const Ball& cueBall{ gameBalls[0] };
+		const Vector2 direction{ std::cos(angle), std::sin(angle) };
+
+		int firstBall{ -1 };
+		double firstDistance{ std::numeric_limits<double>::max() };
+
+		for (int i{ 1 }; i < static_cast<int>(gameBalls.size()); ++i)
+		{
+			const Ball& ball{ gameBalls[i] };
+			if (!ball.isVisible())
+				continue;
+
+			// solve |cue + direction * t - ball| = r1 + r2 for the smallest positive t
+			const Vector2 toBall{ ball.getPositionVector().copyAndSubtract(cueBall.getPositionVector()) };
+			const double radiusLength{ ball.getRadius() + cueBall.getRadius() };
+			const double along{ toBall.getDotProduct(direction) };
+			const double discriminant{ along * along - toBall.getDotProduct(toBall) + radiusLength * radiusLength };
+
+			if (along <= 0.0 || discriminant < 0.0)
+				continue;
+
+			const double distance{ along - std::sqrt(discriminant) };
+			if (distance < firstDistance)
+			{
+				firstDistance = distance;
+				firstBall = i;
+			}
+		}
+
+		travelDistance = firstDistance;
+		return firstBall;
+	}
+
+	bool getCutShotGeometry(const Ball::balls_type& gameBalls, const double angle, CutShotGeometry& geometry)
+	{
+		double travelDistance;
+		const int objectBall{ findFirstBallOnPath(gameBalls, angle, travelDistance) };
+		if (objectBall < 0)
+			return false;
+
+		const Vector2 direction{ std::cos(angle), std::sin(angle) };
+		const Vector2 contactPosition{ gameBalls[0].getPositionVector().copyAndAdd(direction.copyAndMultiply(travelDistance)) };
+		const Vector2 objectPosition{ gameBalls[objectBall].getPositionVector() };
+
+		// the object ball leaves along the line between the centres
+		const Vector2 objectDirection{ objectPosition.copyAndSubtract(contactPosition).getNormalized() };
+
+		// the pocket best lined up with where the object ball is going
+		double bestAlignment{ -2.0 };
+		for (int i{}; i < static_cast<int>(consts::pocketCoordinates.size()); ++i)
+		{
+			const Vector2 pocket(consts::pocketCoordinates[i][0], consts::pocketCoordinates[i][1]);
+			const double alignment{ pocket.copyAndSubtract(objectPosition).getNormalized().getDotProduct(objectDirection) };
+			if (alignment > bestAlignment)
+			{
+				bestAlignment = alignment;
+				geometry.pocketIndex = i;
+			}
+		}
+
+		const Vector2 pocket(consts::pocketCoordinates[geometry.pocketIndex][0], consts::pocketCoordinates[geometry.pocketIndex][1]);
+
+		geometry.objectBall = objectBall;
+		geometry.cutAngle = std::acos(std::clamp(direction.getDotProduct(objectDirection), -1.0, 1.0));
+		geometry.pocketDistance = pocket.copyAndSubtract(objectPosition).getLength();
+		geometry.cueDistance = travelDistance;
+		return true;
+	}
+
+	bool isPointNearPath(const Vector2& point, const Vector2& start, const Vector2& end, const double distance)
+	{
+		const Vector2 path{ end.copyAndSubtract(start) };
+		const double pathLengthSquared{ path.getDotProduct(path) };
+
+		// closest point on the path to the point
+		const Vector2 toPoint{ point.copyAndSubtract(start) };
+		double along{ (pathLengthSquared > 0.0) ? toPoint.getDotProduct(path) / pathLengthSquared : 0.0 };
+		along = (along < 0.0) ? 0.0 : ((along > 1.0) ? 1.0 : along);
+
+		const Vector2 offset{ toPoint.copyAndSubtract(path.copyAndMultiply(along)) };
+		return offset.getDotProduct(offset) < distance * distance;
+	}
+
+	bool isPathClear(const Ball::balls_type& gameBalls, const Vector2& start, const Vector2& end, const unsigned int ignoredMask)
+	{
+		for (const Ball& ball : gameBalls)
+		{
+			if (!ball.isVisible() || (ignoredMask & (1u << ball.getBallNumber())))
+				continue;
+
+			if (isPointNearPath(ball.getPositionVector(), start, end, 2.0 * ball.getRadius()))
+				return false;
+		}
+
+		return true;
+	}
+
+	std::vector<ShotParameters> generateCandidateShots(const int angleCount, const int powerLevels)
+	{
+		static constexpr double pi{ 3.14159265358979323846 };
+
+		std::vector<ShotParameters> candidates;
+		candidates.reserve(static_cast<std::size_t>(angleCount) * powerLevels);
+
+		for (int angleIndex{}; angleIndex < angleCount; ++angleIndex)
+		{
+			const double angle{ 2.0 * pi * angleIndex / angleCount };
+			for (int powerIndex{ 1 }; powerIndex <= powerLevels; ++powerIndex)
+			{
+				candidates.push_back({ angle, static_cast<double>(consts::cueStickMaxPower) * powerIndex / powerLevels });
+			}
+		}
+
+		return candidates;
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Ball.h"
+#include "Players.h"
+#include "common.h"
+#include "Vector2.h"
+
+#include <random>
+#include <vector>
+
+class ShotDatasetWriter;
+
+// namespace for running shots without a display, input, or audio
+// (used by the shot evaluator and anything else that needs to "look ahead")
+namespace simulation
+{
+	struct ShotParameters
+	{
+		double angle{}; // radians, direction the cue ball travels
+		double power{}; // same scale as the cue stick power
+	};
+
+	// everything we need to know about a shot after the balls stop,
+	// stored by value so it does not point into a copied ball vector
+	struct ShotOutcome
+	{
+		Ball::BallSuitType firstHitBallType{};
+		int firstHitBallNumber{ -1 };
+		ballMask_type pocketedMask{};
+		int ownBallsPocketed{};
+		int opponentBallsPocketed{};
+		bool cueBallPocketed{};
+		bool eightBallPocketed{};
+		bool didFoul{};
+		int ticks{};
+		double averagePocketDistance{}; // of the shooter's balls left on the table
+		double score{};
+	};
+
+	// table setup, shared by the game and the headless tools
+	void createBalls(Ball::balls_type& gameBalls, const int ballCount, const double ballRadius, const double ballMass);
+	void setupRack(Ball::balls_type& gameBalls);
+	// racks from the engine instead of rand, rand is per thread on msvc and every thread would get the same racks
+	void setupRack(Ball::balls_type& gameBalls, std::mt19937& randomEngine);
+
+	void applyShot(Ball::balls_type& gameBalls, const ShotParameters& shot);
+
+	// steps the physics until every ball stops (or the tick limit is hit)
+	// returns the number of ticks that were simulated
+	int runUntilRest(Ball::balls_type& gameBalls, Players& gamePlayers, TurnInformation& turn);
+
+	// when set, every simulated shot is also written to the dataset
+	void setShotRecorder(ShotDatasetWriter* recorder);
+	ShotDatasetWriter* getShotRecorder();
+
+	// simulates the shot on copies of the balls and players
+	ShotOutcome simulateShot(const Ball::balls_type& gameBalls, const Players& gamePlayers, const ShotParameters& shot);
+	// same as above, but also hands back the table after the shot
+	ShotOutcome simulateShot(const Ball::balls_type& gameBalls, const Players& gamePlayers, const ShotParameters& shot, Ball::balls_type& restingBalls);
+
+	// how good the shot is for the player who took it, higher = better
+	double scoreOutcome(const ShotOutcome& outcome);
+
+	double getNearestPocketDistance(const double xPos, const double yPos);
+	int getNearestPocketIndex(const double xPos, const double yPos);
+	bool isTargetBall(const Ball::BallSuitType ballType, const Ball::BallSuitType targetType);
+	ballMask_type getTargetMask(const Ball::BallSuitType targetType);
+
+	// returns the index of the first ball the cue ball would hit
+	// travelling at angle, or -1 if it would not hit anything
+	int findFirstBallOnPath(const Ball::balls_type& gameBalls, const double angle);
+	// travelDistance is how far the cue ball rolls before the contact
+	int findFirstBallOnPath(const Ball::balls_type& gameBalls, const double angle, double& travelDistance);
+
+	// the parameters the difficulty tables are indexed by, for the ball
+	// the aim hits and the pocket the object ball is sent closest to
+	struct CutShotGeometry
+	{
+		int objectBall{ -1 };
+		int pocketIndex{ -1 };
+		double cutAngle{}; // radians, 0 = straight in
+		double pocketDistance{}; // object ball centre to pocket centre
+		double cueDistance{}; // cue ball travel to the ghost ball
+	};
+
+	bool getCutShotGeometry(const Ball::balls_type& gameBalls, const double angle, CutShotGeometry& geometry);
+
+	// true if point is within distance of the segment from start to end
+	bool isPointNearPath(const Vector2& point, const Vector2& start, const Vector2& end, const double distance);
+
+	// true if a ball could roll from start to end without touching
+	// any visible ball, ignoredMask bits are ball numbers to skip
+	bool isPathClear(const Ball::balls_type& gameBalls, const Vector2& start, const Vector2& end, const unsigned int ignoredMask);
+
+	// sweeps angleCount directions at powerLevels evenly spaced powers
+	std::vector<ShotParameters> generateCandidateShots(const int angleCount, const int powerLevels);
+}
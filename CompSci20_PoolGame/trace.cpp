@@ -0,0 +1,215 @@
+#include "trace.h"
+
+#include "constants.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace trace
+{
+	struct Event
+	{
+		const char* name{};
+		std::int64_t nanoseconds{}; // since tracing started
+		std::uint32_t threadId{};
+		char type{}; // 'B' or 'E'
+	};
+
+	// only its own thread writes, the index is published after the event so a
+	// reader never sees a half written one (unless it laps, see endSession)
+	struct ThreadBuffer
+	{
+		std::vector<Event> events;
+		std::atomic<std::uint64_t> written{};
+		std::uint64_t read{};
+		std::uint32_t threadId{};
+		bool isOwned{};
+	};
+
+	static std::atomic<bool> s_isEnabled{};
+	static std::chrono::steady_clock::time_point s_startTime{};
+	static std::string s_path;
+	static int s_sessionCount{};
+
+	// buffers of finished threads are handed to new ones, so thread pools
+	// and std::async don't keep adding buffers
+	static std::mutex s_buffersMutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> s_buffers;
+	static std::uint32_t s_nextThreadId{ 1 };
+
+	struct BufferHandle
+	{
+		ThreadBuffer* buffer{};
+
+		~BufferHandle()
+		{
+			if (!buffer)
+				return;
+
+			std::lock_guard<std::mutex> lock{ s_buffersMutex };
+			buffer->isOwned = false;
+		}
+	};
+
+	static thread_local BufferHandle s_threadBuffer{};
+
+	static ThreadBuffer& getThreadBuffer()
+	{
+		if (s_threadBuffer.buffer)
+			return *s_threadBuffer.buffer;
+
+		std::lock_guard<std::mutex> lock{ s_buffersMutex };
+
+		const auto unowned{ std::find_if(s_buffers.begin(), s_buffers.end(), [](const std::unique_ptr<ThreadBuffer>& buffer) {
+			return !buffer->isOwned;
+		}) };
+
+		ThreadBuffer* buffer{};
+		if (unowned != s_buffers.end())
+		{
+			buffer = unowned->get();
+		}
+		else
+		{
+			s_buffers.push_back(std::make_unique<ThreadBuffer>());
+			buffer = s_buffers.back().get();
+			buffer->events.resize(consts::traceBufferEvents);
+		}
+
+		buffer->isOwned = true;
+		buffer->threadId = s_nextThreadId++;
+		s_threadBuffer.buffer = buffer;
+		return *buffer;
+	}
+
+	static void addEvent(const char* name, const char type)
+	{
+		ThreadBuffer& buffer{ getThreadBuffer() };
+		const std::uint64_t index{ buffer.written.load(std::memory_order_relaxed) };
+
+		Event& event{ buffer.events[index % buffer.events.size()] };
+		event.name = name;
+		event.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_startTime).count();
+		event.threadId = buffer.threadId;
+		event.type = type;
+
+		buffer.written.store(index + 1, std::memory_order_release);
+	}
+
+	void start(const std::string& path)
+	{
+		s_path = path;
+		s_startTime = std::chrono::steady_clock::now();
+		s_isEnabled.store(true, std::memory_order_relaxed);
+	}
+
+	bool isEnabled()
+	{
+		return s_isEnabled.load(std::memory_order_relaxed);
+	}
+
+	void begin(const char* name)
+	{
+		if (isEnabled())
+			addEvent(name, 'B');
+	}
+
+	void end(const char* name)
+	{
+		if (isEnabled())
+			addEvent(name, 'E');
+	}
+
+	Scope::Scope(const char* name)
+	{
+		if (!isEnabled())
+			return;
+
+		m_name = name;
+		addEvent(name, 'B');
+	}
+
+	Scope::~Scope()
+	{
+		// ended even if tracing was turned off in between, so it stays balanced
+		if (m_name)
+			addEvent(m_name, 'E');
+	}
+
+	static std::string getSessionPath(const int session)
+	{
+		const std::filesystem::path path{ s_path };
+		return (path.parent_path() / (path.stem().string() + "_" + std::to_string(session) + path.extension().string())).string();
+	}
+
+	bool endSession()
+	{
+		if (!isEnabled())
+			return false;
+
+		const std::string path{ getSessionPath(++s_sessionCount) };
+		std::ofstream file{ path, std::ios::trunc };
+		if (!file)
+		{
+			std::cout << "Could not write trace " << path << '\n';
+			return false;
+		}
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		file << std::fixed << std::setprecision(3);
+
+		std::size_t eventCount{};
+		std::lock_guard<std::mutex> lock{ s_buffersMutex };
+
+		for (const std::unique_ptr<ThreadBuffer>& buffer : s_buffers)
+		{
+			// the oldest events of a full buffer are the ones being overwritten,
+			// a few are left out so a thread still tracing doesn't lap the reader
+			const std::uint64_t written{ buffer->written.load(std::memory_order_acquire) };
+			const std::uint64_t capacity{ buffer->events.size() - consts::traceBufferEvents / 16 };
+			const std::uint64_t first{ std::max(buffer->read, (written > capacity) ? written - capacity : 0) };
+
+			// an end whose begin was overwritten or read last session has nothing to close
+			std::unordered_map<std::uint32_t, int> depths;
+
+			for (std::uint64_t index{ first }; index < written; ++index)
+			{
+				const Event& event{ buffer->events[index % buffer->events.size()] };
+				int& depth{ depths[event.threadId] };
+
+				if (event.type == 'E')
+				{
+					if (depth == 0)
+						continue;
+					--depth;
+				}
+				else
+				{
+					++depth;
+				}
+
+				file << ((eventCount++ > 0) ? ",\n" : "")
+					<< "{\"name\":\"" << event.name << "\",\"ph\":\"" << event.type
+					<< "\",\"ts\":" << event.nanoseconds / 1000.0
+					<< ",\"pid\":1,\"tid\":" << event.threadId << '}';
+			}
+
+			buffer->read = written;
+		}
+
+		file << "\n]}\n";
+		std::cout << "[Trace] " << eventCount << " events written to " << path << "\n\n";
+		return static_cast<bool>(file);
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+// begin and end events of the main loop phases, written as chrome trace json
+// for looking at stalls in perfetto (ui.perfetto.dev) or chrome://tracing
+// - off unless start() is called, a disabled scope is one atomic load
+// - every thread writes into its own fixed size ring buffer, so nothing locks
+//   while tracing and a long session only keeps its most recent events
+namespace trace
+{
+	// path is where sessions are written, "trace.json" becomes trace_1.json, trace_2.json, ...
+	void start(const std::string& path);
+	bool isEnabled();
+
+	// name has to outlive the session, string literals are what this is for
+	void begin(const char* name);
+	void end(const char* name);
+
+	// begin now, end when it goes out of scope
+	class Scope
+	{
+	private:
+		const char* m_name{};
+
+	public:
+		explicit Scope(const char* name);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	// writes every thread's events since the last session and clears them,
+	// false if tracing is off or the file could not be written
+	bool endSession();
+}
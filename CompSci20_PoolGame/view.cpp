@@ -0,0 +1,45 @@
+#include "view.h"
+
+#include "constants.h"
+#include "Vector2.h"
+
+#include <allegro5/allegro5.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace view
+{
+	Transform fit(const int displayWidth, const int displayHeight)
+	{
+		Transform transform{};
+		transform.scale = std::min(static_cast<double>(displayWidth) / consts::worldWidth, static_cast<double>(displayHeight) / consts::worldHeight);
+
+		// a minimized window can report zero
+		if (transform.scale <= 0.0)
+			transform.scale = 1.0;
+
+		transform.offsetX = (displayWidth - consts::worldWidth * transform.scale) / 2.0;
+		transform.offsetY = (displayHeight - consts::worldHeight * transform.scale) / 2.0;
+		return transform;
+	}
+
+	double getScaleLevel(const double scale)
+	{
+		return std::max(std::round(scale / consts::viewScaleStep), 1.0) * consts::viewScaleStep;
+	}
+
+	Vector2 toWorld(const Transform& transform, const double pixelX, const double pixelY)
+	{
+		return { (pixelX - transform.offsetX) / transform.scale, (pixelY - transform.offsetY) / transform.scale };
+	}
+
+	void use(const Transform& transform)
+	{
+		ALLEGRO_TRANSFORM allegroTransform;
+		al_identity_transform(&allegroTransform);
+		al_scale_transform(&allegroTransform, static_cast<float>(transform.scale), static_cast<float>(transform.scale));
+		al_translate_transform(&allegroTransform, static_cast<float>(transform.offsetX), static_cast<float>(transform.offsetY));
+		al_use_transform(&allegroTransform);
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Vector2.h"
+
+// maps world units to display pixels
+// the whole world always fits in the display with its shape kept,
+// whatever is left over on the long side is split evenly either side of it
+namespace view
+{
+	struct Transform
+	{
+		double scale{ 1.0 }; // pixels per world unit
+		double offsetX{}; // pixels
+		double offsetY{};
+	};
+
+	Transform fit(const int displayWidth, const int displayHeight);
+	// the nearest multiple of viewScaleStep, never below one step
+	double getScaleLevel(const double scale);
+
+	Vector2 toWorld(const Transform& transform, const double pixelX, const double pixelY);
+	// everything drawn to the current target bitmap from now on is in world units
+	void use(const Transform& transform);
+}